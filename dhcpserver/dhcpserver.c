@@ -35,6 +35,7 @@
 #include "cyw43_config.h"
 #include "dhcpserver.h"
 #include "lwip/udp.h"
+#include "lwip/timeouts.h"
 
 #define DHCPDISCOVER    (1)
 #define DHCPOFFER       (2)
@@ -63,8 +64,6 @@
 #define PORT_DHCP_SERVER (67)
 #define PORT_DHCP_CLIENT (68)
 
-#define DEFAULT_LEASE_TIME_S (24 * 60 * 60) // in seconds
-
 #define MAC_LEN (6)
 #define MAKE_IP4(a, b, c, d) ((a) << 24 | (b) << 16 | (c) << 8 | (d))
 
@@ -86,6 +85,154 @@ typedef struct {
     uint8_t options[312]; // optional parameters, variable, starts with magic
 } dhcp_msg_t;
 
+// Lease table bookkeeping. Every lease sits in exactly one index list: the
+// free list (oldest-freed last, so a returning client's cached IP survives
+// as long as possible) or the timer-wheel slot of its expiry tick. A MAC hash
+// finds a client's lease without scanning; the wheel expires leases one slot
+// per tick instead of checking the whole table on every packet.
+
+enum {
+    DHCPS_LEASE_FREE,
+    DHCPS_LEASE_OFFERED,
+    DHCPS_LEASE_BOUND,
+    DHCPS_LEASE_DECLINED, // in use by someone else on the link: no MAC, not offered
+};
+
+#define DHCPS_FREE_LIST (DHCPS_WHEEL_SLOTS)
+#define DHCPS_TICKS(s) (((s) + DHCPS_WHEEL_TICK_S - 1) / DHCPS_WHEEL_TICK_S)
+
+static uint32_t mac_hash(const uint8_t *mac) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (int i = 0; i < MAC_LEN; ++i) {
+        h = (h ^ mac[i]) * 16777619u;
+    }
+    return h & (DHCPS_HASH_SIZE - 1);
+}
+
+static void list_unlink(dhcp_server_t *d, uint8_t list, uint8_t i) {
+    dhcp_server_lease_t *l = &d->lease[i];
+    if (l->prev != DHCPS_NIL) {
+        d->lease[l->prev].next = l->next;
+    } else {
+        d->list[list] = l->next;
+    }
+    if (l->next != DHCPS_NIL) {
+        d->lease[l->next].prev = l->prev;
+    } else if (list == DHCPS_FREE_LIST) {
+        d->free_tail = l->prev;
+    }
+    l->prev = l->next = DHCPS_NIL;
+}
+
+// Push at the head of a wheel slot (order does not matter there)
+static void list_push(dhcp_server_t *d, uint8_t list, uint8_t i) {
+    dhcp_server_lease_t *l = &d->lease[i];
+    l->prev = DHCPS_NIL;
+    l->next = d->list[list];
+    if (l->next != DHCPS_NIL) {
+        d->lease[l->next].prev = i;
+    }
+    d->list[list] = i;
+}
+
+static void free_list_append(dhcp_server_t *d, uint8_t i) {
+    dhcp_server_lease_t *l = &d->lease[i];
+    l->prev = d->free_tail;
+    l->next = DHCPS_NIL;
+    if (d->free_tail != DHCPS_NIL) {
+        d->lease[d->free_tail].next = i;
+    } else {
+        d->list[DHCPS_FREE_LIST] = i;
+    }
+    d->free_tail = i;
+}
+
+static uint8_t lease_list(const dhcp_server_t *d, uint8_t i) {
+    const dhcp_server_lease_t *l = &d->lease[i];
+    return l->state == DHCPS_LEASE_FREE ? DHCPS_FREE_LIST : l->expiry % DHCPS_WHEEL_SLOTS;
+}
+
+static int lease_find(const dhcp_server_t *d, const uint8_t *mac) {
+    for (uint8_t i = d->bucket[mac_hash(mac)]; i != DHCPS_NIL; i = d->lease[i].hnext) {
+        if (memcmp(d->lease[i].mac, mac, MAC_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void hash_remove(dhcp_server_t *d, uint8_t i) {
+    uint8_t *pp = &d->bucket[mac_hash(d->lease[i].mac)];
+    while (*pp != DHCPS_NIL && *pp != i) {
+        pp = &d->lease[*pp].hnext;
+    }
+    if (*pp == i) {
+        *pp = d->lease[i].hnext;
+    }
+    d->lease[i].hnext = DHCPS_NIL;
+}
+
+static void hash_insert(dhcp_server_t *d, uint8_t i) {
+    uint8_t *b = &d->bucket[mac_hash(d->lease[i].mac)];
+    d->lease[i].hnext = *b;
+    *b = i;
+}
+
+// Hand lease i (currently free) to mac, dropping any MAC cached in it
+static void lease_claim(dhcp_server_t *d, uint8_t i, const uint8_t *mac) {
+    dhcp_server_lease_t *l = &d->lease[i];
+    list_unlink(d, DHCPS_FREE_LIST, i);
+    if (memcmp(l->mac, mac, MAC_LEN) != 0) {
+        if (memcmp(l->mac, "\x00\x00\x00\x00\x00\x00", MAC_LEN) != 0) {
+            hash_remove(d, i);
+        }
+        memcpy(l->mac, mac, MAC_LEN);
+        hash_insert(d, i);
+    }
+}
+
+// (Re)arm the expiry of a lease that is not free
+static void lease_schedule(dhcp_server_t *d, uint8_t i, uint8_t state, uint32_t secs) {
+    dhcp_server_lease_t *l = &d->lease[i];
+    if (l->state != DHCPS_LEASE_FREE) {
+        list_unlink(d, lease_list(d, i), i);
+    }
+    l->state = state;
+    l->expiry = d->tick + DHCPS_TICKS(secs);
+    list_push(d, lease_list(d, i), i);
+}
+
+static void lease_free(dhcp_server_t *d, uint8_t i) {
+    list_unlink(d, lease_list(d, i), i);
+    d->lease[i].state = DHCPS_LEASE_FREE;
+    free_list_append(d, i);
+}
+
+static void dhcp_wheel_tick(void *arg) {
+    dhcp_server_t *d = arg;
+    d->tick++;
+    uint8_t slot = d->tick % DHCPS_WHEEL_SLOTS;
+    for (uint8_t i = d->list[slot], next; i != DHCPS_NIL; i = next) {
+        next = d->lease[i].next;
+        if ((int32_t)(d->lease[i].expiry - d->tick) <= 0) {
+            lease_free(d, i);
+        }
+    }
+    sys_timeout(DHCPS_WHEEL_TICK_S * 1000, dhcp_wheel_tick, d);
+}
+
+static void leases_init(dhcp_server_t *d) {
+    memset(d->lease, 0, sizeof(d->lease));
+    memset(d->bucket, DHCPS_NIL, sizeof(d->bucket));
+    memset(d->list, DHCPS_NIL, sizeof(d->list));
+    d->free_tail = DHCPS_NIL;
+    d->tick = 0;
+    for (int i = 0; i < DHCPS_MAX_IP; ++i) {
+        d->lease[i].hnext = DHCPS_NIL;
+        free_list_append(d, i);
+    }
+}
+
 static int dhcp_socket_new_dgram(struct udp_pcb **udp, void *cb_data, udp_recv_fn cb_udp_recv) {
     // family is AF_INET
     // type is SOCK_DGRAM
@@ -213,30 +360,20 @@ static void dhcp_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p,
 
     switch (msgtype[2]) {
         case DHCPDISCOVER: {
-            int yi = DHCPS_MAX_IP;
-            for (int i = 0; i < DHCPS_MAX_IP; ++i) {
-                if (memcmp(d->lease[i].mac, dhcp_msg.chaddr, MAC_LEN) == 0) {
-                    // MAC match, use this IP address
-                    yi = i;
-                    break;
-                }
-                if (yi == DHCPS_MAX_IP) {
-                    // Look for a free IP address
-                    if (memcmp(d->lease[i].mac, "\x00\x00\x00\x00\x00\x00", MAC_LEN) == 0) {
-                        // IP available
-                        yi = i;
-                    }
-                    uint32_t expiry = d->lease[i].expiry << 16 | 0xffff;
-                    if ((int32_t)(expiry - cyw43_hal_ticks_ms()) < 0) {
-                        // IP expired, reuse it
-                        memset(d->lease[i].mac, 0, MAC_LEN);
-                        yi = i;
-                    }
+            // Known MAC keeps its address (even a cached, expired one); else oldest free
+            int yi = lease_find(d, dhcp_msg.chaddr);
+            if (yi < 0) {
+                yi = d->list[DHCPS_FREE_LIST];
+                if (yi == DHCPS_NIL) {
+                    // No more IP addresses left
+                    goto ignore_request;
                 }
             }
-            if (yi == DHCPS_MAX_IP) {
-                // No more IP addresses left
-                goto ignore_request;
+            if (d->lease[yi].state != DHCPS_LEASE_BOUND) {
+                if (d->lease[yi].state == DHCPS_LEASE_FREE) {
+                    lease_claim(d, yi, dhcp_msg.chaddr);
+                }
+                lease_schedule(d, yi, DHCPS_LEASE_OFFERED, DHCPS_OFFER_TIME_S);
             }
             dhcp_msg.yiaddr[3] = DHCPS_BASE_IP + yi;
             opt_write_u8(&opt, DHCP_OPT_MSG_TYPE, DHCPOFFER);
@@ -244,31 +381,45 @@ static void dhcp_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p,
         }
 
         case DHCPREQUEST: {
-            uint8_t *o = opt_find(opt, DHCP_OPT_REQUESTED_IP);
-            if (o == NULL) {
-                // Should be NACK
+            uint8_t *o = opt_find(opt, DHCP_OPT_SERVER_ID);
+            if (o != NULL && memcmp(o + 2, &ip4_addr_get_u32(ip_2_ip4(&d->ip)), 4) != 0) {
+                // Client selected another server; our offer just expires
                 goto ignore_request;
             }
-            if (memcmp(o + 2, &ip4_addr_get_u32(ip_2_ip4(&d->ip)), 3) != 0) {
-                // Should be NACK
-                goto ignore_request;
+            // SELECTING/INIT-REBOOT send the address as an option, RENEWING in ciaddr
+            const uint8_t *req_ip;
+            o = opt_find(opt, DHCP_OPT_REQUESTED_IP);
+            if (o != NULL) {
+                req_ip = o + 2;
+            } else if (memcmp(dhcp_msg.ciaddr, "\x00\x00\x00\x00", 4) != 0) {
+                req_ip = dhcp_msg.ciaddr;
+            } else {
+                goto nak;
             }
-            uint8_t yi = o[5] - DHCPS_BASE_IP;
-            if (yi >= DHCPS_MAX_IP) {
-                // Should be NACK
-                goto ignore_request;
+            if (memcmp(req_ip, &ip4_addr_get_u32(ip_2_ip4(&d->ip)), 3) != 0) {
+                goto nak;
+            }
+            uint8_t yi = req_ip[3] - DHCPS_BASE_IP;
+            if (req_ip[3] < DHCPS_BASE_IP || yi >= DHCPS_MAX_IP) {
+                goto nak;
             }
-            if (memcmp(d->lease[yi].mac, dhcp_msg.chaddr, MAC_LEN) == 0) {
+            int cur = lease_find(d, dhcp_msg.chaddr);
+            if (cur == yi) {
                 // MAC match, ok to use this IP address
-            } else if (memcmp(d->lease[yi].mac, "\x00\x00\x00\x00\x00\x00", MAC_LEN) == 0) {
-                // IP unused, ok to use this IP address
-                memcpy(d->lease[yi].mac, dhcp_msg.chaddr, MAC_LEN);
+                if (d->lease[yi].state == DHCPS_LEASE_FREE) {
+                    lease_claim(d, yi, dhcp_msg.chaddr);
+                }
+            } else if (d->lease[yi].state == DHCPS_LEASE_FREE) {
+                // IP unused, ok to use this IP address; drop whatever we held for this MAC
+                if (cur >= 0 && d->lease[cur].state != DHCPS_LEASE_FREE) {
+                    lease_free(d, cur);
+                }
+                lease_claim(d, yi, dhcp_msg.chaddr);
             } else {
                 // IP already in use
-                // Should be NACK
-                goto ignore_request;
+                goto nak;
             }
-            d->lease[yi].expiry = (cyw43_hal_ticks_ms() + DEFAULT_LEASE_TIME_S * 1000) >> 16;
+            lease_schedule(d, yi, DHCPS_LEASE_BOUND, DHCPS_LEASE_TIME_S);
             dhcp_msg.yiaddr[3] = DHCPS_BASE_IP + yi;
             opt_write_u8(&opt, DHCP_OPT_MSG_TYPE, DHCPACK);
             printf("DHCPS: client connected: MAC=%02x:%02x:%02x:%02x:%02x:%02x IP=%u.%u.%u.%u\n",
@@ -277,6 +428,31 @@ static void dhcp_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p,
             break;
         }
 
+        case DHCPDECLINE: {
+            // Client found the address in use: forget its MAC (so the next DISCOVER
+            // gets another address) and keep the address out of the pool for a while
+            int yi = lease_find(d, dhcp_msg.chaddr);
+            uint8_t *o = opt_find(opt, DHCP_OPT_REQUESTED_IP);
+            if (yi < 0 || d->lease[yi].state == DHCPS_LEASE_FREE || o == NULL
+                || memcmp(o + 2, &ip4_addr_get_u32(ip_2_ip4(&d->ip)), 3) != 0
+                || o[5] != DHCPS_BASE_IP + yi) {
+                goto ignore_request;
+            }
+            hash_remove(d, yi);
+            memset(d->lease[yi].mac, 0, MAC_LEN);
+            lease_schedule(d, yi, DHCPS_LEASE_DECLINED, DHCPS_DECLINE_TIME_S);
+            goto ignore_request;
+        }
+
+        case DHCPRELEASE: {
+            // Address given back: free it now, keep the MAC cached
+            int yi = lease_find(d, dhcp_msg.chaddr);
+            if (yi >= 0 && d->lease[yi].state != DHCPS_LEASE_FREE) {
+                lease_free(d, yi);
+            }
+            goto ignore_request;
+        }
+
         default:
             goto ignore_request;
     }
@@ -285,7 +461,16 @@ static void dhcp_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p,
     opt_write_n(&opt, DHCP_OPT_SUBNET_MASK, 4, &ip4_addr_get_u32(ip_2_ip4(&d->nm)));
     opt_write_n(&opt, DHCP_OPT_ROUTER, 4, &ip4_addr_get_u32(ip_2_ip4(&d->ip))); // aka gateway; can have multiple addresses
     opt_write_n(&opt, DHCP_OPT_DNS, 4, &ip4_addr_get_u32(ip_2_ip4(&d->ip))); // this server is the dns
-    opt_write_u32(&opt, DHCP_OPT_IP_LEASE_TIME, DEFAULT_LEASE_TIME_S);
+    opt_write_u32(&opt, DHCP_OPT_IP_LEASE_TIME, DHCPS_LEASE_TIME_S);
+    goto send;
+
+nak:
+    // Wrong subnet, outside the pool or taken: make the client restart at DISCOVER
+    memset(dhcp_msg.yiaddr, 0, 4);
+    opt_write_u8(&opt, DHCP_OPT_MSG_TYPE, DHCPNACK);
+    opt_write_n(&opt, DHCP_OPT_SERVER_ID, 4, &ip4_addr_get_u32(ip_2_ip4(&d->ip)));
+
+send:
     *opt++ = DHCP_OPT_END;
     struct netif *nif = ip_current_input_netif();
     dhcp_socket_sendto(&d->udp, nif, &dhcp_msg, opt - (uint8_t *)&dhcp_msg, 0xffffffff, PORT_DHCP_CLIENT);
@@ -297,13 +482,15 @@ ignore_request:
 void dhcp_server_init(dhcp_server_t *d, ip_addr_t *ip, ip_addr_t *nm) {
     ip_addr_copy(d->ip, *ip);
     ip_addr_copy(d->nm, *nm);
-    memset(d->lease, 0, sizeof(d->lease));
+    leases_init(d);
     if (dhcp_socket_new_dgram(&d->udp, d, dhcp_server_process) != 0) {
         return;
     }
     dhcp_socket_bind(&d->udp, PORT_DHCP_SERVER);
+    sys_timeout(DHCPS_WHEEL_TICK_S * 1000, dhcp_wheel_tick, d);
 }
 
 void dhcp_server_deinit(dhcp_server_t *d) {
+    sys_untimeout(dhcp_wheel_tick, d);
     dhcp_socket_free(&d->udp);
-}
\ No newline at end of file
+}
@@ -28,18 +28,50 @@
 
 #include "lwip/ip_addr.h"
 
+// Pool: DHCPS_BASE_IP .. DHCPS_BASE_IP + DHCPS_MAX_IP - 1 in the server's /24.
+// All of these can be overridden at build time.
+#ifndef DHCPS_BASE_IP
 #define DHCPS_BASE_IP (16)
-#define DHCPS_MAX_IP (8)
+#endif
+#ifndef DHCPS_MAX_IP
+#define DHCPS_MAX_IP (64)
+#endif
+#ifndef DHCPS_LEASE_TIME_S
+#define DHCPS_LEASE_TIME_S (20 * 60) // short: survey phones come and go
+#endif
+#ifndef DHCPS_OFFER_TIME_S
+#define DHCPS_OFFER_TIME_S (30) // an OFFER reserves its address this long
+#endif
+#ifndef DHCPS_DECLINE_TIME_S
+#define DHCPS_DECLINE_TIME_S (DHCPS_OFFER_TIME_S) // a DECLINEd address stays out of the pool this long
+#endif
+
+#define DHCPS_HASH_SIZE (64) // MAC -> lease buckets, power of two
+#define DHCPS_WHEEL_SLOTS (64) // expiry timer wheel
+#define DHCPS_WHEEL_TICK_S (5) // wheel resolution; one revolution = 320 s
+
+#if DHCPS_BASE_IP < 2 || DHCPS_BASE_IP + DHCPS_MAX_IP > 255
+#error "DHCP pool must fit in the /24 (host part 2..254)"
+#endif
+
+#define DHCPS_NIL (0xff) // end of an index list
 
 typedef struct _dhcp_server_lease_t {
-    uint8_t mac[6];
-    uint16_t expiry;
+    uint8_t mac[6]; // kept after expiry so a returning client gets its old IP
+    uint8_t state; // DHCPS_LEASE_*
+    uint8_t hnext; // next lease in the same hash bucket
+    uint8_t prev, next; // position in a wheel slot or in the free list
+    uint32_t expiry; // absolute wheel tick
 } dhcp_server_lease_t;
 
 typedef struct _dhcp_server_t {
     ip_addr_t ip;
     ip_addr_t nm;
     dhcp_server_lease_t lease[DHCPS_MAX_IP];
+    uint8_t bucket[DHCPS_HASH_SIZE]; // head of each MAC hash chain
+    uint8_t list[DHCPS_WHEEL_SLOTS + 1]; // wheel slot heads; last one is the free list
+    uint8_t free_tail;
+    uint32_t tick; // wheel time, advances every DHCPS_WHEEL_TICK_S
     struct udp_pcb *udp;
 } dhcp_server_t;
 
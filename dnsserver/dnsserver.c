@@ -30,6 +30,9 @@
  
  #define MAX_DNS_MSG_SIZE 300
  
+ #define DNS_QTYPE_A   1
+ #define DNS_QTYPE_ANY 255
+ 
  static int dns_socket_new_dgram(struct udp_pcb **udp, void *cb_data, udp_recv_fn cb_udp_recv) {
      *udp = udp_new();
      if (*udp == NULL) {
@@ -176,36 +179,48 @@
          goto ignore_request;
      }
  
-     // Skip QNAME and QTYPE
+     // QTYPE and QCLASS must be present, plus room for our 16 byte answer
+     if (question_ptr + 4 > question_ptr_end || question_ptr + 4 + 16 > dns_msg + sizeof(dns_msg)) {
+         DEBUG_printf("Truncated question\n");
+         goto ignore_request;
+     }
+     uint16_t qtype = question_ptr[0] << 8 | question_ptr[1];
      question_ptr += 4;
  
-     // Generate answer
+     // Only A (or ANY) gets our address. Everything else (AAAA, HTTPS, ...) gets
+     // an empty NOERROR reply so the client falls back to IPv4 straight away
+     // instead of waiting for a timeout.
+     uint16_t answer_count = 0;
      uint8_t *answer_ptr = dns_msg + (question_ptr - dns_msg);
-     *answer_ptr++ = 0xc0; // pointer
-     *answer_ptr++ = question_ptr_start - dns_msg; // pointer to question
-     
-     *answer_ptr++ = 0;
-     *answer_ptr++ = 1; // host address
- 
-     *answer_ptr++ = 0;
-     *answer_ptr++ = 1; // Internet class
- 
-     *answer_ptr++ = 0;
-     *answer_ptr++ = 0;
-     *answer_ptr++ = 0;
-     *answer_ptr++ = 60; // ttl 60s
- 
-     *answer_ptr++ = 0;
-     *answer_ptr++ = 4; // length
-     memcpy(answer_ptr, &d->ip.addr, 4); // use our address
-     answer_ptr += 4;
+     if (qtype == DNS_QTYPE_A || qtype == DNS_QTYPE_ANY) {
+         *answer_ptr++ = 0xc0; // pointer
+         *answer_ptr++ = question_ptr_start - dns_msg; // pointer to question
+ 
+         *answer_ptr++ = 0;
+         *answer_ptr++ = 1; // host address
+ 
+         *answer_ptr++ = 0;
+         *answer_ptr++ = 1; // Internet class
+ 
+         *answer_ptr++ = 0;
+         *answer_ptr++ = 0;
+         *answer_ptr++ = 0;
+         *answer_ptr++ = 60; // ttl 60s
+ 
+         *answer_ptr++ = 0;
+         *answer_ptr++ = 4; // length
+         memcpy(answer_ptr, &d->ip.addr, 4); // use our address
+         answer_ptr += 4;
+         answer_count = 1;
+     }
  
      dns_hdr->flags = lwip_htons(
                  0x1 << 15 | // QR = response
                  0x1 << 10 | // AA = authoritative
+                 (flags & (0x1 << 8)) | // RD copied from the query
                  0x1 << 7);   // RA = authenticated
      dns_hdr->question_count = lwip_htons(1);
-     dns_hdr->answer_record_count = lwip_htons(1);
+     dns_hdr->answer_record_count = lwip_htons(answer_count);
      dns_hdr->authority_record_count = 0;
      dns_hdr->additional_record_count = 0;
  
@@ -0,0 +1,251 @@
+// Classificador das pulseiras no host: cor_classify (limiares fixos) contra o
+// calibrado (cor_calib.c: Mahalanobis inteiro), sobre host/cor_corpus.csv.
+// Para cada luz, calibra com as leituras "cal" daquela luz (como o modo de
+// calibração do main.c) e classifica as "teste"; mostra acerto, rejeição
+// e troca por outra pulseira, quanto de "outro_*" cada um aceitaria como
+// pulseira, e ns por classificação. Depois, a votação do ST_COLOR_LOOP
+// (cor_vote.c) sobre as mesmas leituras em sequência: quantas integrações e
+// quantos ms até confirmar, e quanto confirma errado, contra uma leitura só
+// (o antigo "aproxime e pressione A").
+//
+//   cmake --build build-host --target cor_bench && build-host/cor_bench [corpus.csv]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cor.h"
+#include "cor_calib.h"
+#include "cor_vote.h"
+
+// cor.c/i2c_bus.c no host: sem sensor, o barramento só falha (o bench não o usa)
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us) {
+    (void)i2c; (void)addr; (void)src; (void)len; (void)nostop; (void)timeout_us;
+    return PICO_ERROR_GENERIC;
+}
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us) {
+    (void)i2c; (void)addr; (void)dst; (void)len; (void)nostop; (void)timeout_us;
+    return PICO_ERROR_GENERIC;
+}
+
+#define MAX_ROWS   8192
+#define MAX_LIGHTS 16
+
+typedef struct {
+    char     luz[24], rotulo[24];
+    bool     cal;
+    uint16_t c, r, g, b;
+    uint8_t  gain;
+    uint16_t integ_ms;
+    cor_class_t want;              // COR_DESCONHECIDA para outro_*
+} row_t;
+
+static row_t s_rows[MAX_ROWS];
+static int   s_nrows;
+
+static cor_class_t label_class(const char *s) {
+    if (!strcmp(s, "verde"))    return COR_VERDE;
+    if (!strcmp(s, "amarelo"))  return COR_AMARELO;
+    if (!strcmp(s, "vermelho")) return COR_VERMELHO;
+    return COR_DESCONHECIDA;
+}
+
+static bool is_band(cor_class_t c) {
+    return c == COR_VERDE || c == COR_AMARELO || c == COR_VERMELHO;
+}
+
+static bool load(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[256];
+    while (fgets(line, sizeof line, f) && s_nrows < MAX_ROWS) {
+        if (line[0] == '#' || !strncmp(line, "luz,", 4)) continue;
+        row_t *w = &s_rows[s_nrows];
+        char fase[16];
+        unsigned c, r, g, b, gain, ms;
+        if (sscanf(line, "%23[^,],%15[^,],%23[^,],%u,%u,%u,%u,%u,%u",
+                   w->luz, fase, w->rotulo, &c, &r, &g, &b, &gain, &ms) != 9) continue;
+        w->cal = !strcmp(fase, "cal");
+        w->c = (uint16_t)c; w->r = (uint16_t)r; w->g = (uint16_t)g; w->b = (uint16_t)b;
+        w->gain = (uint8_t)gain; w->integ_ms = (uint16_t)ms;
+        w->want = label_class(w->rotulo);
+        s_nrows++;
+    }
+    fclose(f);
+    return s_nrows > 0;
+}
+
+// O que o cor_poll entrega ao cor_classify: r/c, g/c, b/c e o clear na
+// exposição de referência (16x, 43 ciclos)
+static cor_class_t heuristic(const row_t *w) {
+    float cf = w->c < 1 ? 1.f : (float)w->c;
+    uint32_t cycles = (w->integ_ms * 5u + 6u) / 12u;
+    float c_ref = (float)w->c * (16.f * 43.f) / ((float)w->gain * (float)cycles);
+    return cor_classify(w->r / cf, w->g / cf, w->b / cf, c_ref);
+}
+
+typedef struct { int n, ok, rej, wrong, other_n, other_acc; } score_t;
+
+static void score(score_t *s, const row_t *w, cor_class_t got) {
+    if (w->want == COR_DESCONHECIDA) {
+        s->other_n++;
+        if (is_band(got)) s->other_acc++;
+        return;
+    }
+    s->n++;
+    if (got == w->want) s->ok++;
+    else if (is_band(got)) s->wrong++;
+    else s->rej++;
+}
+
+static void print_score(const char *luz, const char *who, const score_t *s) {
+    printf("%-15s %-11s %5.1f%% %7.1f%% %7.1f%%   %5.1f%% (%d)\n", luz, who,
+           100.0 * s->ok / (s->n ? s->n : 1), 100.0 * s->rej / (s->n ? s->n : 1),
+           100.0 * s->wrong / (s->n ? s->n : 1),
+           100.0 * s->other_acc / (s->other_n ? s->other_n : 1), s->other_n);
+}
+
+static bool calibrate(const char *luz, cor_profile_t *p) {
+    static const cor_class_t bands[] = { COR_VERDE, COR_AMARELO, COR_VERMELHO };
+    cor_profile_init(p);
+    for (size_t k = 0; k < sizeof bands / sizeof bands[0]; k++) {
+        cor_cal_acc_t a;
+        cor_cal_acc_reset(&a);
+        for (int i = 0; i < s_nrows && a.n < COR_CAL_SAMPLES; i++) {
+            const row_t *w = &s_rows[i];
+            if (w->cal && w->want == bands[k] && !strcmp(w->luz, luz)) cor_cal_acc_add(&a, w->r, w->g, w->b);
+        }
+        cor_centroid_t c;
+        if (!cor_cal_acc_finish(&a, bands[k], &c) || !cor_profile_add(p, &c)) return false;
+    }
+    cor_profile_seal(p);
+    return cor_profile_valid(p);
+}
+
+// Votação: para cada pulseira (e outro_*) de uma luz, uma tentativa a partir
+// de cada leitura "teste", seguindo em ordem (dando a volta) até confirmar ou
+// esgotar as leituras. Os portões de luz/delta-C do main.c não entram: no
+// corpus a pulseira está sempre na frente do sensor.
+typedef struct { int n, ok, wrong, none, other_n, other_acc; long reads, ms; } vote_t;
+
+static void vote_light(vote_t *v, const char *luz, cor_class_t (*cls)(const row_t *, const void *), const void *ctx) {
+    static const char *labels[24];
+    int nlab = 0;
+    for (int i = 0; i < s_nrows; i++) {
+        const row_t *w = &s_rows[i];
+        if (w->cal || strcmp(w->luz, luz)) continue;
+        int k = 0;
+        while (k < nlab && strcmp(labels[k], w->rotulo)) k++;
+        if (k == nlab && nlab < 24) labels[nlab++] = w->rotulo;
+    }
+    static int idx[MAX_ROWS];
+    for (int l = 0; l < nlab; l++) {
+        int n = 0;
+        for (int i = 0; i < s_nrows; i++)
+            if (!s_rows[i].cal && !strcmp(s_rows[i].luz, luz) && !strcmp(s_rows[i].rotulo, labels[l])) idx[n++] = i;
+        for (int start = 0; start < n; start++) {
+            cor_vote_t vt;
+            cor_vote_reset(&vt);
+            cor_class_t got = COR_DESCONHECIDA;
+            long ms = 0;
+            int k = 0;
+            while (k < n && got == COR_DESCONHECIDA) {
+                const row_t *w = &s_rows[idx[(start + k++) % n]];
+                ms += w->integ_ms;
+                got = cor_vote_push(&vt, cls(w, ctx));
+            }
+            cor_class_t want = s_rows[idx[0]].want;
+            if (want == COR_DESCONHECIDA) {
+                v->other_n++;
+                if (is_band(got)) v->other_acc++;
+                continue;
+            }
+            v->n++;
+            if (got == want) { v->ok++; v->reads += k; v->ms += ms; }
+            else if (is_band(got)) v->wrong++;
+            else v->none++;
+        }
+    }
+}
+
+static cor_class_t vote_heuristic(const row_t *w, const void *ctx) { (void)ctx; return heuristic(w); }
+static cor_class_t vote_calib(const row_t *w, const void *ctx) {
+    return cor_cal_classify(ctx, w->r, w->g, w->b, NULL);
+}
+
+static void print_vote(const char *who, const vote_t *v) {
+    int ok = v->ok ? v->ok : 1;
+    printf("%-15s %-11s %7.1f%% %8.1f%% %7.1f%% %7.1f%% %9.1f %7.0f ms\n", "", who,
+           100.0 * v->ok / (v->n ? v->n : 1), 100.0 * v->none / (v->n ? v->n : 1),
+           100.0 * v->wrong / (v->n ? v->n : 1), 100.0 * v->other_acc / (v->other_n ? v->other_n : 1),
+           (double)v->reads / ok, (double)v->ms / ok);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : COR_CORPUS;
+    if (!load(path)) return 1;
+
+    const char *lights[MAX_LIGHTS];
+    int nl = 0;
+    for (int i = 0; i < s_nrows; i++) {
+        int k = 0;
+        while (k < nl && strcmp(lights[k], s_rows[i].luz)) k++;
+        if (k == nl && nl < MAX_LIGHTS) lights[nl++] = s_rows[i].luz;
+    }
+
+    printf("%d leituras de %s\n\n", s_nrows, path);
+    printf("%-15s %-11s %6s %8s %8s   %s\n", "luz", "", "acerto", "rejeita", "troca", "outro aceito");
+    score_t th = {0}, tc = {0};
+    cor_profile_t prof[MAX_LIGHTS];
+    for (int l = 0; l < nl; l++) {
+        if (!calibrate(lights[l], &prof[l])) { printf("%s: sem leituras de calibração\n", lights[l]); return 1; }
+        score_t h = {0}, c = {0};
+        for (int i = 0; i < s_nrows; i++) {
+            const row_t *w = &s_rows[i];
+            if (w->cal || strcmp(w->luz, lights[l])) continue;
+            score(&h, w, heuristic(w));
+            score(&c, w, cor_cal_classify(&prof[l], w->r, w->g, w->b, NULL));
+        }
+        print_score(lights[l], "limiares", &h);
+        print_score("", "calibrado", &c);
+        th.n += h.n; th.ok += h.ok; th.rej += h.rej; th.wrong += h.wrong; th.other_n += h.other_n; th.other_acc += h.other_acc;
+        tc.n += c.n; tc.ok += c.ok; tc.rej += c.rej; tc.wrong += c.wrong; tc.other_n += c.other_n; tc.other_acc += c.other_acc;
+    }
+    printf("\n");
+    print_score("total", "limiares", &th);
+    print_score("", "calibrado", &tc);
+
+    // Votação: a "troca" acima é o que uma leitura só confirmaria errado
+    printf("\nvotação %d de %d (até confirmar: leituras e tempo de integração)\n", COR_VOTE_N, COR_VOTE_M);
+    printf("%-27s %8s %9s %8s %8s %9s %10s\n", "", "confirma", "sem conf.", "troca", "outro", "leituras", "tempo");
+    vote_t vh = {0}, vc = {0};
+    for (int l = 0; l < nl; l++) {
+        vote_light(&vh, lights[l], vote_heuristic, NULL);
+        vote_light(&vc, lights[l], vote_calib, &prof[l]);
+    }
+    print_vote("limiares", &vh);
+    print_vote("calibrado", &vc);
+
+    // Tempo por classificação (host; no RP2040 os floats do cor_classify são
+    // emulados, o calibrado usa só inteiros e o divisor de 32 bits)
+    const int reps = 2000;
+    volatile int sink = 0;
+    double t0 = now_ns();
+    for (int k = 0; k < reps; k++)
+        for (int i = 0; i < s_nrows; i++) sink += heuristic(&s_rows[i]);
+    double t1 = now_ns();
+    for (int k = 0; k < reps; k++)
+        for (int i = 0; i < s_nrows; i++) sink += cor_cal_classify(&prof[0], s_rows[i].r, s_rows[i].g, s_rows[i].b, NULL);
+    double t2 = now_ns();
+    double n = (double)reps * s_nrows;
+    printf("\nns por classificação: limiares %.1f, calibrado %.1f\n", (t1 - t0) / n, (t2 - t1) / n);
+    (void)sink;
+    return 0;
+}
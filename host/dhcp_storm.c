@@ -0,0 +1,390 @@
+// Servidor DHCP (dhcpserver/dhcpserver.c) contra uma tempestade de celulares:
+// 50 clientes chegam juntos (DISCOVER repetido, ordens embaralhadas) e depois
+// voltam, renovam, esgotam o pool e somem. Sem rede: a UDP e os timeouts do
+// lwIP são falsos aqui, e o relógio anda à mão (a roda de expiração do
+// servidor gira a cada DHCPS_WHEEL_TICK_S). Confere:
+//   - endereços únicos, dentro do pool, e estáveis (mesmo MAC, mesmo IP);
+//   - renovação por ciaddr (RENEWING), que segura o lease além do prazo;
+//   - esgotamento em DHCPS_MAX_IP: o DISCOVER seguinte fica sem resposta;
+//   - NAK para endereço alheio, fora do pool, de outra rede ou sem endereço;
+//   - DECLINE: o OFFER seguinte traz outro endereço e o recusado fica fora
+//     do pool por DHCPS_DECLINE_TIME_S;
+//   - OFFER sem REQUEST expira em DHCPS_OFFER_TIME_S, lease em DHCPS_LEASE_TIME_S.
+//
+// Usa os cabeçalhos do lwIP (LWIP_DIR), mas não a lwipcore.
+//   cmake --build build-host --target dhcp_storm && build-host/dhcp_storm
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lwip/ip.h"
+#include "lwip/pbuf.h"
+#include "lwip/timeouts.h"
+#include "lwip/udp.h"
+
+#include "dhcpserver.h"
+
+#define CLIENTS     50
+
+#define DHCPDISCOVER 1
+#define DHCPOFFER    2
+#define DHCPREQUEST  3
+#define DHCPDECLINE  4
+#define DHCPACK      5
+#define DHCPNACK     6
+#define DHCPRELEASE  7
+
+// Mensagem BOOTP: cabeçalho fixo de 236 bytes, depois o magic cookie e as opções
+#define BOOTP_CIADDR  12
+#define BOOTP_YIADDR  16
+#define BOOTP_CHADDR  28
+#define BOOTP_OPTIONS 236
+#define BOOTP_LEN     300
+
+/* ---------- lwIP falso: um pcb UDP, um timeout, pbufs no heap ---------- */
+const ip_addr_t   ip_addr_any = IPADDR4_INIT(IPADDR_ANY);
+struct ip_globals ip_data;                     // ip_current_input_netif() = NULL
+
+static struct udp_pcb     *s_pcb = (struct udp_pcb *)&s_pcb;
+static udp_recv_fn          s_recv;
+static void                *s_recv_arg;
+static sys_timeout_handler  s_tmr;
+static void                *s_tmr_arg;
+static uint32_t             s_tmr_due, s_now;  // ms
+static uint8_t              s_reply[600];
+static size_t               s_reply_len;
+
+struct udp_pcb *udp_new(void) { return s_pcb; }
+void udp_remove(struct udp_pcb *pcb) { (void)pcb; s_recv = NULL; }
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    (void)pcb; (void)ipaddr; (void)port;
+    return ERR_OK;
+}
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {
+    (void)pcb;
+    s_recv = recv;
+    s_recv_arg = recv_arg;
+}
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port) {
+    (void)pcb; (void)dst_ip; (void)dst_port;
+    s_reply_len = pbuf_copy_partial(p, s_reply, sizeof s_reply, 0);
+    return ERR_OK;
+}
+err_t udp_sendto_if(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port, struct netif *netif) {
+    (void)netif;
+    return udp_sendto(pcb, p, dst_ip, dst_port);
+}
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type) {
+    (void)layer; (void)type;
+    struct pbuf *p = calloc(1, sizeof *p + length);
+    p->payload = p + 1;
+    p->len = p->tot_len = length;
+    return p;
+}
+u8_t pbuf_free(struct pbuf *p) {
+    free(p);
+    return 1;
+}
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset) {
+    if (offset >= p->len) return 0;
+    if (len > p->len - offset) len = p->len - offset;
+    memcpy(dataptr, (const uint8_t *)p->payload + offset, len);
+    return len;
+}
+
+void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg) {
+    s_tmr = handler;
+    s_tmr_arg = arg;
+    s_tmr_due = s_now + msecs;
+}
+void sys_untimeout(sys_timeout_handler handler, void *arg) {
+    (void)handler; (void)arg;
+    s_tmr = NULL;
+}
+
+// Anda o relógio, disparando a roda no caminho
+static void advance_s(uint32_t secs) {
+    uint32_t until = s_now + secs * 1000u;
+    while (s_tmr && s_tmr_due <= until) {
+        sys_timeout_handler h = s_tmr;
+        s_now = s_tmr_due;
+        s_tmr = NULL;
+        h(s_tmr_arg);
+    }
+    s_now = until;
+}
+
+/* ---------- clientes ---------- */
+typedef struct {
+    uint8_t  mac[6];
+    uint32_t xid;
+    uint8_t  ip;                 // último byte do endereço; 0 = sem endereço
+} client_t;
+
+static client_t       s_cli[DHCPS_MAX_IP + 1];
+static dhcp_server_t  s_dhcp;
+static const uint8_t  k_server[4] = { 192, 168, 4, 1 };
+static int            s_fail;
+
+#define CHECK(cond, ...) do {                                          \
+        if (!(cond)) {                                                 \
+            s_fail++;                                                  \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);            \
+            fprintf(stderr, __VA_ARGS__);                              \
+            fputc('\n', stderr);                                       \
+        }                                                              \
+    } while (0)
+
+static uint32_t s_rng = 0x9E3779B9u;
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void shuffle(int *v, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(rnd() % (uint32_t)(i + 1));
+        int t = v[i]; v[i] = v[j]; v[j] = t;
+    }
+}
+
+typedef struct {
+    int      type;               // DHCPOFFER/ACK/NACK; 0 = sem resposta
+    uint8_t  yiaddr[4];
+    uint32_t lease_s;
+} reply_t;
+
+typedef struct {
+    const uint8_t *req_ip;       // opção 50 (NULL = ausente)
+    const uint8_t *server_id;    // opção 54 (NULL = ausente)
+    const uint8_t *ciaddr;       // NULL = 0.0.0.0
+} req_opts_t;
+
+static reply_t exchange(client_t *c, int type, req_opts_t o) {
+    uint8_t m[BOOTP_LEN] = { 0 };
+    m[0] = 1;                                  // BOOTREQUEST
+    m[1] = 1;                                  // Ethernet
+    m[2] = 6;
+    memcpy(m + 4, &c->xid, 4);
+    if (o.ciaddr) memcpy(m + BOOTP_CIADDR, o.ciaddr, 4);
+    memcpy(m + BOOTP_CHADDR, c->mac, 6);
+    uint8_t *p = m + BOOTP_OPTIONS;
+    *p++ = 99; *p++ = 130; *p++ = 83; *p++ = 99;
+    *p++ = 53; *p++ = 1; *p++ = (uint8_t)type;
+    if (o.req_ip)    { *p++ = 50; *p++ = 4; memcpy(p, o.req_ip, 4); p += 4; }
+    if (o.server_id) { *p++ = 54; *p++ = 4; memcpy(p, o.server_id, 4); p += 4; }
+    *p++ = 255;
+
+    struct pbuf *pb = pbuf_alloc(PBUF_TRANSPORT, BOOTP_LEN, PBUF_RAM);
+    memcpy(pb->payload, m, BOOTP_LEN);
+    ip_addr_t src;
+    IP4_ADDR(ip_2_ip4(&src), 0, 0, 0, 0);
+    s_reply_len = 0;
+    s_recv(s_recv_arg, s_pcb, pb, &src, 68);   // o servidor libera pb
+
+    reply_t r = { 0 };
+    if (!s_reply_len) return r;
+    CHECK(!memcmp(s_reply + 4, &c->xid, 4), "resposta com outro xid");
+    memcpy(r.yiaddr, s_reply + BOOTP_YIADDR, 4);
+    for (size_t i = BOOTP_OPTIONS + 4; i + 1 < s_reply_len && s_reply[i] != 255; i += 2 + s_reply[i + 1]) {
+        if (s_reply[i] == 53) r.type = s_reply[i + 2];
+        if (s_reply[i] == 51) r.lease_s = (uint32_t)s_reply[i + 2] << 24 | s_reply[i + 3] << 16 | s_reply[i + 4] << 8 | s_reply[i + 5];
+    }
+    return r;
+}
+
+static bool in_pool(const uint8_t *a) {
+    return !memcmp(a, k_server, 3) && a[3] >= DHCPS_BASE_IP && a[3] < DHCPS_BASE_IP + DHCPS_MAX_IP;
+}
+
+static uint8_t discover(client_t *c) {
+    c->xid = rnd();
+    reply_t r = exchange(c, DHCPDISCOVER, (req_opts_t){ 0 });
+    if (!r.type) return 0;
+    CHECK(r.type == DHCPOFFER && in_pool(r.yiaddr), "DISCOVER: tipo %d, %u.%u.%u.%u",
+          r.type, r.yiaddr[0], r.yiaddr[1], r.yiaddr[2], r.yiaddr[3]);
+    return r.yiaddr[3];
+}
+
+// SELECTING: endereço oferecido na opção 50, com o server id
+static int request(client_t *c, uint8_t host) {
+    uint8_t a[4] = { k_server[0], k_server[1], k_server[2], host };
+    reply_t r = exchange(c, DHCPREQUEST, (req_opts_t){ a, k_server, NULL });
+    if (r.type == DHCPACK) {
+        CHECK(r.yiaddr[3] == host, "ACK de %u para pedido de %u", r.yiaddr[3], host);
+        CHECK(r.lease_s == DHCPS_LEASE_TIME_S, "lease de %u s", (unsigned)r.lease_s);
+        c->ip = host;
+    }
+    return r.type;
+}
+
+// RENEWING: só ciaddr, sem opção 50 nem server id
+static int renew(client_t *c) {
+    uint8_t a[4] = { k_server[0], k_server[1], k_server[2], c->ip };
+    reply_t r = exchange(c, DHCPREQUEST, (req_opts_t){ NULL, NULL, a });
+    if (r.type == DHCPACK) CHECK(r.yiaddr[3] == c->ip, "renovação mudou %u -> %u", c->ip, r.yiaddr[3]);
+    return r.type;
+}
+
+static int request_raw(client_t *c, const uint8_t *req_ip, const uint8_t *server_id, const uint8_t *ciaddr) {
+    return exchange(c, DHCPREQUEST, (req_opts_t){ req_ip, server_id, ciaddr }).type;
+}
+
+// Endereço host em uso por outro na rede (ARP respondeu): opção 50, ciaddr 0
+static void decline(client_t *c, uint8_t host) {
+    uint8_t a[4] = { k_server[0], k_server[1], k_server[2], host };
+    reply_t r = exchange(c, DHCPDECLINE, (req_opts_t){ a, k_server, NULL });
+    CHECK(!r.type, "DECLINE respondido");
+    if (host == c->ip) c->ip = 0;
+}
+
+static void release(client_t *c) {
+    uint8_t a[4] = { k_server[0], k_server[1], k_server[2], c->ip };
+    reply_t r = exchange(c, DHCPRELEASE, (req_opts_t){ NULL, k_server, a });
+    CHECK(!r.type, "RELEASE respondido");
+    c->ip = 0;
+}
+
+// Tempestade: todos descobrem (duas vezes, como quem retransmite) e pedem, em
+// ordens diferentes; endereços únicos no pool
+static void storm(int n) {
+    int order[DHCPS_MAX_IP + 1];
+    uint8_t offer[DHCPS_MAX_IP + 1];
+    for (int i = 0; i < n; i++) order[i] = i;
+    shuffle(order, n);
+    for (int k = 0; k < n; k++) {
+        client_t *c = &s_cli[order[k]];
+        offer[order[k]] = discover(c);
+        CHECK(offer[order[k]], "cliente %d sem OFFER", order[k]);
+    }
+    shuffle(order, n);
+    for (int k = 0; k < n; k++) {
+        CHECK(discover(&s_cli[order[k]]) == offer[order[k]], "retransmissão do cliente %d mudou a oferta", order[k]);
+    }
+    shuffle(order, n);
+    for (int k = 0; k < n; k++) {
+        int i = order[k];
+        CHECK(request(&s_cli[i], offer[i]) == DHCPACK, "cliente %d sem ACK", i);
+    }
+    bool used[256] = { false };
+    for (int i = 0; i < n; i++) {
+        CHECK(s_cli[i].ip && !used[s_cli[i].ip], "cliente %d: endereço %u repetido ou ausente", i, s_cli[i].ip);
+        used[s_cli[i].ip] = true;
+    }
+}
+
+int main(void) {
+    for (int i = 0; i <= DHCPS_MAX_IP; i++) {
+        uint8_t mac[6] = { 0x02, 0x1A, 0x11, (uint8_t)(i >> 8), (uint8_t)i, (uint8_t)(i * 37) };
+        memcpy(s_cli[i].mac, mac, 6);
+    }
+    client_t *late = &s_cli[DHCPS_MAX_IP];     // chega com o pool cheio
+
+    ip_addr_t ip, nm;
+    IP4_ADDR(ip_2_ip4(&ip), 192, 168, 4, 1);
+    IP4_ADDR(ip_2_ip4(&nm), 255, 255, 255, 0);
+    dhcp_server_init(&s_dhcp, &ip, &nm);
+
+    /* 1. tempestade e estabilidade */
+    storm(CLIENTS);
+    for (int i = 0; i < CLIENTS; i++) {
+        client_t *c = &s_cli[i];
+        uint8_t ip = c->ip;
+        CHECK(discover(c) == ip, "cliente %d: DISCOVER de volta ofereceu outro endereço", i);
+        uint8_t a[4] = { k_server[0], k_server[1], k_server[2], ip };
+        CHECK(request_raw(c, a, NULL, NULL) == DHCPACK, "cliente %d: INIT-REBOOT recusado", i);
+    }
+    printf("tempestade: %d clientes, endereços únicos e estáveis\n", CLIENTS);
+
+    /* 1b. DECLINE: o endereço em conflito sai do pool por um tempo */
+    client_t *dc = &s_cli[CLIENTS], *other_c = &s_cli[CLIENTS + 1];
+    uint8_t bad = discover(dc);
+    CHECK(bad && request(dc, bad) == DHCPACK, "cliente do DECLINE sem endereço");
+    decline(dc, (uint8_t)(bad + 1));                            // outro endereço: ignorado
+    CHECK(renew(dc) == DHCPACK, "DECLINE de outro endereço mexeu no lease");
+    decline(dc, bad);
+    uint8_t again = discover(dc);
+    CHECK(again && again != bad, "depois do DECLINE o OFFER repetiu %u", bad);
+    uint8_t bad_a[4] = { k_server[0], k_server[1], k_server[2], bad };
+    CHECK(request_raw(other_c, bad_a, k_server, NULL) == DHCPNACK, "endereço recusado cedido a outro");
+    CHECK(request(dc, again) == DHCPACK, "cliente do DECLINE sem o novo endereço");
+    advance_s(DHCPS_DECLINE_TIME_S + 2 * DHCPS_WHEEL_TICK_S);
+    CHECK(request_raw(other_c, bad_a, k_server, NULL) == DHCPACK, "endereço recusado não voltou ao pool");
+    release(other_c);
+    printf("DECLINE: o próximo OFFER traz outro endereço; o recusado volta em %d s\n", DHCPS_DECLINE_TIME_S);
+
+    /* 2. renovação por ciaddr segura o lease */
+    advance_s(DHCPS_LEASE_TIME_S / 2);
+    for (int i = 0; i < CLIENTS; i++) CHECK(renew(&s_cli[i]) == DHCPACK, "cliente %d: renovação recusada", i);
+    advance_s(DHCPS_LEASE_TIME_S / 2 + 2 * DHCPS_WHEEL_TICK_S);     // passou do primeiro prazo
+    for (int i = 0; i < CLIENTS; i++) CHECK(renew(&s_cli[i]) == DHCPACK, "cliente %d: lease renovado expirou", i);
+    printf("renovação: ciaddr mantém os %d leases além de %d s\n", CLIENTS, DHCPS_LEASE_TIME_S);
+
+    /* 3. esgotamento */
+    for (int i = CLIENTS; i < DHCPS_MAX_IP; i++) {
+        uint8_t ip = discover(&s_cli[i]);
+        CHECK(ip && request(&s_cli[i], ip) == DHCPACK, "cliente extra %d sem endereço", i);
+    }
+    CHECK(!discover(late), "pool cheio e ainda houve OFFER");
+    printf("esgotamento: %d leases (DHCPS_MAX_IP), o %dº DISCOVER fica sem resposta\n", DHCPS_MAX_IP, DHCPS_MAX_IP + 1);
+
+    /* 4. NAK */
+    client_t *a = &s_cli[0], *b = &s_cli[1];
+    uint8_t ip_b[4]   = { k_server[0], k_server[1], k_server[2], b->ip };
+    uint8_t ip_out[4] = { k_server[0], k_server[1], k_server[2], 200 };
+    uint8_t ip_low[4] = { k_server[0], k_server[1], k_server[2], DHCPS_BASE_IP - 1 };
+    uint8_t ip_net[4] = { 10, 0, 0, 20 };
+    uint8_t other[4]  = { 192, 168, 4, 2 };
+    CHECK(request_raw(a, ip_b, k_server, NULL) == DHCPNACK, "endereço de outro cliente sem NAK");
+    CHECK(request_raw(late, ip_b, NULL, NULL) == DHCPNACK, "INIT-REBOOT em endereço tomado sem NAK");
+    CHECK(request_raw(a, ip_out, k_server, NULL) == DHCPNACK, "fora do pool (acima) sem NAK");
+    CHECK(request_raw(a, ip_low, k_server, NULL) == DHCPNACK, "fora do pool (abaixo) sem NAK");
+    CHECK(request_raw(a, ip_net, NULL, NULL) == DHCPNACK, "outra rede sem NAK");
+    CHECK(request_raw(a, NULL, NULL, NULL) == DHCPNACK, "REQUEST sem endereço sem NAK");
+    CHECK(request_raw(a, ip_b, other, NULL) == 0, "REQUEST para outro servidor respondido");
+    CHECK(renew(a) == DHCPACK && renew(b) == DHCPACK, "NAK alterou o lease de quem tinha");
+    printf("NAK: endereço alheio, fora do pool, outra rede, sem endereço\n");
+
+    /* 5. OFFER sem REQUEST expira */
+    client_t *gone = &s_cli[CLIENTS - 1];
+    uint8_t freed = gone->ip;
+    release(gone);
+    uint8_t offered = discover(late);
+    CHECK(offered == freed, "RELEASE: OFFER de %u, esperado %u", offered, freed);
+    CHECK(!discover(gone), "OFFER reservado foi oferecido de novo");
+    advance_s(DHCPS_OFFER_TIME_S - DHCPS_WHEEL_TICK_S);
+    CHECK(!discover(gone), "OFFER expirou cedo");
+    advance_s(2 * DHCPS_WHEEL_TICK_S);
+    CHECK(discover(gone) == offered, "OFFER não expirou em %d s", DHCPS_OFFER_TIME_S);
+    CHECK(request(gone, offered) == DHCPACK, "endereço do OFFER expirado não foi cedido");
+    CHECK(!discover(late), "cliente do OFFER expirado ainda tem endereço");
+    printf("OFFER: expira em %d s e o endereço volta ao pool\n", DHCPS_OFFER_TIME_S);
+
+    /* 6. lease sem renovação expira; quem volta recebe o mesmo endereço */
+    for (int i = 0; i < DHCPS_MAX_IP; i++) CHECK(renew(&s_cli[i]) == DHCPACK, "cliente %d: renovação recusada", i);
+    advance_s(DHCPS_LEASE_TIME_S - 2 * DHCPS_WHEEL_TICK_S);
+    CHECK(renew(gone) == DHCPACK, "renovação de %u", gone->ip);   // só este continua
+    CHECK(!discover(late), "leases expiraram cedo");
+    advance_s(3 * DHCPS_WHEEL_TICK_S);
+    uint8_t got = discover(late);
+    CHECK(got && got != gone->ip, "pool não liberou com os leases expirados (%u)", got);
+    for (int i = 0; i < DHCPS_MAX_IP; i++) {
+        client_t *c = &s_cli[i];
+        if (c == gone || c->ip == got) continue;
+        CHECK(discover(c) == c->ip, "cliente %d: volta depois de expirar sem o endereço de antes", i);
+    }
+    printf("lease: expira em %d s; o MAC que volta recebe o endereço de antes\n", DHCPS_LEASE_TIME_S);
+
+    dhcp_server_deinit(&s_dhcp);
+    if (s_fail) {
+        fprintf(stderr, "%d falhas\n", s_fail);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+// Números do JSON/CSV/OLED (src/fmt.c) contra o printf: primeiro confere que
+// fmt_u32/fmt_i32 saem iguais a "%u"/"%d" e fmt_fixed igual a "%.*f" (bordas,
+// potências de 10, meios e floats aleatórios em todas as casas); depois mede
+// ns por número de cada um contra o snprintf.
+//
+// fmt_fixed arredonda a fração em float: perto de um empate (…5 na casa
+// seguinte) o erro do produto pode virar o último dígito, e aí vale um a
+// mais ou a menos. Fora disso tem de ser igual; "-0.000" do printf sai sem
+// o sinal e |v| >= 2^32, NaN e infinito saem "null".
+//
+//   cmake --build build-host --target fmt_bench && build-host/fmt_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "fmt.h"
+
+static uint32_t s_rng = 0x1234567u;
+
+static uint32_t rnd(void) {      // xorshift32
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static long s_checked, s_tie, s_fail;
+
+static void fail(const char *what, const char *got, const char *want) {
+    if (s_fail++ < 20) printf("  %s: \"%s\", printf \"%s\"\n", what, got, want);
+}
+
+static void check_u32(uint32_t v) {
+    char a[FMT_NUM_MAX], b[FMT_NUM_MAX];
+    char *e = fmt_u32(a, v);
+    snprintf(b, sizeof b, "%u", (unsigned)v);
+    s_checked++;
+    if (strcmp(a, b) || e != a + strlen(a)) fail("fmt_u32", a, b);
+}
+
+static void check_i32(int32_t v) {
+    char a[FMT_NUM_MAX], b[FMT_NUM_MAX];
+    char *e = fmt_i32(a, v);
+    snprintf(b, sizeof b, "%d", (int)v);
+    s_checked++;
+    if (strcmp(a, b) || e != a + strlen(a)) fail("fmt_i32", a, b);
+}
+
+// "-123.45" -> -12345: o número em unidades da última casa
+static int64_t units(const char *s) {
+    int64_t v = 0;
+    bool neg = *s == '-';
+    for (s += neg; *s; s++) if (*s != '.') v = v * 10 + (*s - '0');
+    return neg ? -v : v;
+}
+
+// a e b diferem em 1 na última casa (com o "vai um" que for)?
+static bool off_by_one(const char *a, const char *b) {
+    return llabs(units(a) - units(b)) == 1;
+}
+
+static void check_fixed(float v, unsigned dec) {
+    char a[FMT_NUM_MAX + 8], b[64], what[48];
+    char *e = fmt_fixed(a, v, dec);
+    s_checked++;
+    if (e != a + strlen(a)) { fail("fmt_fixed: ponteiro do fim", a, ""); return; }
+    if (!(fabsf(v) < 4294967296.f)) {
+        if (strcmp(a, "null")) fail("fmt_fixed fora da faixa", a, "null");
+        return;
+    }
+    unsigned pd = dec > FMT_FIXED_MAX_DEC ? FMT_FIXED_MAX_DEC : dec;   // fmt_fixed limita as casas
+    snprintf(b, sizeof b, "%.*f", (int)pd, (double)v);
+    const char *want = b;
+    if (b[0] == '-' && strspn(b + 1, "0.") == strlen(b + 1)) want = b + 1;    // "-0.000"
+    if (!strcmp(a, want)) return;
+
+    // Empate: fração escalada a menos de ~2 ulp do float de 0.5
+    double s = fabs((double)v) * pow(10, pd);
+    double f = s - floor(s);
+    double eps = ldexp(pow(10, pd), -22);
+    if (fabs(f - 0.5) < eps && off_by_one(a, want)) { s_tie++; return; }
+    snprintf(what, sizeof what, "fmt_fixed(%.9g, %u)", (double)v, dec);
+    fail(what, a, want);
+}
+
+static void check_all(void) {
+    static const uint32_t edges[] = { 0, 1, 9, 10, 99, 100, 999999999, 1000000000, 4294967295u };
+    for (size_t i = 0; i < sizeof edges / sizeof edges[0]; i++) {
+        check_u32(edges[i]);
+        check_u32(edges[i] - 1);
+    }
+    for (uint32_t p = 1; p < 1000000000u; p *= 10) { check_u32(p - 1); check_u32(p); check_u32(p + 1); }
+    static const int32_t iedges[] = { 0, -1, 1, INT32_MIN, INT32_MIN + 1, INT32_MAX, -10, -999 };
+    for (size_t i = 0; i < sizeof iedges / sizeof iedges[0]; i++) check_i32(iedges[i]);
+    for (int i = 0; i < 1000000; i++) {
+        uint32_t r = rnd();
+        check_u32(r >> (r & 31));
+        check_i32((int32_t)rnd() >> (r & 31));
+    }
+
+    static const float fedges[] = {
+        0.f, -0.f, 0.5f, -0.5f, 0.05f, 0.0005f, -0.0004f, 0.9999999f, 1.f, 72.5f, 72.45f, -12.25f,
+        99.995f, 4294967040.f, 4294967296.f, -4294967296.f, 16777217.f, 1e-7f, 1e-3f,
+        INFINITY, -INFINITY, NAN,
+    };
+    for (unsigned dec = 0; dec <= FMT_FIXED_MAX_DEC + 1; dec++) {
+        for (size_t i = 0; i < sizeof fedges / sizeof fedges[0]; i++) check_fixed(fedges[i], dec);
+        // meios exatos em binário e vizinhos
+        for (int k = 0; k < 4096; k++) {
+            float h = (float)k / 64.f;
+            check_fixed(h, dec);
+            check_fixed(nextafterf(h, 0.f), dec);
+            check_fixed(nextafterf(h, INFINITY), dec);
+            check_fixed(-h, dec);
+        }
+        // faixas do firmware (BPM, %, temperatura) e quaisquer floats finitos
+        for (int i = 0; i < 200000; i++) {
+            check_fixed((float)(rnd() % 25000) / 100.f, dec);
+            check_fixed((float)((int32_t)rnd() >> (rnd() & 31)) / (float)(1u << (rnd() % 24)), dec);
+            uint32_t bits = rnd();
+            float f;
+            memcpy(&f, &bits, sizeof f);
+            check_fixed(f, dec);
+        }
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#define NVALS 4096
+
+int main(void) {
+    check_all();
+    printf("%ld números conferidos com o printf: %ld falhas, %ld empates com 1 na última casa\n",
+           s_checked, s_fail, s_tie);
+    if (s_fail) return 1;
+
+    // Tempo por número: valores como os do /stats.json (BPM, médias, contagens)
+    static float    fv[NVALS];
+    static uint32_t uv[NVALS];
+    for (int i = 0; i < NVALS; i++) {
+        fv[i] = (float)(rnd() % 200000) / 1000.f;
+        uv[i] = rnd() >> (rnd() % 24);
+    }
+    const int reps = 200;
+    char buf[64];
+    volatile size_t sink = 0;
+    double t[4], t0 = now_ns();
+    for (int k = 0; k < reps; k++)
+        for (int i = 0; i < NVALS; i++) sink += (size_t)(fmt_fixed(buf, fv[i], 3) - buf);
+    t[0] = now_ns() - t0; t0 = now_ns();
+    for (int k = 0; k < reps; k++)
+        for (int i = 0; i < NVALS; i++) sink += (size_t)snprintf(buf, sizeof buf, "%.3f", (double)fv[i]);
+    t[1] = now_ns() - t0; t0 = now_ns();
+    for (int k = 0; k < reps; k++)
+        for (int i = 0; i < NVALS; i++) sink += (size_t)(fmt_u32(buf, uv[i]) - buf);
+    t[2] = now_ns() - t0; t0 = now_ns();
+    for (int k = 0; k < reps; k++)
+        for (int i = 0; i < NVALS; i++) sink += (size_t)snprintf(buf, sizeof buf, "%u", (unsigned)uv[i]);
+    t[3] = now_ns() - t0;
+    double n = (double)reps * NVALS;
+    printf("\nns por número (host)   %8s %8s\n", "fmt", "printf");
+    printf("fixo, 3 casas          %8.1f %8.1f\n", t[0] / n, t[1] / n);
+    printf("u32                    %8.1f %8.1f\n", t[2] / n, t[3] / n);
+    (void)sink;
+    return 0;
+}
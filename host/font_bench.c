@@ -0,0 +1,108 @@
+// Texto no buffer do OLED: o caminho por bytes de ssd1306_draw_char_with_font
+// contra o desenho pixel a pixel de antes (um ssd1306_draw_square por pixel
+// aceso). Primeiro confere que os dois deixam o buffer idêntico (todos os
+// caracteres, escalas 1..4, posições quaisquer, inclusive cortadas na borda);
+// depois mede glifos/ms nas telas do firmware (4 linhas de 21 caracteres).
+//
+//   cmake --build build-host --target font_bench && build-host/font_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306.h"
+#include "ssd1306_font.h"
+
+static ssd1306_t s_a, s_b;
+
+// como era ssd1306_draw_char_with_font
+static void draw_char_ref(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
+    if (c < font[3] || c > font[4]) return;
+    uint32_t parts = (font[0] >> 3) + ((font[0] & 7) > 0);
+    for (uint8_t w = 0; w < font[1]; ++w) {
+        uint32_t pp = (c - font[3]) * font[1] * parts + w * parts + 5;
+        for (uint32_t lp = 0; lp < parts; ++lp) {
+            uint8_t line = font[pp++];
+            for (int8_t j = 0; j < 8; ++j, line >>= 1)
+                if (line & 1)
+                    ssd1306_draw_square(p, x + w * scale, y + ((lp << 3) + j) * scale, scale, scale);
+        }
+    }
+}
+
+static void draw_string_ref(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s) {
+    for (int32_t xn = x; *s; xn += (font_8x5[1] + font_8x5[2]) * scale)
+        draw_char_ref(p, xn, y, scale, font_8x5, *s++);
+}
+
+static void buf_init(ssd1306_t *p) {
+    p->width = 128; p->height = 64; p->pages = 8;
+    p->bufsize = 128 * 8;
+    p->buffer = calloc(p->bufsize, 1);
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+typedef void (*draw_fn)(ssd1306_t *, uint32_t, uint32_t, uint32_t, const char *);
+
+static void draw_string_new(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s) {
+    ssd1306_draw_string(p, x, y, scale, s);
+}
+
+// telas como as do oled_lines(): 4 linhas, quadro limpo a cada vez
+static double bench(draw_fn f, uint32_t scale, int frames) {
+    static const char *lines[4] = {
+        "Medindo... BPM: 72.5 ", "Qualidade: 93% (ok)  ",
+        "Aproxime a pulseira  ", "(B) Voltar  [SURVEY] ",
+    };
+    uint32_t step = 16 * scale;
+    double t0 = now_ms();
+    for (int i = 0; i < frames; i++) {
+        memset(s_a.buffer, 0, s_a.bufsize);
+        for (int l = 0; l < 4; l++) f(&s_a, 0, (uint32_t)l * step % 64, scale, lines[l]);
+    }
+    double ms = now_ms() - t0;
+    return frames * 4 * 21 / ms;
+}
+
+int main(void) {
+    buf_init(&s_a);
+    buf_init(&s_b);
+
+    // 1) mesmo resultado
+    srand(1);
+    unsigned bad = 0, cases = 0;
+    for (uint32_t scale = 1; scale <= 4; scale++) {
+        for (int c = 0; c < 128; c++) {
+            for (int k = 0; k < 12; k++, cases++) {
+                int32_t x = rand() % 150 - 10, y = rand() % 80 - 10;
+                memset(s_a.buffer, 0x00, s_a.bufsize);
+                memset(s_b.buffer, 0x00, s_b.bufsize);
+                if (k & 1) {                    // por cima de algo já desenhado
+                    for (size_t i = 0; i < s_a.bufsize; i++) s_a.buffer[i] = s_b.buffer[i] = (uint8_t)rand();
+                }
+                ssd1306_draw_char_with_font(&s_a, x, y, scale, font_8x5, (char)c);
+                draw_char_ref(&s_b, x, y, scale, font_8x5, (char)c);
+                if (memcmp(s_a.buffer, s_b.buffer, s_a.bufsize)) {
+                    if (!bad) printf("difere: '%c' x=%d y=%d escala %u\n", c, x, y, scale);
+                    bad++;
+                }
+            }
+        }
+    }
+    printf("%u/%u glifos idênticos ao desenho pixel a pixel\n", cases - bad, cases);
+
+    // 2) glifos/ms
+    printf("%-8s %14s %14s %8s\n", "escala", "antes glifo/ms", "agora glifo/ms", "ganho");
+    for (uint32_t scale = 1; scale <= 2; scale++) {
+        double ref = bench(draw_string_ref, scale, 2000);
+        double cur = bench(draw_string_new, scale, 20000);
+        printf("%-8u %14.0f %14.0f %7.1fx\n", scale, ref, cur, cur / ref);
+    }
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+// Vazão do parser HTTP (src/http_parse.c): requisições como as dos celulares
+// no AP (carga do /display com cabeçalhos de navegador, polls do /fb.bin com
+// If-None-Match, POST do survey), em pipelining, entregues em segmentos de
+// 1460 (MSS), 536 (MSS mínimo) e 1 byte, como o http_process percorre a rx_q.
+// Mede MB/s e requisições/ms; o custo por segmento é o que muda entre as linhas.
+//
+//   cmake --build build-host --target http_bench && build-host/http_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "http_parse.h"
+
+static const char *const k_reqs[] = {
+    "GET /display HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "Connection: keep-alive\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (Linux; Android 14; SM-A546E) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0 Mobile Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: pt-BR,pt;q=0.9,en-US;q=0.8\r\n"
+    "If-None-Match: \"5d41402a\"\r\n"
+    "\r\n",
+
+    "GET /fb.bin?v=1234 HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (Linux; Android 14) AppleWebKit/537.36 Chrome/124.0 Mobile Safari/537.36\r\n"
+    "Accept: */*\r\n"
+    "Referer: http://192.168.4.1/display\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "\r\n",
+
+    "POST /survey_submit HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 14\r\n"
+    "Origin: http://192.168.4.1\r\n"
+    "\r\n"
+    "ans=1011001110",
+};
+
+#define NREQ_STREAM 64
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Percorre o fluxo em segmentos de `seg` bytes; devolve requisições completas
+static unsigned parse_stream(const char *s, size_t n, size_t seg) {
+    static http_req_t r;
+    unsigned done = 0;
+    http_req_reset(&r);
+    for (size_t off = 0; off < n;) {
+        size_t end = off + seg < n ? off + seg : n;
+        while (off < end) {
+            off += http_parse(&r, s + off, (uint16_t)(end - off));
+            if (r.st == HP_DONE) {
+                done += !r.status;
+                http_req_reset(&r);
+            }
+        }
+    }
+    return done;
+}
+
+int main(void) {
+    static char stream[NREQ_STREAM * 600];
+    size_t n = 0;
+    for (int i = 0; i < NREQ_STREAM; i++) {
+        // mistura típica: 1 página, 6 polls, 1 POST
+        const char *q = k_reqs[i % 8 == 0 ? 0 : i % 8 == 7 ? 2 : 1];
+        size_t l = strlen(q);
+        memcpy(stream + n, q, l);
+        n += l;
+    }
+    if (parse_stream(stream, n, n) != NREQ_STREAM) {
+        fprintf(stderr, "fluxo de referência não analisa inteiro\n");
+        return 1;
+    }
+
+    static const size_t segs[] = { 1460, 536, 64, 1 };
+    printf("%d requisições, %zu bytes (%.0f B/req)\n", NREQ_STREAM, n, (double)n / NREQ_STREAM);
+    printf("%-9s %10s %10s %10s\n", "segmento", "MB/s", "req/ms", "ns/byte");
+    for (size_t k = 0; k < sizeof segs / sizeof segs[0]; k++) {
+        int reps = segs[k] == 1 ? 2000 : 10000;
+        unsigned got = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < reps; i++) got += parse_stream(stream, n, segs[k]);
+        double ns = now_ns() - t0;
+        if (got != (unsigned)reps * NREQ_STREAM) {
+            fprintf(stderr, "segmento %zu: %u de %u requisições\n", segs[k], got, reps * NREQ_STREAM);
+            return 1;
+        }
+        double bytes = (double)n * reps;
+        printf("%-9zu %10.1f %10.1f %10.2f\n", segs[k], bytes / ns * 1e3, got / ns * 1e6, ns / bytes);
+    }
+    return 0;
+}
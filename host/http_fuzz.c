@@ -0,0 +1,263 @@
+// Parser HTTP (src/http_parse.c) contra ele mesmo: a mesma sequência de bytes
+// tem de dar o mesmo resultado não importa onde os segmentos TCP cortam. Cada
+// rodada gera requisições em pipelining (válidas, recusadas e mutadas byte a
+// byte), analisa o buffer inteiro de uma vez e depois uma cadeia de segmentos
+// com cortes aleatórios (1 byte, pequenos, MSS, quaisquer), consumida como o
+// http_process consome a rx_q. Confere, por requisição, os bytes consumidos e
+// o http_req_t inteiro (estado, alvo, cabeçalhos, corpo, código de recusa).
+//
+//   cmake --build build-host --target http_fuzz && build-host/http_fuzz [rodadas] [semente]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "http_parse.h"
+
+#define STREAM_MAX   16384       // cabe no u16_t do http_parse (e nos 4 KB + sobras)
+#define REQ_MAX      64
+
+static uint32_t s_rng;
+
+static uint32_t rnd(void) {      // xorshift32
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t rnd_n(uint32_t n) { return n ? rnd() % n : 0; }
+
+/* ---------- gerador ---------- */
+typedef struct { char b[STREAM_MAX]; size_t n; } buf_t;
+
+static void put(buf_t *b, const char *s, size_t n) {
+    if (n > STREAM_MAX - b->n) n = STREAM_MAX - b->n;
+    memcpy(b->b + b->n, s, n);
+    b->n += n;
+}
+
+static void puts_(buf_t *b, const char *s) { put(b, s, strlen(s)); }
+
+static void put_rep(buf_t *b, char c, size_t n) {
+    while (n-- && b->n < STREAM_MAX) b->b[b->n++] = c;
+}
+
+static bool s_dirty;             // rodada com entradas recusáveis; senão só as válidas
+
+// As `ok` primeiras de v são válidas
+static const char *pick(const char *const *v, size_t n, size_t ok) {
+    return v[rnd_n((uint32_t)(s_dirty ? n : ok))];
+}
+#define PICK(v, ok) pick(v, sizeof v / sizeof v[0], ok)
+
+static void put_eol(buf_t *b) { puts_(b, rnd_n(8) ? "\r\n" : "\n"); }
+
+static void gen_request(buf_t *b) {
+    static const char *const methods[] = { "GET", "GET", "POST", "PUT", "OPTIONS", "get", "GETTTTTT" };
+    static const char *const paths[]   = { "/", "/display", "/stats.json", "/fb.bin", "/survey_submit",
+                                           "/bench/up", "/ws", "/events", "x", "" };
+    static const char *const queries[] = { "", "?color=verde", "?v=17", "?ans=1011001110", "?a=1&b",
+                                           "?stats&color=amarelo", "?x?y=1" };
+    static const char *const versions[] = { "HTTP/1.1", "HTTP/1.1", "HTTP/1.0", "HTTP/2", "HTTP/1.10", "" };
+    static const char *const names[] = { "Host", "Accept-Encoding", "Connection", "connection",
+                                         "If-None-Match", "Sec-WebSocket-Key", "Upgrade",
+                                         "User-Agent", "Content-Length", "Transfer-Encoding" };
+    static const char *const values[] = { "192.168.4.1", "gzip, deflate, br", "close", "keep-alive",
+                                          "Upgrade", "\"3f2a1b\"", "*", "dGhlIHNhbXBsZSBub25jZQ==",
+                                          "websocket", "chunked", "Mozilla/5.0 (Linux; Android 14)" };
+
+    puts_(b, PICK(methods, 3));
+    puts_(b, " ");
+    switch (s_dirty ? rnd_n(12) : 2) {
+    case 0:  put_rep(b, 'a', 150 + rnd_n(30)); break;       // perto de HTTP_TARGET_MAX
+    case 1:  puts_(b, "/\x01"); break;
+    default: puts_(b, PICK(paths, 8)); puts_(b, PICK(queries, 7)); break;
+    }
+    puts_(b, " ");
+    puts_(b, PICK(versions, 3));
+    put_eol(b);
+
+    uint32_t clen = 0;
+    bool has_clen = false;
+    for (uint32_t h = rnd_n(7); h--;) {
+        uint32_t k = rnd_n(s_dirty ? 14 : 12);
+        if (k < 10) {
+            const char *name = PICK(names, 9);
+            puts_(b, name);
+            puts_(b, rnd_n(3) ? ": " : ":\t  ");
+            if (!strcmp(name, "Content-Length")) {
+                char v[16];
+                static const uint32_t lens[] = { 0, 1, 5, 17, 64, 65, 1000, 123456789 };
+                clen = lens[rnd_n(sizeof lens / sizeof lens[0])];
+                has_clen = true;
+                if (!s_dirty || rnd_n(10)) snprintf(v, sizeof v, "%u", (unsigned)clen);
+                else snprintf(v, sizeof v, rnd_n(2) ? "1x" : "1234567890");
+                puts_(b, v);
+            } else {
+                puts_(b, PICK(values, 11));
+            }
+            if (!rnd_n(6)) puts_(b, "  \t");                   // espaço no fim do valor
+        } else if (k == 10) {
+            put_rep(b, 'N', 20 + rnd_n(10));                    // nome perto de HTTP_HNAME_MAX
+            puts_(b, ": v");
+        } else if (k == 11) {
+            puts_(b, "If-None-Match: ");
+            put_rep(b, 'e', 60 + rnd_n(10));                    // valor perto de HTTP_HVAL_MAX
+        } else if (k == 12) {
+            puts_(b, "X-Pad: ");
+            put_rep(b, 'p', rnd_n(5) ? 100 : 4200);             // estoura HTTP_HEAD_MAX às vezes
+        } else {
+            puts_(b, "sem-dois-pontos");
+        }
+        put_eol(b);
+    }
+    put_eol(b);
+    if (has_clen && clen <= HTTP_BODY_MAX)
+        for (uint32_t i = 0; i < clen && b->n < STREAM_MAX; i++) b->b[b->n++] = (char)('a' + rnd_n(26));
+    else if (has_clen && clen <= 1000 && rnd_n(2))
+        put_rep(b, 'z', clen);                                  // corpo grande que ninguém leu
+}
+
+static void gen_stream(buf_t *b) {
+    b->n = 0;
+    s_dirty = !rnd_n(3);
+    if (!rnd_n(8)) put_eol(b);                                  // linhas vazias antes
+    for (uint32_t n = 1 + rnd_n(6); n-- && b->n < STREAM_MAX - 5000;) gen_request(b);
+    for (uint32_t m = s_dirty ? 1 + rnd_n(6) : 0; m--;) {      // mutações
+        if (!b->n) break;
+        size_t at = rnd_n((uint32_t)b->n);
+        switch (rnd_n(3)) {
+        case 0: b->b[at] = (char)rnd(); break;
+        case 1: memmove(b->b + at, b->b + at + 1, b->n - at - 1); b->n--; break;
+        case 2:
+            if (b->n < STREAM_MAX) {
+                memmove(b->b + at + 1, b->b + at, b->n - at);
+                b->b[at] = "\r\n: ?\t/0"[rnd_n(8)];
+                b->n++;
+            }
+            break;
+        }
+    }
+}
+
+/* ---------- as duas leituras ---------- */
+typedef struct { http_req_t r; size_t used; } result_t;
+typedef struct { result_t v[REQ_MAX]; int n; } results_t;
+
+// Requisição inteira num buffer só
+static void parse_whole(const buf_t *b, results_t *out) {
+    size_t off = 0;
+    out->n = 0;
+    while (out->n < REQ_MAX) {
+        result_t *x = &out->v[out->n++];
+        http_req_reset(&x->r);
+        x->used = http_parse(&x->r, b->b + off, (uint16_t)(b->n - off));
+        off += x->used;
+        if (x->r.st != HP_DONE || off == b->n) break;
+    }
+}
+
+// Cadeia de segmentos como a rx_q: cada http_parse vê só o segmento da frente
+typedef struct seg { const char *payload; uint16_t len; struct seg *next; } seg_t;
+
+static int chain_cut(const buf_t *b, seg_t *segs, int max) {
+    uint32_t mode = rnd_n(5);
+    int n = 0;
+    for (size_t off = 0; off < b->n && n < max; n++) {
+        size_t len;
+        switch (mode) {
+        case 0:  len = 1; break;
+        case 1:  len = 1 + rnd_n(8); break;
+        case 2:  len = rnd_n(2) ? 536 : 1460; break;
+        default: len = 1 + rnd_n(700); break;
+        }
+        if (len > b->n - off || n == max - 1) len = b->n - off;
+        segs[n] = (seg_t){ b->b + off, (uint16_t)len, NULL };
+        if (n) segs[n - 1].next = &segs[n];
+        off += len;
+    }
+    return n;
+}
+
+static void parse_chain(seg_t *q, results_t *out) {
+    out->n = 0;
+    result_t *x = &out->v[out->n++];
+    http_req_reset(&x->r);
+    x->used = 0;
+    while (q) {
+        uint16_t used = http_parse(&x->r, q->payload, q->len);
+        x->used += used;
+        q->payload += used;                                     // pbuf_free_header
+        q->len -= used;
+        if (!q->len) q = q->next;
+        if (x->r.st == HP_DONE) {
+            if (!q || out->n == REQ_MAX) break;
+            x = &out->v[out->n++];
+            http_req_reset(&x->r);
+            x->used = 0;
+        }
+    }
+}
+
+static void dump(const buf_t *b) {
+    for (size_t i = 0; i < b->n && i < 600; i++) {
+        unsigned char c = (unsigned char)b->b[i];
+        if (c == '\n') fputs("\\n\n", stderr);
+        else if (c == '\r') fputs("\\r", stderr);
+        else if (c < ' ' || c >= 0x7F) fprintf(stderr, "\\x%02x", c);
+        else fputc(c, stderr);
+    }
+    fputc('\n', stderr);
+}
+
+static bool same(const result_t *a, const result_t *b) {
+    return a->used == b->used && !memcmp(&a->r, &b->r, sizeof a->r);
+}
+
+int main(int argc, char **argv) {
+    long rounds = argc > 1 ? atol(argv[1]) : 200000;
+    uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x2545F491u;
+    s_rng = seed ? seed : 1;
+
+    static buf_t b;
+    static results_t whole, chain;
+    static seg_t segs[STREAM_MAX];
+    unsigned long reqs = 0, done = 0, refused = 0, bigbody = 0, cuts = 0;
+
+    for (long i = 0; i < rounds; i++) {
+        gen_stream(&b);
+        parse_whole(&b, &whole);
+        for (int k = 0; k < 3; k++) {
+            int n = chain_cut(&b, segs, STREAM_MAX);
+            cuts += n;
+            parse_chain(n ? segs : NULL, &chain);
+            bool ok = whole.n == chain.n;
+            for (int j = 0; ok && j < whole.n && j < chain.n; j++) ok = same(&whole.v[j], &chain.v[j]);
+            if (!ok) {
+                fprintf(stderr, "DIVERGIU na rodada %ld (semente 0x%08X): inteiro %d req, cadeia %d req em %d segmentos\n",
+                        i, (unsigned)seed, whole.n, chain.n, n);
+                for (int j = 0; j < whole.n && j < chain.n; j++) {
+                    const result_t *w = &whole.v[j], *c = &chain.v[j];
+                    if (same(w, c)) continue;
+                    fprintf(stderr, "  req %d: usado %zu x %zu, st %u x %u, status %u x %u\n",
+                            j, w->used, c->used, w->r.st, c->r.st, w->r.status, c->r.status);
+                }
+                dump(&b);
+                return 1;
+            }
+        }
+        for (int j = 0; j < whole.n; j++) {
+            const http_req_t *r = &whole.v[j].r;
+            reqs++;
+            if (r->st != HP_DONE) continue;
+            if (r->status) refused++;
+            else if (r->flags & HQ_BIGBODY) bigbody++;
+            else done++;
+        }
+    }
+    printf("%ld rodadas, %lu requisições (%lu completas, %lu recusadas, %lu corpo grande), "
+           "%lu segmentos: cadeia = buffer inteiro\n", rounds, reqs, done, refused, bigbody, cuts);
+    return 0;
+}
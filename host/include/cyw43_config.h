@@ -0,0 +1,2 @@
+// Build host: dhcpserver.c inclui este arquivo, mas não usa nada dele
+#pragma once
@@ -0,0 +1,21 @@
+// Build host: o tipo citado em oximetro.h, a escrita bloqueante que o driver
+// do SSD1306 usa (quem implementa é o mock, host/ssd1306_mock.c) e o que o
+// i2c_bus.c usa (as chamadas com timeout vêm do host/cor_bench.c e do
+// host/web_host.c, sem sensor: falham)
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+
+enum { PICO_ERROR_TIMEOUT = -1, PICO_ERROR_GENERIC = -2 };
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+static inline uint i2c_init(i2c_inst_t *i2c, uint baudrate) { (void)i2c; return baudrate; }
+static inline void i2c_deinit(i2c_inst_t *i2c) { (void)i2c; }
+static inline uint i2c_hw_index(i2c_inst_t *i2c) { (void)i2c; return 0; }
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
@@ -0,0 +1,2 @@
+// Build host: sem metadados de binário
+#pragma once
@@ -0,0 +1,48 @@
+// Build host: o pouco do pico/stdlib.h que a pilha web, o driver do OLED, o
+// cor.c (host/cor_bench) e o i2c_bus.c usam
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+typedef unsigned int uint;
+
+static inline uint32_t time_us_32(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+typedef uint64_t absolute_time_t;   // us desde um ponto qualquer
+
+static inline absolute_time_t get_absolute_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000u); }
+
+static inline void busy_wait_us_32(uint32_t us) {
+    struct timespec ts = { 0, (long)us * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    struct timespec ts = { (time_t)(ms / 1000u), (long)(ms % 1000u) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// Sem pinos no host: configurar não faz nada, entrada lê nível alto
+#define GPIO_FUNC_I2C 3
+#define GPIO_FUNC_SIO 5
+#define GPIO_IN       false
+#define GPIO_OUT      true
+static inline void gpio_init(uint pin) { (void)pin; }
+static inline void gpio_set_dir(uint pin, bool out) { (void)pin; (void)out; }
+static inline void gpio_set_function(uint pin, int fn) { (void)pin; (void)fn; }
+static inline void gpio_pull_up(uint pin) { (void)pin; }
+static inline void gpio_put(uint pin, bool value) { (void)pin; (void)value; }
+static inline bool gpio_get(uint pin) { (void)pin; return true; }
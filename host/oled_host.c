@@ -0,0 +1,166 @@
+// Driver do OLED no host, sobre o barramento falso de ssd1306_mock.c:
+// passa as telas do firmware pelo caminho assíncrono (ssd1306_show_async) e
+// confere a ordem das transferências, o agrupamento de quadros pedidos com
+// outro em curso, a recuperação de NACK e de barramento preso. Sai com 1 se
+// o mock apontou alguma violação ou se o painel não termina igual ao buffer.
+// Por último, 10 s do traço de PPG da tela de medição (oled_scope) a 25 Hz:
+// bytes/s no I2C contra o orçamento do main.c.
+//
+//   cmake -S host -B build-host && cmake --build build-host --target oled_host
+//   build-host/oled_host
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ssd1306.h"
+#include "ssd1306_mock.h"
+#include "oled_scope.h"
+
+// como no main.c
+#define SCOPE_PAGE0       1
+#define SCOPE_PAGE1       6
+#define SCOPE_BUDGET_BPS  1500
+#define WAVE_HZ           25
+
+static ssd1306_t      s_oled;
+static ssd1306_mock_t s_mock;
+static uint32_t       s_done, s_failed;
+static uint32_t       s_loop_us;     // tempo do "laço" dentro de show_async
+
+static void on_done(ssd1306_t *p, bool ok) {
+    (void)p;
+    s_done++;
+    if (!ok) s_failed++;
+}
+
+// como oled_lines() do main.c
+static void lines(const char *l1, const char *l2, const char *l3, const char *l4) {
+    ssd1306_clear(&s_oled);
+    if (l1) ssd1306_draw_string(&s_oled, 0,  0, 1, l1);
+    if (l2) ssd1306_draw_string(&s_oled, 0, 16, 1, l2);
+    if (l3) ssd1306_draw_string(&s_oled, 0, 32, 1, l3);
+    if (l4) ssd1306_draw_string(&s_oled, 0, 48, 1, l4);
+    uint32_t t0 = time_us_32();
+    ssd1306_show_async(&s_oled);
+    s_loop_us += time_us_32() - t0;
+}
+
+static int check(bool cond, const char *what) {
+    printf("  %-6s %s\n", cond ? "ok" : "FALHOU", what);
+    return cond ? 0 : 1;
+}
+
+int main(void) {
+    int fails = 0;
+    char l2[24];
+
+    ssd1306_mock_init(&s_mock, &s_oled);
+    if (!ssd1306_init(&s_oled, 128, 64, 0x3C, NULL) ||
+        !ssd1306_async_init(&s_oled, &s_mock.bus, on_done)) {
+        printf("init falhou\n");
+        return 1;
+    }
+
+    printf("1) telas com o barramento livre entre elas\n");
+    lines("Iniciar triagem?", "(A) Sim   (B) Nao", "Botao Joy: Relatorio", "");
+    ssd1306_mock_drain(&s_mock);
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "quadro inteiro no painel");
+    lines("Oximetro ativo", "Posicione o dedo", "Aguardando...", "(B) Voltar");
+    ssd1306_mock_drain(&s_mock);
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "só as páginas mudadas");
+    uint32_t done0 = s_done;
+    lines("Oximetro ativo", "Posicione o dedo", "Aguardando...", "(B) Voltar");
+    fails += check(!ssd1306_busy(&s_oled) && s_done == done0, "quadro igual não vai ao barramento");
+
+    printf("2) rajada: 20 quadros a cada 200 us, com um em curso\n");
+    uint32_t coalesced0 = s_oled.stats.coalesced, transfers0 = s_mock.transfers;
+    for (int i = 0; i < 20; i++) {
+        snprintf(l2, sizeof l2, "BPM: %d", 60 + i);
+        lines("Medindo...", l2, "Qualid: 90%", "(B) Voltar");
+        ssd1306_mock_advance(&s_mock, 200);
+    }
+    ssd1306_mock_drain(&s_mock);
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "painel termina no último quadro");
+    fails += check(s_oled.stats.coalesced > coalesced0, "quadros intermediários agrupados");
+    printf("     %lu transferências para 20 quadros, %lu agrupados\n",
+           (unsigned long)(s_mock.transfers - transfers0),
+           (unsigned long)(s_oled.stats.coalesced - coalesced0));
+
+    printf("3) desenhar de novo enquanto o quadro anterior sai\n");
+    lines("Validar pulseira", "Aproxime a pulseira", "no sensor", "");
+    ssd1306_mock_advance(&s_mock, 300);
+    lines("Validar pulseira", "Aproxime a pulseira", "no sensor", "Medindo ambiente...");
+    lines("Validar pulseira", "Aproxime a pulseira", "no sensor", "");   // volta ao que está saindo
+    ssd1306_mock_drain(&s_mock);
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "pendente descartado ao voltar ao quadro em curso");
+
+    printf("4) NACK numa transferência\n");
+    uint32_t failed0 = s_failed;
+    s_mock.nack_in = 1;
+    lines("ERRO no oximetro", "Cheque conexoes", "", "");
+    ssd1306_mock_drain(&s_mock);
+    fails += check(s_failed == failed0 + 1 && !s_oled.shadow_valid, "falha reportada, sombra invalidada");
+    lines("ERRO no oximetro", "Cheque conexoes", "", "");
+    ssd1306_mock_drain(&s_mock);
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "próximo quadro vai inteiro e corrige");
+
+    printf("5) barramento preso\n");
+    uint32_t errors0 = s_oled.stats.errors;
+    s_mock.stuck = true;
+    lines("Oximetro cancelado", "Voltando ao menu...", "", "");
+    usleep(SSD1306_FLUSH_TIMEOUT_US + 20000);
+    lines("Responda no painel", "Abrir /survey no celular", "[SURVEY]", "");
+    ssd1306_mock_drain(&s_mock);
+    fails += check(s_oled.stats.errors == errors0 + 1, "transferência abortada pelo prazo");
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "quadro seguinte chega inteiro");
+
+    printf("6) traço do PPG: 10 s, 25 amostras/s, texto a cada 200 ms, laço de 10 ms\n");
+    oled_scope_t scope;
+    ssd1306_clear(&s_oled);
+    oled_scope_init(&scope, &s_oled, SCOPE_PAGE0, SCOPE_PAGE1, SCOPE_BUDGET_BPS);
+    uint32_t b0 = s_mock.bytes, us0 = s_mock.bus_us, frames0 = s_mock.transfers;
+    uint32_t max_frame = 0, sent = 0;
+    for (uint32_t t = 0; t < 10000; t += 10) {
+        if (t % 200 == 0) {                  // oled_scope_text()
+            char top[24];
+            snprintf(top, sizeof top, "BPM~ %.1f  %u/8", 70.0 + (t / 1000) % 5, t / 1250);
+            memset(s_oled.buffer, 0, s_oled.width);
+            memset(s_oled.buffer + 7 * s_oled.width, 0, s_oled.width);
+            ssd1306_draw_string(&s_oled, 0, 0, 1, top);
+            ssd1306_draw_string(&s_oled, 0, 56, 1, "Medindo... (B)Voltar");
+            oled_scope_flush(&scope, t);
+        }
+        if (t % (1000 / WAVE_HZ) == 0) {     // oled_scope_poll()
+            double ph = t / 1000.0 * 72 / 60 * 2 * M_PI;
+            oled_scope_push(&scope, (int16_t)(600 * sin(ph) + 250 * sin(2 * ph + 1)));
+            uint32_t before = s_mock.bytes;
+            oled_scope_flush(&scope, t);
+            ssd1306_mock_advance(&s_mock, 10000);
+            if (s_mock.bytes - before > max_frame) max_frame = s_mock.bytes - before;
+        } else {
+            ssd1306_mock_advance(&s_mock, 10000);
+        }
+    }
+    ssd1306_mock_drain(&s_mock);
+    sent = s_mock.bytes - b0;
+    printf("     %lu B/s no I2C (orçamento %u), %.1f%% do barramento; %lu transferências,"
+           " maior %lu B; %lu envios adiados\n",
+           (unsigned long)(sent / 10), SCOPE_BUDGET_BPS, (s_mock.bus_us - us0) / 100000.0,
+           (unsigned long)(s_mock.transfers - frames0), (unsigned long)max_frame,
+           (unsigned long)scope.held);
+    fails += check(sent / 10 <= SCOPE_BUDGET_BPS, "dentro do orçamento");
+    fails += check(ssd1306_mock_matches(&s_mock, s_oled.buffer), "painel termina igual ao buffer");
+
+    printf("\n%lu quadros, %lu iguais, %lu agrupados, %lu erros; %lu B em %lu transferências\n",
+           (unsigned long)s_oled.stats.frames, (unsigned long)s_oled.stats.skipped,
+           (unsigned long)s_oled.stats.coalesced, (unsigned long)s_oled.stats.errors,
+           (unsigned long)s_mock.bytes, (unsigned long)s_mock.transfers);
+    printf("laço dentro de show_async: %lu us no total; barramento a 400 kHz: %lu us\n",
+           (unsigned long)s_loop_us, (unsigned long)s_mock.bus_us);
+    printf("violações de ordem: %lu\n", (unsigned long)s_mock.violations);
+
+    ssd1306_deinit(&s_oled);
+    return fails || s_mock.violations ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+// Telas do OLED no host: cada oled_lines() do main.c (com valores de exemplo
+// onde a linha é montada em tempo de execução) passa pelo driver e pelo I2C
+// falso de ssd1306_mock.c; o que o painel emulado mostra (decodificado do
+// barramento, não do buffer) vira PBM/PNG e é comparado com host/golden/.
+// A tela de medição com o traço do PPG (oled_scope) entra com um pulso
+// sintético. Por tela: tempo de desenho (clear + 4 strings) e bytes/tempo no barramento
+// vindo da tela anterior na ordem do firmware.
+//
+//   build-host/oled_screens                  compara com host/golden/
+//   build-host/oled_screens --update         regrava host/golden/
+//   build-host/oled_screens --out DIR        PBM + PNG (4x) de cada tela em DIR
+//
+// Sai com 1 se alguma tela difere do golden (ou não tem golden).
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "ssd1306.h"
+#include "ssd1306_mock.h"
+#include "oled_scope.h"
+
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR "host/golden"
+#endif
+
+#define DRAW_REPS     2000
+#define PNG_SCALE     4
+#define FULL_FRAME_B  (6 * 3 + 128 * 64 / 8 + 2)    // ssd1306_show de antes
+
+typedef struct {
+    const char *name;
+    const char *l[4];
+    bool scope;                      // tela de medição: l[0] em cima, l[3] embaixo, traço no meio
+} screen_t;
+
+// na ordem em que aparecem no main.c; repetidas lá, uma vez aqui
+static const screen_t k_screens[] = {
+    { "ask",            { "Iniciar triagem?", "(A) Sim   (B) Nao", "Botao Joy: Relatorio", "" }, false },
+    { "survey_wait",    { "Aguardando envio", "Responda no celular", "[SURVEY]", "(B) Cancelar" }, false },
+    { "recommend",      { "Recomendacao:", "Pegue a pulseira", "AMARELO", "Validaremos no sensor" }, false },
+    { "validate",       { "Validar pulseira", "Aproxime a pulseira", "no sensor", "" }, false },
+    { "oxi_missing",    { "MAX3010x nao encontrado", "Verifique cabos", "Voltando ao menu", "" }, false },
+    { "oxi_cancel",     { "Oximetro cancelado", "Voltando ao menu...", "", "" }, false },
+    { "oxi_wait",       { "Oximetro ativo", "Posicione o dedo", "Aguardando...", "(B) Voltar" }, false },
+    { "oxi_calib",      { "Oximetro ativo", "Calibrando...", "Mantenha o dedo", "(B) Voltar" }, false },
+    { "oxi_measure",    { "Medindo...", "BPM~ 72.4", "Validas: 5/8", "(B) Voltar" }, false },
+    { "oxi_scope",      { "BPM~ 72.4  5/8", NULL, NULL, "Medindo... (B)Voltar" }, true },
+    { "oxi_done",       { "Concluido!", "BPM FINAL: 71.8", "", "" }, false },
+    { "oxi_error",      { "ERRO no oximetro", "Cheque conexoes", "", "" }, false },
+    { "survey_panel",   { "Responda no painel", "Abrir /survey no celular", "[SURVEY]", "" }, false },
+    { "tcs_missing",    { "TCS34725 nao encontrado", "Pulando validacao", "", "" }, false },
+    { "color_ambient",  { "Validar pulseira", "Aproxime a pulseira", "no sensor", "Medindo ambiente..." }, false },
+    { "color_read",     { "Validar pulseira", "Segure parada", "Lido: Amarelo 3/5", "AMARELO" }, false },
+    { "color_weak",     { "Validar pulseira", "Aproxime a pulseira", "Leitura fraca...", "AMARELO" }, false },
+    { "color_none",     { "Validar pulseira", "Aproxime a pulseira", "Sem leitura", "AMARELO" }, false },
+    { "color_ok",       { "Pulseira AMARELO ok!", "", "", "" }, false },
+    { "color_wrong",    { "Pulseira incorreta", "Pegue a pulseira:", "AMARELO", "" }, false },
+    { "saved",          { "Registro concluido", "Obrigado!", "", "" }, false },
+    { "report",         { "Relatorio Grupo", "BPM: 74.2 (n=12)", "V:5 A:4 R:3 Joy", "WB:62% Calm:55%" }, false },
+    { "report_empty",   { "Relatorio Grupo", "BPM: --", "V:0 A:0 R:0 Joy", "WB:-- Calm:--" }, false },
+};
+
+static ssd1306_t      s_oled;
+static ssd1306_mock_t s_mock;
+
+// pulso sintético a ~72 bpm em 25 Hz: subida rápida, descida com incisura
+static int16_t pulse(unsigned i) {
+    unsigned ph = i * 6 % 125;       // 125/6 amostras por batimento
+    if (ph < 20) return (int16_t)(ph * 40);
+    int v = 800 - (int)(ph - 20) * 8;
+    if (ph >= 45 && ph < 60) v += 60;
+    return (int16_t)v;
+}
+
+// como oled_lines() do main.c (ou oled_scope_text + 100 amostras), sem o envio
+static void draw(const screen_t *s) {
+    ssd1306_clear(&s_oled);
+    if (s->scope) {
+        static oled_scope_t scope;
+        oled_scope_init(&scope, &s_oled, 1, 6, 1500);
+        ssd1306_draw_string(&s_oled, 0, 0, 1, s->l[0]);
+        ssd1306_draw_string(&s_oled, 0, 56, 1, s->l[3]);
+        for (unsigned i = 0; i < 100; i++) oled_scope_push(&scope, pulse(i));
+        return;
+    }
+    for (int i = 0; i < 4; i++)
+        if (s->l[i]) ssd1306_draw_string(&s_oled, 0, 16 * i, 1, s->l[i]);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char **argv) {
+    bool update = false;
+    const char *out = NULL, *golden = GOLDEN_DIR;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--update")) update = true;
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) out = argv[++i];
+        else if (!strcmp(argv[i], "--golden") && i + 1 < argc) golden = argv[++i];
+        else {
+            printf("uso: %s [--update] [--out DIR] [--golden DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (out && mkdir(out, 0777) && errno != EEXIST) {
+        perror(out);
+        return 1;
+    }
+
+    ssd1306_mock_init(&s_mock, &s_oled);
+    if (!ssd1306_init(&s_oled, 128, 64, 0x3C, NULL) ||
+        !ssd1306_async_init(&s_oled, &s_mock.bus, NULL)) {
+        printf("init falhou\n");
+        return 1;
+    }
+
+    unsigned n = sizeof k_screens / sizeof k_screens[0], bad = 0;
+    uint32_t sum_b = 0, sum_us = 0;
+    double sum_draw = 0;
+    printf("%-15s %9s %9s %9s  %s\n", "tela", "desenho", "bytes", "I2C", "golden");
+    for (unsigned i = 0; i < n; i++) {
+        const screen_t *s = &k_screens[i];
+
+        double t0 = now_us();
+        for (int r = 0; r < DRAW_REPS; r++) draw(s);
+        double draw_us = (now_us() - t0) / DRAW_REPS;
+
+        uint32_t b0 = s_mock.bytes, us0 = s_mock.bus_us;
+        ssd1306_show_async(&s_oled);
+        ssd1306_mock_drain(&s_mock);
+        uint32_t bytes = s_mock.bytes - b0, bus_us = s_mock.bus_us - us0;
+        sum_b += bytes;
+        sum_us += bus_us;
+        sum_draw += draw_us;
+
+        char path[512];
+        const char *verdict;
+        snprintf(path, sizeof path, "%s/%s.pbm", golden, s->name);
+        if (update) {
+            verdict = ssd1306_mock_write_pbm(&s_mock, path) ? "gravado" : "ERRO ao gravar";
+        } else {
+            int d = ssd1306_mock_diff_pbm(&s_mock, path);
+            static char msg[32];
+            if (d == 0) verdict = "ok";
+            else if (d < 0) verdict = "SEM GOLDEN";
+            else { snprintf(msg, sizeof msg, "DIFERE (%d px)", d); verdict = msg; }
+            if (d) bad++;
+        }
+        if (out) {
+            snprintf(path, sizeof path, "%s/%s.pbm", out, s->name);
+            ssd1306_mock_write_pbm(&s_mock, path);
+            snprintf(path, sizeof path, "%s/%s.png", out, s->name);
+            ssd1306_mock_write_png(&s_mock, path, PNG_SCALE);
+        }
+        printf("%-15s %6.1f us %7lu B %6.1f ms  %s\n", s->name, draw_us,
+               (unsigned long)bytes, bus_us / 1000.0, verdict);
+    }
+
+    printf("\n%u telas: desenho médio %.1f us; barramento médio %lu B / %.1f ms por troca "
+           "(quadro inteiro: %u B / %.1f ms)\n", n, sum_draw / n,
+           (unsigned long)(sum_b / n), sum_us / 1000.0 / n,
+           FULL_FRAME_B, FULL_FRAME_B * MOCK_NS_PER_BYTE / 1e6);
+    if (s_mock.violations) printf("violações de ordem no barramento: %lu\n", (unsigned long)s_mock.violations);
+    if (bad) printf("%u tela(s) diferem do golden (ver com --out; --update se a mudança é intencional)\n", bad);
+
+    ssd1306_deinit(&s_oled);
+    return bad || s_mock.violations ? 1 : 0;
+}
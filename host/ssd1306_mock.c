@@ -0,0 +1,323 @@
+// Ver ssd1306_mock.h. As transações são aplicadas inteiras, na ordem, quando
+// o relógio do barramento passa pelo último byte delas.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ssd1306_mock.h"
+
+static ssd1306_mock_t *s_mock;       // i2c_write_blocking não recebe contexto
+
+static void violation(ssd1306_mock_t *m, const char *what) {
+    m->violations++;
+    printf("mock: VIOLAÇÃO: %s (transferência %lu)\n", what, (unsigned long)m->transfers);
+}
+
+static uint32_t txn_us(size_t len) {
+    return (uint32_t)((len + 1) * MOCK_NS_PER_BYTE / 1000);   // + byte de endereço
+}
+
+// argumentos de cada comando usado pelo driver (os demais não têm)
+static int cmd_args(uint8_t c) {
+    switch (c) {
+    case SET_COL_ADDR: case SET_PAGE_ADDR:
+        return 2;
+    case SET_CONTRAST: case SET_MEM_ADDR: case SET_MUX_RATIO: case SET_DISP_OFFSET:
+    case SET_COM_PIN_CFG: case SET_DISP_CLK_DIV: case SET_PRECHARGE: case SET_VCOM_DESEL:
+    case SET_CHARGE_PUMP:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// uma transação: byte de controle + comandos ou dados
+static void mock_txn(ssd1306_mock_t *m, const uint8_t *b, size_t n) {
+    if (n < 2) {
+        violation(m, "transação sem conteúdo");
+        return;
+    }
+    m->bytes += (uint32_t)n + 1;
+
+    if (b[0] == 0x00) {
+        bool col = false, page = false;
+        for (size_t i = 1; i < n; ) {
+            uint8_t c = b[i];
+            int k = cmd_args(c);
+            if (i + (size_t)k >= n) {
+                violation(m, "comando cortado pelo STOP");
+                return;
+            }
+            if (c == SET_COL_ADDR) {
+                m->c0 = b[i + 1] & 127; m->c1 = b[i + 2] & 127; m->col = m->c0; col = true;
+            } else if (c == SET_PAGE_ADDR) {
+                m->p0 = b[i + 1] & 7; m->p1 = b[i + 2] & 7; m->page = m->p0; page = true;
+            } else if (c == SET_MEM_ADDR && b[i + 1] != 0x00) {
+                violation(m, "modo de endereçamento não horizontal");
+            }
+            i += 1 + (size_t)k;
+        }
+        if (col != page) {
+            violation(m, "janela com só colunas ou só páginas");
+        } else if (col) {
+            if (m->c1 < m->c0 || m->p1 < m->p0) violation(m, "janela invertida");
+            m->window_set = true;
+            m->data_left = (uint32_t)(m->c1 - m->c0 + 1) * (m->p1 - m->p0 + 1);
+        }
+    } else if (b[0] == 0x40) {
+        if (!m->window_set) violation(m, "dados sem janela antes");
+        else if (n - 1 != m->data_left) violation(m, "dados não fecham a janela");
+        for (size_t i = 1; i < n; i++) {
+            m->ram[m->page][m->col] = b[i];
+            if (++m->col > m->c1) {
+                m->col = m->c0;
+                if (++m->page > m->p1) m->page = m->p0;
+            }
+        }
+        m->window_set = false;
+    } else {
+        violation(m, "byte de controle desconhecido");
+    }
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c;
+    ssd1306_mock_t *m = s_mock;
+    if (!m) return PICO_ERROR_GENERIC;
+    if (m->words) violation(m, "escrita bloqueante com DMA em curso");
+    if (nostop) violation(m, "escrita sem STOP");
+    if (m->p && addr != m->p->address) return PICO_ERROR_GENERIC;
+    mock_txn(m, src, len);
+    m->bus_us += txn_us(len);
+    return (int)len;
+}
+
+/* ---------- Transporte assíncrono ---------- */
+
+static bool mock_start(void *ctx, uint8_t addr, const uint16_t *words, size_t n) {
+    ssd1306_mock_t *m = ctx;
+    if (m->words) violation(m, "start() com transferência em curso");
+    if (addr != m->p->address) violation(m, "endereço errado");
+    if (!n || !(words[n - 1] & SSD1306_WORD_STOP)) violation(m, "quadro não termina em STOP");
+    for (size_t i = 0; i < n; i++)
+        if (words[i] & ~(uint16_t)(0xFF | SSD1306_WORD_STOP)) {
+            violation(m, "palavra com bits além de dado/STOP");
+            break;
+        }
+    m->transfers++;
+    m->words = words;
+    m->n = n;
+    m->pos = 0;
+    m->addr = addr;
+    m->failed = false;
+    m->window_set = false;
+    if (m->nack_in > 0 && --m->nack_in == 0) m->failed = true;
+    return true;
+}
+
+static void mock_abort(void *ctx) {
+    ssd1306_mock_t *m = ctx;
+    m->words = NULL;                 // como desligar o controlador: FIFO vai fora
+    m->stuck = false;
+}
+
+static void mock_finish(ssd1306_mock_t *m) {
+    bool ok = !m->failed;
+    m->words = NULL;                 // antes: o callback pode iniciar o próximo
+    ssd1306_flush_done(m->p, ok);
+    // nada mais no barramento: o painel tem de ser o que o driver acha que é
+    if (!m->words && m->p->shadow_valid &&
+        !ssd1306_mock_matches(m, m->p->shadow))
+        violation(m, "painel difere da sombra do driver");
+}
+
+void ssd1306_mock_advance(ssd1306_mock_t *m, uint32_t us) {
+    m->budget_us += us;
+    while (m->words && !m->stuck) {
+        if (m->failed) {             // NACK no endereço: aborta tudo na hora
+            m->bus_us += txn_us(0);
+            m->budget_us = 0;
+            mock_finish(m);
+            continue;
+        }
+        size_t end = m->pos;
+        while (end < m->n && !(m->words[end] & SSD1306_WORD_STOP)) end++;
+        if (end == m->n) {
+            violation(m, "transação sem STOP no fim do quadro");
+            end = m->n - 1;
+        }
+        size_t len = end - m->pos + 1;
+        uint32_t cost = txn_us(len);
+        if (m->budget_us < cost) return;
+        m->budget_us -= cost;
+        m->bus_us += cost;
+
+        uint8_t b[1 + 128 * 8];
+        if (len > sizeof b) {
+            violation(m, "transação maior que a RAM do painel");
+            len = sizeof b;
+        }
+        for (size_t i = 0; i < len; i++) b[i] = (uint8_t)m->words[m->pos + i];
+        mock_txn(m, b, len);
+        m->pos = end + 1;
+        if (m->pos >= m->n) mock_finish(m);
+    }
+    if (!m->words) m->budget_us = 0;  // barramento ocioso não acumula crédito
+}
+
+void ssd1306_mock_drain(ssd1306_mock_t *m) {
+    while (m->words && !m->stuck) ssd1306_mock_advance(m, 1000);
+}
+
+bool ssd1306_mock_matches(const ssd1306_mock_t *m, const uint8_t *buf) {
+    for (uint8_t pg = 0; pg < m->p->pages; pg++)
+        if (memcmp(m->ram[pg], buf + pg * m->p->width, m->p->width)) return false;
+    return true;
+}
+
+void ssd1306_mock_init(ssd1306_mock_t *m, ssd1306_t *p) {
+    memset(m, 0, sizeof *m);
+    m->p = p;
+    m->bus = (ssd1306_bus_t){ mock_start, mock_abort, m };
+    m->c1 = 127;
+    m->p1 = 7;
+    s_mock = m;
+}
+
+/* ---------- Imagens do painel ---------- */
+
+static bool lit(const ssd1306_mock_t *m, unsigned x, unsigned y) {
+    return m->ram[y >> 3][x] >> (y & 7) & 1;
+}
+
+// uma linha do P4: 1 = preto, então pixel aceso vira 0
+static void pbm_row(const ssd1306_mock_t *m, unsigned y, uint8_t *row) {
+    memset(row, 0, 16);
+    for (unsigned x = 0; x < 128; x++)
+        if (!lit(m, x, y)) row[x >> 3] |= 0x80 >> (x & 7);
+}
+
+bool ssd1306_mock_write_pbm(const ssd1306_mock_t *m, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P4\n128 64\n");
+    for (unsigned y = 0; y < 64; y++) {
+        uint8_t row[16];
+        pbm_row(m, y, row);
+        fwrite(row, 1, sizeof row, f);
+    }
+    return fclose(f) == 0;
+}
+
+int ssd1306_mock_diff_pbm(const ssd1306_mock_t *m, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    int w = 0, h = 0, diff = 0;
+    if (fscanf(f, "P4 %d %d", &w, &h) != 2 || w != 128 || h != 64 || fgetc(f) == EOF) {
+        fclose(f);
+        return -1;
+    }
+    for (unsigned y = 0; y < 64; y++) {
+        uint8_t row[16], want[16];
+        pbm_row(m, y, row);
+        if (fread(want, 1, sizeof want, f) != sizeof want) {
+            fclose(f);
+            return -1;
+        }
+        for (unsigned i = 0; i < 16; i++)
+            diff += __builtin_popcount(row[i] ^ want[i]);
+    }
+    fclose(f);
+    return diff;
+}
+
+// PNG sem zlib: deflate com blocos "stored" (sem compressão)
+static uint32_t s_crc_tab[256];
+
+static uint32_t crc32_upd(uint32_t crc, const uint8_t *p, size_t n) {
+    if (!s_crc_tab[1])
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            s_crc_tab[i] = c;
+        }
+    for (size_t i = 0; i < n; i++) crc = s_crc_tab[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, size_t n) {
+    uint8_t b[4];
+    put32(b, (uint32_t)n);
+    fwrite(b, 1, 4, f);
+    fwrite(type, 1, 4, f);
+    if (n) fwrite(data, 1, n, f);
+    uint32_t crc = crc32_upd(0xFFFFFFFFu, (const uint8_t *)type, 4);
+    put32(b, ~crc32_upd(crc, data, n));
+    fwrite(b, 1, 4, f);
+}
+
+bool ssd1306_mock_write_png(const ssd1306_mock_t *m, const char *path, unsigned scale) {
+    if (scale < 1) scale = 1;
+    unsigned w = 128 * scale, h = 64 * scale;
+    size_t raw_n = (size_t)(w + 1) * h;          // byte de filtro + pixels, por linha
+    size_t blocks = (raw_n + 65534) / 65535;
+    uint8_t *raw = malloc(raw_n);
+    uint8_t *z = malloc(2 + raw_n + 5 * blocks + 4);
+    if (!raw || !z) {
+        free(raw);
+        free(z);
+        return false;
+    }
+
+    for (unsigned y = 0; y < h; y++) {
+        uint8_t *r = raw + (size_t)y * (w + 1);
+        r[0] = 0;
+        for (unsigned x = 0; x < w; x++) r[1 + x] = lit(m, x / scale, y / scale) ? 0xFF : 0x00;
+    }
+
+    size_t zn = 0;
+    z[zn++] = 0x78;
+    z[zn++] = 0x01;
+    uint32_t a = 1, b = 0;                       // adler32
+    for (size_t off = 0; off < raw_n; ) {
+        size_t len = raw_n - off > 65535 ? 65535 : raw_n - off;
+        z[zn++] = off + len == raw_n;            // BFINAL, BTYPE=00
+        z[zn++] = len & 0xFF;
+        z[zn++] = len >> 8;
+        z[zn++] = ~len & 0xFF;
+        z[zn++] = (~len >> 8) & 0xFF;
+        memcpy(z + zn, raw + off, len);
+        for (size_t i = 0; i < len; i++) {
+            a = (a + raw[off + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        zn += len;
+        off += len;
+    }
+    put32(z + zn, b << 16 | a);
+    zn += 4;
+
+    uint8_t ihdr[13];
+    put32(ihdr, w);
+    put32(ihdr + 4, h);
+    ihdr[8] = 8;                                 // 8 bits, cinza, sem entrelaçar
+    ihdr[9] = ihdr[10] = ihdr[11] = ihdr[12] = 0;
+
+    FILE *f = fopen(path, "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+        png_chunk(f, "IHDR", ihdr, sizeof ihdr);
+        png_chunk(f, "IDAT", z, zn);
+        png_chunk(f, "IEND", NULL, 0);
+        ok = fclose(f) == 0;
+    }
+    free(raw);
+    free(z);
+    return ok;
+}
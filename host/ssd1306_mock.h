@@ -0,0 +1,58 @@
+// Barramento I2C falso para o driver do SSD1306 no host: decodifica o que o
+// driver manda (escritas bloqueantes e quadros assíncronos) numa RAM de
+// painel 128x64 e confere a ordem do protocolo. Ver host/oled_host.c.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ssd1306.h"
+
+#define MOCK_I2C_HZ        400000u
+#define MOCK_NS_PER_BYTE   (9ull * 1000000000u / MOCK_I2C_HZ)   // 8 bits + ACK
+
+typedef struct {
+    ssd1306_t     *p;
+    ssd1306_bus_t  bus;              // para ssd1306_async_init
+
+    uint8_t  ram[8][128];            // GDDRAM do painel
+    uint8_t  c0, c1, p0, p1;         // janela de endereçamento
+    uint8_t  col, page;              // ponteiro dentro da janela
+    bool     window_set;             // comandos de janela desde o último dado
+    uint32_t data_left;              // bytes até preencher a janela
+
+    // transferência assíncrona em curso
+    const uint16_t *words;
+    size_t   n, pos;
+    uint8_t  addr;
+    bool     failed;
+    uint32_t budget_us;              // tempo de barramento ainda não gasto
+
+    // injeção de falhas
+    int32_t  nack_in;                // >0: NACK no n-ésimo start() daqui em diante
+    bool     stuck;                  // barramento preso: nada anda
+
+    // contadores
+    uint32_t transfers, bytes, bus_us, violations;
+} ssd1306_mock_t;
+
+// liga o mock ao display; depois: ssd1306_init e ssd1306_async_init(p, &m->bus, ...)
+void ssd1306_mock_init(ssd1306_mock_t *m, ssd1306_t *p);
+
+// avança o relógio do barramento; termina transferências (ssd1306_flush_done)
+void ssd1306_mock_advance(ssd1306_mock_t *m, uint32_t us);
+
+// avança até não haver quadro no barramento nem esperando
+void ssd1306_mock_drain(ssd1306_mock_t *m);
+
+// o painel mostra o buffer do driver?
+bool ssd1306_mock_matches(const ssd1306_mock_t *m, const uint8_t *buf);
+
+// Imagem do painel como ele aparece (pixel aceso = branco). PBM binário
+// (P4) 1:1, ou PNG cinza de 8 bits ampliado scale vezes. false se não
+// conseguiu gravar.
+bool ssd1306_mock_write_pbm(const ssd1306_mock_t *m, const char *path);
+bool ssd1306_mock_write_png(const ssd1306_mock_t *m, const char *path, unsigned scale);
+
+// compara o painel com um PBM gravado por ssd1306_mock_write_pbm; devolve
+// os pixels diferentes, ou -1 se o arquivo não existe ou não é um P4 128x64
+int ssd1306_mock_diff_pbm(const ssd1306_mock_t *m, const char *path);
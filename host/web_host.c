@@ -0,0 +1,129 @@
+// Pilha web do TheraLink rodando no Linux: web_ap.c + DHCP/DNS sobre uma tap
+// (porta unix do lwIP, NO_SYS). O oxímetro e o laço principal do firmware são
+// simulados aqui: BPM, check-ins e linhas do OLED mudam a cada segundo para
+// o SSE/WS terem o que empurrar. Ver host/CMakeLists.txt.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+#include "netif/tapif.h"
+
+#include "web_ap.h"
+#include "stats.h"
+#include "oximetro.h"
+#include "i2c_bus.h"
+#include "stackmark.h"
+
+// lwIP 2.1 chamava de tapif_select() o que o 2.2 chama de tapif_poll()
+#if LWIP_VERSION_MAJOR == 2 && LWIP_VERSION_MINOR < 2
+#define tapif_poll(n) ((void)tapif_select(n))
+#endif
+
+#define SIM_TICK_MS   1000
+#define WAVE_HZ       25
+#define WAVE_RING     256        // como o anel do oximetro.c: só o recente
+
+static struct netif s_netif;
+static uint32_t     s_t0_us;
+static float        s_bpm = 72.f;
+
+/* ---------- Oxímetro simulado (o que web_ap.c consulta) ---------- */
+static uint32_t wave_head(void) {
+    return (time_us_32() - s_t0_us) / (1000000u / WAVE_HZ);
+}
+
+float oxi_get_bpm_live(void) { return s_bpm; }
+float oxi_get_quality(void)  { return 0.9f; }
+
+uint32_t oxi_wave_read(uint32_t *cursor, int16_t *dst, uint32_t max) {
+    uint32_t head = wave_head();
+    uint32_t from = *cursor;
+    if (head - from > WAVE_RING) from = head - WAVE_RING;
+    uint32_t n = head - from;
+    if (n > max) n = max;
+    for (uint32_t i = 0; i < n; i++) {
+        float t = (float)(from + i) / WAVE_HZ;
+        dst[i] = (int16_t)(800.f * sinf(2.f * (float)M_PI * t * s_bpm / 60.f));
+    }
+    *cursor = from + n;
+    return n;
+}
+
+/* ---------- I2C simulado: sem barramento, o i2c_bus.c só contabiliza ---------- */
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us) {
+    (void)i2c; (void)addr; (void)src; (void)len; (void)nostop; (void)timeout_us;
+    return PICO_ERROR_GENERIC;
+}
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us) {
+    (void)i2c; (void)addr; (void)dst; (void)len; (void)nostop; (void)timeout_us;
+    return PICO_ERROR_GENERIC;
+}
+
+static i2c_dev_t s_oxi_dev;       // para o /metrics ter as famílias i2c_*
+
+/* Sem linker script do RP2040: nada a medir */
+void     stackmark_paint(void)     {}
+uint32_t stackmark_free_min(void)  { return UINT32_MAX; }
+
+/* ---------- "Laço principal" simulado ---------- */
+static void sim_tick(void *arg) {
+    (void)arg;
+    static uint32_t n = 0;
+    n++;
+    s_bpm = 68.f + (float)(rand() % 120) / 10.f;
+    stats_add_bpm(s_bpm);
+    for (int i = 0; i < 50; i++) i2c_dev_account(&s_oxi_dev, rand() % 500 != 0, 420u + (uint32_t)(rand() % 80));
+    if (n % 5 == 0) stats_inc_color((stat_color_t)(rand() % STAT_COLOR_COUNT));
+
+    char l1[24], l3[24];
+    snprintf(l1, sizeof l1, "BPM: %.1f", (double)s_bpm);
+    snprintf(l3, sizeof l3, "host t=%lus", (unsigned long)n);
+    web_display_set_lines(l1, "Simulado", l3, "");
+
+    // Sem o driver do OLED aqui: um quadro qualquer que muda pouco por
+    // segundo (uma coluna por BPM, rolando) para o /fb.bin ter delta
+    static uint8_t fb[1024];
+    uint32_t x = n % 128, h = (uint32_t)(s_bpm - 60.f);     // 8..20 px
+    for (uint32_t pg = 0; pg < 8; pg++) {
+        uint32_t top = 64 - h, y0 = pg * 8;
+        uint8_t col = 0;
+        for (uint32_t b = 0; b < 8; b++) if (y0 + b >= top) col |= (uint8_t)(1u << b);
+        fb[pg * 128 + x] = col;
+    }
+    web_display_set_fb(fb, sizeof fb);
+
+    sys_timeout(SIM_TICK_MS, sim_tick, NULL);
+}
+
+int main(void) {
+    s_t0_us = time_us_32();
+    lwip_init();
+
+    // 192.168.4.1 como no AP; o lado Linux da tap fica em 192.168.4.254
+    ip4_addr_t ip, mask, gw;
+    IP4_ADDR(&ip,   192, 168, 4, 1);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw,   192, 168, 4, 254);
+    if (!netif_add(&s_netif, &ip, &mask, &gw, NULL, tapif_init, netif_input)) {
+        printf("tap: netif_add falhou\n");
+        return 1;
+    }
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+
+    stats_init();
+    i2c_dev_init(&s_oxi_dev, i2c_bus_open(NULL, 0, 1, 100000), 0x57, "max3010x");
+    web_stack_start();
+    sys_timeout(SIM_TICK_MS, sim_tick, NULL);
+
+    for (;;) {
+        tapif_poll(&s_netif);
+        sys_check_timeouts();
+    }
+}
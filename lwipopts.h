@@ -21,6 +21,10 @@
 #define MEM_ALIGNMENT               4
 #define MEM_SIZE                    4000
 #define MEMP_NUM_TCP_SEG            32
+// HTTP keep-alive: até 10 clientes persistentes + pcbs em FIN_WAIT/TIME_WAIT
+#define MEMP_NUM_TCP_PCB            16
+// pbufs de referência das respostas estáticas (tcp_write sem cópia, direto da flash)
+#define MEMP_NUM_PBUF               32
 #define MEMP_NUM_ARP_QUEUE          10
 #define PBUF_POOL_SIZE              24
 #define LWIP_ARP                    1
@@ -35,10 +39,14 @@
 #define LWIP_NETIF_LINK_CALLBACK    1
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETCONN                0
-#define MEM_STATS                   0
+// MEM/MEMP: ocupação do heap e dos pools exportada em /metrics (web_ap.c)
+#define LWIP_STATS                  1
+#define MEM_STATS                   1
 #define SYS_STATS                   0
-#define MEMP_STATS                  0
+#define MEMP_STATS                  1
 #define LINK_STATS                  0
+// MIB2: tcpretranssegs para o teste de vazão (/bench)
+#define MIB2_STATS                  1
 // #define ETH_PAD_SIZE                2
 #define LWIP_CHKSUM_ALGORITHM       3
 #define LWIP_DHCP                   1
@@ -53,7 +61,6 @@
 
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
-#define LWIP_STATS                  1
 #define LWIP_STATS_DISPLAY          1
 #endif
 
@@ -10,23 +10,35 @@
 
 #include "src/ssd1306.h"
 #include "src/ssd1306_i2c.h"
+#include "src/ssd1306_dma.h"
+#include "src/oled_scope.h"
 #include "src/ssd1306_font.h"
 
+#include "src/i2c_bus.h"
 #include "src/cor.h"
+#include "src/cor_calib.h"
+#include "src/cor_flash.h"
+#include "src/cor_vote.h"
 #include "src/oximetro.h"
 #include "src/stats.h"
 #include "src/web_ap.h"
+#include "src/stackmark.h"
+#include "src/fmt.h"
 
 // ==== OLED em I2C1 (BitDog) ====
 #define OLED_I2C   i2c1
 #define OLED_SDA   14
 #define OLED_SCL   15
 #define OLED_ADDR  0x3C
+#define OLED_REPORT_FRAMES    50   // ~10 s medindo (um quadro a cada 200 ms)
+// ssd1306_show antigo: 6 comandos avulsos (end + 0x00 + cmd) e o 1 KB inteiro
+#define OLED_FULL_FRAME_BYTES (6 * 3 + 128 * 64 / 8 + 2)
 
 // ==== SENSORES no I2C0 (EXTENSOR) ====
 #define COL_I2C    i2c0   // TCS34725
 #define COL_SDA    0
 #define COL_SCL    1
+// #define COL_INT  2     // INT do TCS34725, se ligado (sem ele o cor.c consulta o STATUS)
 
 #define OXI_I2C    i2c0   // MAX3010x
 #define OXI_SDA    0
@@ -41,34 +53,155 @@
 
 static ssd1306_t oled;
 static bool oled_ok = false;
-
-// --- Detecção robusta de cor ---
-static bool     color_baseline_ready = false;
-static uint32_t color_baseline_until = 0;
-static float    c0_r=0.f, c0_g=0.f, c0_b=0.f, c0_c=0.f;
-static uint32_t c0_n = 0;
+static i2c_bus_t *oled_bus;
+static i2c_dev_t  oled_dev;              // contadores do /metrics (quadros por DMA)
+
+// Traço do PPG enquanto mede: páginas 1..6 (48 px) entre as linhas de texto.
+// 1500 B/s ~ 34 ms/s do I2C1 a 400 kHz (o oxímetro está no I2C0).
+#define OLED_SCOPE_PAGE0       1
+#define OLED_SCOPE_PAGE1       6
+#define OLED_SCOPE_BUDGET_BPS  1500
+#define OLED_SCOPE_READ        16
+static oled_scope_t scope;
+static bool     scope_on = false;
+static uint32_t scope_cursor = 0;
+static uint32_t scope_t0_ms = 0, scope_b0 = 0;
+
+// --- Detecção robusta de cor (a média do ambiente fica no cor.c) ---
+static cor_sample_t cor_last;             // última integração nova do sensor
+static bool         cor_have = false;
+#define COR_STALE_MS 1000                 // sem integração nova há mais que isso: "Sem leitura"
 
 #define C_MIN        0.06f
 #define CHROMA_MIN   0.14f
 #define DELTA_C_MIN  0.25f
 
-static void i2c_setup(i2c_inst_t *i2c, uint sda, uint scl, uint hz) {
-    i2c_init(i2c, hz);
-    gpio_set_function(sda, GPIO_FUNC_I2C);
-    gpio_set_function(scl, GPIO_FUNC_I2C);
-    gpio_pull_up(sda);
-    gpio_pull_up(scl);
+// Pulseira na frente do sensor: luz, diferença do ambiente e croma suficientes
+static bool cor_presente(const cor_sample_t *s) {
+    float maxc=fmaxf(s->rn,fmaxf(s->gn,s->bn));
+    float minc=fminf(s->rn,fminf(s->gn,s->bn));
+    float chroma=maxc-minc;
+    float deltaC=cor_ambient_delta_c(s->c_ref);
+    return s->c_ref>C_MIN && deltaC>DELTA_C_MIN && chroma>CHROMA_MIN;
+}
+
+// Perfil calibrado (flash) se houver; senão os limiares do cor_classify
+static cor_profile_t cor_perfil;
+static bool          cor_perfil_ok = false;
+
+static cor_class_t classificar(const cor_sample_t *s) {
+    if (cor_perfil_ok) return cor_cal_classify(&cor_perfil, s->r, s->g, s->b, NULL);
+    return cor_classify(s->rn, s->gn, s->bn, s->c_ref);
+}
+
+// Validação sem botão: votação sobre as integrações (cor_vote.c). Tempo até
+// confirmar, por pessoa: desde a tela e desde a primeira leitura da pulseira.
+#define COR_AVISO_MS 1500                 // "Pulseira incorreta" fica na tela
+static cor_vote_t cor_voto;
+static uint32_t   cor_t_tela = 0, cor_t_pulseira = 0;
+static uint32_t   cor_aviso_ate = 0;
+static uint32_t   cor_confirmadas = 0, cor_soma_tela_ms = 0, cor_soma_pulseira_ms = 0;
+
+// Calibração: segurar B no menu; uma pulseira de cada vez sob a luz do local
+#define CALIB_HOLD_MS 2000
+static const struct { cor_class_t cls; const char *rotulo; } k_calib[] = {
+    { COR_VERDE, "verde" }, { COR_AMARELO, "amarelo" }, { COR_VERMELHO, "vermelho" },
+};
+#define CALIB_COUNT (int)(sizeof k_calib / sizeof k_calib[0])
+static cor_profile_t calib_prof;
+static cor_cal_acc_t calib_acc;
+static int           calib_idx = 0;
+static bool          calib_lendo = false;
+
+// Fim de cada quadro por DMA (IRQ): latência e erro no dispositivo do OLED
+static void oled_flush_done(ssd1306_t *p, bool ok) {
+    static uint32_t us_prev = 0;
+    i2c_dev_account(&oled_dev, ok, p->stats.us - us_prev);
+    us_prev = p->stats.us;
+}
+
+// Quadro que falhou ou expirou pode ter deixado o SDA preso no I2C1: com o
+// DMA parado, recupera o barramento (o oxímetro e a cor fazem isso sozinhos
+// no i2c_bus)
+static void oled_bus_check(void) {
+    static uint32_t errors_seen = 0;
+    if (!oled_ok || oled.stats.errors == errors_seen || ssd1306_busy(&oled)) return;
+    errors_seen = oled.stats.errors;
+    if (i2c_bus_stuck(oled_bus)) i2c_dev_recover(&oled_dev);
 }
 
 static void oled_lines(const char *l1, const char *l2, const char *l3, const char *l4) {
     web_display_set_lines(l1, l2, l3, l4);
     if (!oled_ok) return;
+    scope_on = false;
     ssd1306_clear(&oled);
     if (l1) ssd1306_draw_string(&oled, 0,  0, 1, l1);
     if (l2) ssd1306_draw_string(&oled, 0, 16, 1, l2);
     if (l3) ssd1306_draw_string(&oled, 0, 32, 1, l3);
     if (l4) ssd1306_draw_string(&oled, 0, 48, 1, l4);
-    ssd1306_show(&oled);
+    ssd1306_show_async(&oled);   // volta já; o DMA leva o quadro ao painel
+    web_display_set_fb(oled.buffer, oled.bufsize);
+#ifndef NDEBUG
+    // Custo no barramento: só as páginas que mudaram x o quadro inteiro de antes
+    if (oled.stats.frames % OLED_REPORT_FRAMES == 0) {
+        uint32_t sent = oled.stats.frames - oled.stats.skipped;
+        printf("OLED: %lu quadros, %lu iguais, %lu agrupados, %lu erros; por quadro enviado %lu B, %lu us (antes: %u B sempre)\n",
+               (unsigned long)oled.stats.frames, (unsigned long)oled.stats.skipped,
+               (unsigned long)oled.stats.coalesced, (unsigned long)oled.stats.errors,
+               (unsigned long)(sent ? oled.stats.bytes / sent : 0),
+               (unsigned long)(sent ? oled.stats.us / sent : 0), OLED_FULL_FRAME_BYTES);
+    }
+#endif
+}
+
+// Tela de medição com o traço: texto só na página 0 e na 7, o resto é do
+// oled_scope. Quem chama atualiza o /display (web_display_set_lines).
+static void oled_scope_text(const char *top, const char *bottom, uint32_t now_ms) {
+    if (!oled_ok) return;
+    if (!scope_on) {
+        ssd1306_clear(&oled);
+        oled_scope_init(&scope, &oled, OLED_SCOPE_PAGE0, OLED_SCOPE_PAGE1, OLED_SCOPE_BUDGET_BPS);
+        scope_cursor = 0;                    // começa com o que o anel ainda tem
+        scope_t0_ms = now_ms;
+        scope_b0 = oled.stats.bytes;
+        scope_on = true;
+    }
+    memset(oled.buffer, 0, oled.width);
+    memset(oled.buffer + (oled.pages - 1) * oled.width, 0, oled.width);
+    ssd1306_draw_string(&oled, 0, 0, 1, top);
+    ssd1306_draw_string(&oled, 0, (oled.pages - 1) * 8, 1, bottom);
+    if (oled_scope_flush(&scope, now_ms)) web_display_set_fb(oled.buffer, oled.bufsize);
+#ifndef NDEBUG
+    uint32_t dt = now_ms - scope_t0_ms;
+    if (dt >= 10000) {
+        printf("OLED traço: %lu amostras, %lu envios, %lu adiados; %lu B/s (orçamento %u)\n",
+               (unsigned long)scope.samples, (unsigned long)scope.flushes, (unsigned long)scope.held,
+               (unsigned long)((oled.stats.bytes - scope_b0) * 1000u / dt), OLED_SCOPE_BUDGET_BPS);
+        scope_t0_ms = now_ms;
+        scope_b0 = oled.stats.bytes;
+    }
+#endif
+}
+
+// Amostras novas do PPG para o traço, a cada volta do laço
+static void oled_scope_poll(uint32_t now_ms) {
+    if (!scope_on) return;
+    int16_t w[OLED_SCOPE_READ];
+    uint32_t n = oxi_wave_read(&scope_cursor, w, OLED_SCOPE_READ);
+    for (uint32_t i = 0; i < n; i++) oled_scope_push(&scope, w[i]);
+    if (n && oled_scope_flush(&scope, now_ms)) web_display_set_fb(oled.buffer, oled.bufsize);
+}
+
+// TCS34725 ligado na primeira vez que a validação ou a calibração precisam
+static bool cor_ensure(void) {
+    static bool ok = false;
+    if (!ok) {
+        ok = cor_init(COL_I2C, COL_SDA, COL_SCL);
+#ifdef COL_INT
+        if (ok) cor_set_int_pin(COL_INT);
+#endif
+    }
+    return ok;
 }
 
 static bool edge_press(bool now, bool *prev) {
@@ -100,7 +233,8 @@ typedef enum {
     ST_COLOR_INTRO,
     ST_COLOR_LOOP,
     ST_SAVE_AND_DONE,
-    ST_REPORT
+    ST_REPORT,
+    ST_CALIB
 } state_t;
 
 static const char* cor_nome(stat_color_t c) {
@@ -120,20 +254,29 @@ static uint32_t survey_last_token = 0;
 static uint32_t survey_token_to_assign = 0;
 
 int main(void) {
+    stackmark_paint();
     stdio_init_all();
     sleep_ms(300);
 
-    i2c_setup(OLED_I2C, OLED_SDA, OLED_SCL, 400000);
+    oled_bus = i2c_bus_open(OLED_I2C, OLED_SDA, OLED_SCL, 400000);
+    i2c_dev_init(&oled_dev, oled_bus, OLED_ADDR, "ssd1306");
     oled.external_vcc = false;
     oled_ok = ssd1306_init(&oled, 128, 64, OLED_ADDR, OLED_I2C);
+    // Quadros por DMA: o laço não espera os ~25 us/byte do I2C. Sem canal
+    // livre, ssd1306_show_async cai no envio bloqueante.
+    if (oled_ok && !ssd1306_dma_attach(&oled, oled_flush_done))
+        printf("OLED: sem canal DMA, envio bloqueante\n");
 
     gpio_init(BUTTON_A); gpio_set_dir(BUTTON_A, GPIO_IN); gpio_pull_up(BUTTON_A);
     gpio_init(BUTTON_B); gpio_set_dir(BUTTON_B, GPIO_IN); gpio_pull_up(BUTTON_B);
     bool a_prev=false, b_prev=false;
+    uint32_t b_down_ms = 0;
 
     joystick_init();
 
     stats_init();
+    cor_perfil_ok = cor_flash_load(&cor_perfil);
+    printf("COR: %s\n", cor_perfil_ok ? "perfil calibrado da flash" : "sem calibracao, limiares fixos");
     web_ap_start();
 
     bool cor_ready = false;
@@ -147,11 +290,14 @@ int main(void) {
         bool a_edge = edge_press(!gpio_get(BUTTON_A), &a_prev);
         bool b_edge = edge_press(!gpio_get(BUTTON_B), &b_prev);
         bool joy_btn_edge = joystick_poll().btn_edge;
+        if (!b_prev) b_down_ms = 0;
+        else if (!b_down_ms) b_down_ms = now_ms;
+        oled_bus_check();
 
         if (st != last_st) {
             switch (st) {
                 case ST_ASK:
-                    oled_lines("Iniciar triagem?", "(A) Sim   (B) Nao", "Botao Joy: Relatorio", "");
+                    oled_lines("Iniciar triagem?", "(A) Sim   (B) Nao", "Botao Joy: Relatorio", "Segure B: calibrar");
                     break;
                 case ST_SURVEY_WAIT:
                     oled_lines("Aguardando envio", "Responda no celular", "[SURVEY]", "(B) Cancelar");
@@ -167,6 +313,7 @@ int main(void) {
                     oled_lines("Validar pulseira", "Aproxime a pulseira", "no sensor", "");
                     show_until_ms = now_ms + 5000;
                     break;
+
                 default: break;
             }
             last_st = st;
@@ -178,7 +325,6 @@ int main(void) {
                 if (!oxi_inited) {
                     bool ok = false;
                     for (int tries=0; tries<3 && !ok; tries++) {
-                        i2c_setup(OXI_I2C, OXI_SDA, OXI_SCL, 100000);
                         ok = oxi_init(OXI_I2C, OXI_SDA, OXI_SCL);
                         if (!ok) sleep_ms(200);
                     }
@@ -199,6 +345,20 @@ int main(void) {
             } else if (joy_btn_edge) {
                 st = ST_REPORT;
                 t_last = now_ms;
+            } else if (b_down_ms && now_ms - b_down_ms >= CALIB_HOLD_MS) {
+                b_down_ms = 0;
+                if (cor_ensure()) {
+                    cor_ambient_reset();
+                    cor_profile_init(&calib_prof);
+                    calib_idx = 0;
+                    calib_lendo = false;
+                    t_last = now_ms;
+                    st = ST_CALIB;
+                } else {
+                    oled_lines("TCS34725 nao encontrado", "Sem calibracao", "", "");
+                    sleep_ms(900);
+                    last_st = (state_t)-1;   // redesenha o menu
+                }
             }
             break;
 
@@ -210,6 +370,7 @@ int main(void) {
                 break;
             }
             oxi_poll(now_ms);
+            oled_scope_poll(now_ms);
             if (now_ms - t_last > 200) {
                 t_last = now_ms;
                 oxi_state_t s = oxi_get_state();
@@ -220,13 +381,17 @@ int main(void) {
                 } else if (s == OXI_RUN) {
                     int n,tgt; oxi_get_progress(&n,&tgt);
                     float live = oxi_get_bpm_live();
-                    char l2[22], l3[22];
-                    snprintf(l2, sizeof l2, "BPM~ %.1f", live);
+                    char l2[22], l3[22], v[FMT_NUM_MAX];
+                    fmt_fixed(v, live, 1);
+                    snprintf(l2, sizeof l2, "BPM~ %s", v);
                     snprintf(l3, sizeof l3, "Validas: %d/%d", n, tgt);
-                    oled_lines("Medindo...", l2, l3, "(B) Voltar");
+                    web_display_set_lines("Medindo...", l2, l3, "(B) Voltar");
+                    char top[24]; snprintf(top, sizeof top, "%s  %d/%d", l2, n, tgt);
+                    oled_scope_text(top, "Medindo... (B)Voltar", now_ms);
                 } else if (s == OXI_DONE) {
                     bpm_final_buf = oxi_get_bpm_final();
-                    char l2[22]; snprintf(l2, sizeof l2, "BPM FINAL: %.1f", bpm_final_buf);
+                    char l2[22], v[FMT_NUM_MAX]; fmt_fixed(v, bpm_final_buf, 1);
+                    snprintf(l2, sizeof l2, "BPM FINAL: %s", v);
                     oled_lines("Concluido!", l2, "", "");
                     show_until_ms = now_ms + 1500;
                     st = ST_SHOW_BPM;
@@ -318,20 +483,14 @@ int main(void) {
 
         case ST_TRIAGE_RESULT:
             if ((int32_t)(show_until_ms - now_ms) <= 0 || a_edge) {
-                static bool cor_ready_once=false;
-                if (!cor_ready_once) {
-                    i2c_setup(COL_I2C, COL_SDA, COL_SCL, 100000);
-                    cor_ready_once = cor_init(COL_I2C, COL_SDA, COL_SCL);
-                }
-                if (!cor_ready_once) {
+                if (!cor_ensure()) {
                     oled_lines("TCS34725 nao encontrado", "Pulando validacao", "", "");
                     sleep_ms(900);
                     stats_set_current_color((stat_color_t)STAT_COLOR_NONE);
                     st = ST_SAVE_AND_DONE;
                 } else {
-                    color_baseline_ready = false;
-                    color_baseline_until = now_ms + 800;
-                    c0_r = c0_g = c0_b = c0_c = 0.f; c0_n = 0;
+                    cor_ambient_reset();
+                    cor_have = false;
                     st = ST_COLOR_INTRO;
                 }
             }
@@ -340,87 +499,99 @@ int main(void) {
         case ST_COLOR_INTRO:
             if ((int32_t)(show_until_ms - now_ms) <= 0 || a_edge) {
                 t_last = now_ms;
+                cor_vote_reset(&cor_voto);
+                cor_t_tela = now_ms;
+                cor_t_pulseira = 0;
+                cor_aviso_ate = now_ms;
                 st = ST_COLOR_LOOP;
             }
             break;
 
         case ST_COLOR_LOOP: {
-            if (now_ms - t_last > 200) {
-                t_last = now_ms;
-
-                float rf,gf,bf,cf;
-                bool have = cor_read_rgb_norm(&rf,&gf,&bf,&cf);
-
-                if (!color_baseline_ready) {
-                    if (have) { c0_r+=rf; c0_g+=gf; c0_b+=bf; c0_c+=cf; c0_n++; }
-                    if ((int32_t)(color_baseline_until - now_ms) <= 0 && c0_n >= 3) {
-                        c0_r/= (float)c0_n; c0_g/= (float)c0_n; c0_b/= (float)c0_n; c0_c/= (float)c0_n;
-                        color_baseline_ready = true;
-                    }
-                    oled_lines("Validar pulseira", "Aproxime a pulseira", "no sensor", "Medindo ambiente...");
-                } else {
-                    if (have) {
-                        float maxc=fmaxf(rf,fmaxf(gf,bf));
-                        float minc=fminf(rf,fminf(gf,bf));
-                        float chroma=maxc-minc;
-                        float deltaC=(c0_c>1e-6f)? fabsf(cf-c0_c)/c0_c : 1.f;
-                        bool luz_ok=(cf>C_MIN), mudou_ok=(deltaC>DELTA_C_MIN), chroma_ok=(chroma>CHROMA_MIN);
-                        if (luz_ok && mudou_ok && chroma_ok) {
-                            cor_class_t cls=cor_classify(rf,gf,bf,cf);
-                            const char* nome=cor_class_to_str(cls);
-                            char l4[24]; snprintf(l4,sizeof l4,"Lido: %s  A=OK", nome);
-                            oled_lines("Validar pulseira","Aproxime e pressione A", l4, cor_nome(cor_recomendada));
-                        } else {
-                            oled_lines("Validar pulseira","Aproxime a pulseira","Leitura fraca...", cor_nome(cor_recomendada));
-                        }
-                    } else {
-                        oled_lines("Validar pulseira","Aproxime a pulseira","Sem leitura", cor_nome(cor_recomendada));
+            // Cada integração nova (o sensor dita o ritmo: 24..240 ms com a
+            // auto-exposição) é um voto; a cor confirma sozinha com
+            // COR_VOTE_N de COR_VOTE_M. A tela segue a cada 200 ms.
+            cor_sample_t cs;
+            bool novo = cor_poll(&cs);
+            if (novo) { cor_last = cs; cor_have = true; }
+            bool fresh = cor_have && now_ms - cor_last.t_ms < COR_STALE_MS;
+            bool aviso = (int32_t)(cor_aviso_ate - now_ms) > 0;
+
+            if (!fresh) {
+                cor_vote_reset(&cor_voto);
+                cor_t_pulseira = 0;
+            } else if (novo && cor_ambient_ready() && !aviso) {
+                cor_class_t cls = COR_DESCONHECIDA;
+                if (cor_presente(&cs)) {
+                    if (!cor_t_pulseira) cor_t_pulseira = now_ms;
+                    cls = classificar(&cs);
+                }
+                cor_class_t conf = cor_vote_push(&cor_voto, cls);
+                stat_color_t sc = STAT_COLOR_COUNT;
+                switch (conf) {
+                    case COR_VERDE:    sc=STAT_COLOR_VERDE;    break;
+                    case COR_AMARELO:  sc=STAT_COLOR_AMARELO;  break;
+                    case COR_VERMELHO: sc=STAT_COLOR_VERMELHO; break;
+                    default: break;
+                }
+                if (sc == cor_recomendada) {
+                    uint32_t ms_tela = now_ms - cor_t_tela, ms_pulseira = now_ms - cor_t_pulseira;
+                    cor_confirmadas++;
+                    cor_soma_tela_ms += ms_tela;
+                    cor_soma_pulseira_ms += ms_pulseira;
+                    printf("COR: %s confirmada em %lu ms com a pulseira (%u leituras), %lu ms na tela; media %lu / %lu ms em %lu\n",
+                           cor_nome(sc), (unsigned long)ms_pulseira, cor_voto.leituras, (unsigned long)ms_tela,
+                           (unsigned long)(cor_soma_pulseira_ms / cor_confirmadas),
+                           (unsigned long)(cor_soma_tela_ms / cor_confirmadas), (unsigned long)cor_confirmadas);
+
+                    char msg[26]; snprintf(msg, sizeof msg, "Pulseira %s ok!", cor_nome(sc));
+                    oled_lines(msg, "", "", "");
+
+                    // Vincula a submissão do survey à cor validada
+                    if (survey_last_token != 0) {
+                        web_assign_survey_token_to_color(survey_last_token, sc);
                     }
+
+                    stats_set_current_color(sc);
+                    st = ST_SAVE_AND_DONE;
+                    break;
+                }
+                if (sc != STAT_COLOR_COUNT) {
+                    // Outra pulseira confirmada: avisa sem travar o laço e recomeça
+                    oled_lines("Pulseira incorreta", "Pegue a pulseira:", cor_nome(cor_recomendada), "");
+                    cor_vote_reset(&cor_voto);
+                    cor_t_pulseira = 0;
+                    cor_aviso_ate = now_ms + COR_AVISO_MS;
+                    aviso = true;
                 }
             }
 
-            if (a_edge) {
-                if (!color_baseline_ready) { oled_lines("Aguarde...","Medindo ambiente","",""); sleep_ms(600); break; }
-                float rf,gf,bf,cf;
-                if (cor_read_rgb_norm(&rf,&gf,&bf,&cf)) {
-                    float maxc=fmaxf(rf,fmaxf(gf,bf));
-                    float minc=fminf(rf,fminf(gf,bf));
-                    float chroma=maxc-minc;
-                    float deltaC=(c0_c>1e-6f)? fabsf(cf-c0_c)/c0_c : 1.f;
-                    bool luz_ok=(cf>C_MIN), mudou_ok=(deltaC>DELTA_C_MIN), chroma_ok=(chroma>CHROMA_MIN);
-                    if (luz_ok && mudou_ok && chroma_ok) {
-                        cor_class_t cls=cor_classify(rf,gf,bf,cf);
-                        stat_color_t sc; bool ok=true;
-                        switch (cls) {
-                            case COR_VERDE:    sc=STAT_COLOR_VERDE;    break;
-                            case COR_AMARELO:  sc=STAT_COLOR_AMARELO;  break;
-                            case COR_VERMELHO: sc=STAT_COLOR_VERMELHO; break;
-                            default: ok=false; break;
-                        }
-                        if (ok && sc == cor_recomendada) {
-                            char msg[26]; snprintf(msg, sizeof msg, "Pulseira %s ok!", cor_nome(sc));
-                            oled_lines(msg, "", "", "");
-
-                            // Vincula a submissão do survey à cor validada
-                            if (survey_last_token != 0) {
-                                web_assign_survey_token_to_color(survey_last_token, sc);
-                            }
-
-                            stats_set_current_color(sc);
-                            st = ST_SAVE_AND_DONE;
-                        } else {
-                            oled_lines("Pulseira incorreta", "Pegue a pulseira:", cor_nome(cor_recomendada), "");
-                            sleep_ms(1000);
-                        }
+            if (!aviso && now_ms - t_last > 200) {
+                t_last = now_ms;
 
+                if (!cor_ambient_ready()) {
+                    oled_lines("Validar pulseira", "Aproxime a pulseira", "no sensor", "Medindo ambiente...");
+                } else if (fresh) {
+                    uint8_t votos;
+                    cor_class_t lider = cor_vote_leader(&cor_voto, &votos);
+                    if (cor_presente(&cor_last) && lider != COR_DESCONHECIDA) {
+                        char l3[24]; snprintf(l3, sizeof l3, "Lido: %s %u/%d", cor_class_to_str(lider), votos, COR_VOTE_N);
+                        oled_lines("Validar pulseira", "Segure parada", l3, cor_nome(cor_recomendada));
                     } else {
-                        oled_lines("Sem leitura","Aproxime melhor","","");
-                        sleep_ms(700);
+                        oled_lines("Validar pulseira","Aproxime a pulseira","Leitura fraca...", cor_nome(cor_recomendada));
                     }
                 } else {
-                    oled_lines("Falha na leitura","Tente novamente","","");
-                    sleep_ms(700);
+                    oled_lines("Validar pulseira","Aproxime a pulseira","Sem leitura", cor_nome(cor_recomendada));
+                }
+#ifndef NDEBUG
+                static uint32_t cor_report = 0;
+                if (++cor_report % 50 == 0) {
+                    cor_stats_t k; cor_get_stats(&k);
+                    printf("COR: %lu leituras, %lu consultas antes da hora, %lu erros, %lu trocas de exposicao; agora %u ms x%u\n",
+                           (unsigned long)k.samples, (unsigned long)k.not_ready, (unsigned long)k.errors,
+                           (unsigned long)k.exposure_changes, cor_last.integ_ms, cor_last.gain);
                 }
+#endif
             }
             break;
         }
@@ -439,10 +610,11 @@ int main(void) {
             if (now_ms - t_last > 1000) {
                 t_last = now_ms;
                 stats_snapshot_t s; stats_get_snapshot(&s);
-                char l1[22], l2[22], l3[22];
+                char l1[22], l2[22], l3[22], v[FMT_NUM_MAX];
                 float bpm = s.bpm_mean_trimmed;
                 if (isnan(bpm)) snprintf(l1,sizeof l1,"BPM: --");
-                else            snprintf(l1,sizeof l1,"BPM: %.1f (n=%lu)", bpm,(unsigned long)s.bpm_count);
+                else          { fmt_fixed(v, bpm, 1);
+                                snprintf(l1,sizeof l1,"BPM: %s (n=%lu)", v,(unsigned long)s.bpm_count); }
                 snprintf(l2,sizeof l2,"V:%lu A:%lu R:%lu Joy",
                         (unsigned long)s.cor_verde,
                         (unsigned long)s.cor_amarelo,
@@ -466,6 +638,59 @@ int main(void) {
             break;
         }
 
+        case ST_CALIB: {
+            cor_sample_t cs;
+            bool novo = cor_poll(&cs);
+            if (b_edge) {
+                oled_lines("Calibracao cancelada", "Perfil anterior", "mantido", "");
+                sleep_ms(900);
+                st = ST_ASK;
+                break;
+            }
+            if (calib_lendo && novo && cor_presente(&cs) && cor_cal_acc_add(&calib_acc, cs.r, cs.g, cs.b)) {
+#ifndef NDEBUG
+                // Mesmo formato do host/cor_corpus.csv (sem luz/fase)
+                printf("CRGB,%s,%u,%u,%u,%u,%u,%u\n", k_calib[calib_idx].rotulo,
+                       cs.c, cs.r, cs.g, cs.b, cs.gain, cs.integ_ms);
+#endif
+                if (calib_acc.n >= COR_CAL_SAMPLES) {
+                    cor_centroid_t c;
+                    if (cor_cal_acc_finish(&calib_acc, k_calib[calib_idx].cls, &c))
+                        cor_profile_add(&calib_prof, &c);
+                    calib_lendo = false;
+                    if (++calib_idx == CALIB_COUNT) {
+                        cor_profile_seal(&calib_prof);
+                        bool ok = cor_flash_save(&calib_prof);
+                        if (ok) { cor_perfil = calib_prof; cor_perfil_ok = true; }
+                        oled_lines(ok ? "Calibracao salva" : "Falha ao gravar", ok ? "Perfil em uso" : "Perfil anterior mantido", "", "");
+                        sleep_ms(900);
+                        st = ST_ASK;
+                        break;
+                    }
+                }
+            }
+
+            if (now_ms - t_last > 200) {
+                t_last = now_ms;
+                char l1[24], l2[24];
+                snprintf(l1, sizeof l1, "Calibrar cor %d/%d", calib_idx + 1, CALIB_COUNT);
+                snprintf(l2, sizeof l2, "Pulseira %s", cor_class_to_str(k_calib[calib_idx].cls));
+                if (!cor_ambient_ready()) {
+                    oled_lines("Calibrar cores", "Afaste tudo do", "sensor...", "(B) Cancelar");
+                } else if (!calib_lendo) {
+                    oled_lines(l1, l2, "no sensor e (A)", "(B) Cancelar");
+                } else {
+                    char l3[24]; snprintf(l3, sizeof l3, "Lendo %lu/%d", (unsigned long)calib_acc.n, COR_CAL_SAMPLES);
+                    oled_lines(l1, l2, l3, "Segure parada");
+                }
+            }
+            if (a_edge && cor_ambient_ready() && !calib_lendo) {
+                cor_cal_acc_reset(&calib_acc);
+                calib_lendo = true;
+            }
+            break;
+        }
+
         default: break;
         }
 
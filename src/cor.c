@@ -1,68 +1,174 @@
 #include "cor.h"
+#include "i2c_bus.h"
 #include <string.h>
 #include <math.h>
 
 // ---------- Estado interno ----------
-static i2c_inst_t *s_i2c = NULL;
-static uint8_t     s_addr = TCS34725_ADDR;
+static i2c_dev_t   s_dev;
+static bool        s_open = false;
+static int         s_int_pin = -1;
 
 // Bits de comando do TCS34725
 #define CMD_BIT     0x80
 #define CMD_AUTOINC 0x20
+#define CMD_SF_CLR  0x66   // função especial: limpa a interrupção RGBC
 
 // Registradores
 #define REG_ENABLE   0x00
 #define REG_ATIME    0x01
+#define REG_PERS     0x0C
 #define REG_CONTROL  0x0F
 #define REG_ID       0x12
+#define REG_STATUS   0x13   // logo antes de CDATAL: STATUS + dados numa leitura só
 #define REG_CDATAL   0x14   // sequência: C, R, G, B (16b cada, little-endian)
 
+#define ENABLE_PON   0x01
+#define ENABLE_AEN   0x02
+#define ENABLE_AIEN  0x10
+#define STATUS_AVALID 0x01
+#define STATUS_AINT   0x10
+
+#define COR_POLL_MS        2     // entre consultas ao STATUS perto do fim da integração
+#define COR_RETRY_MS       50    // depois de erro no barramento
+
+// Auto-exposição: do menos ao mais sensível (ganho x ciclos de 2,4 ms). Luz
+// forte desce para 24 ms (leitura ~4x mais frequente que os 103 ms fixos de
+// antes); sala escura sobe para 60x. Começa no antigo fixo (16x, ATIME 0xD5).
+typedef struct { uint8_t again; uint8_t cycles; } cor_exp_t;
+static const cor_exp_t k_exp[] = {
+    { 0, 10 },    //  1x,  24 ms
+    { 1, 10 },    //  4x,  24 ms
+    { 2, 10 },    // 16x,  24 ms
+    { 2, 21 },    // 16x,  50 ms
+    { 2, 43 },    // 16x, 103 ms
+    { 3, 43 },    // 60x, 103 ms
+    { 3, 100 },   // 60x, 240 ms
+};
+#define COR_EXP_COUNT (int)(sizeof k_exp / sizeof k_exp[0])
+#define COR_EXP_REF   4
+static const uint8_t k_gain[4] = { 1, 4, 16, 60 };
+// Passo a passo: desce perto da saturação; sobe só se a previsão no passo
+// seguinte fica abaixo da metade do limite de descida (histerese)
+#define COR_EXP_HIGH 0.80f
+#define COR_EXP_LOW  0.40f
+
+static int      s_exp = COR_EXP_REF;
+static bool     s_discard = false;     // integração em curso começou na exposição anterior
+static uint32_t s_next_ms = 0;
+static cor_stats_t s_stats;
+
+// Média do ambiente (c_ref): média simples no aquecimento, depois EMA lenta
+// (constante de tempo em ms, não em amostras: a taxa muda com a exposição)
+// só com leituras perto dela
+#define COR_AMB_WARMUP_MS 800
+#define COR_AMB_MIN_N     3
+#define COR_AMB_TRACK     0.10f  // |Δc| relativo abaixo disso ainda é ambiente
+#define COR_AMB_TAU_MS    5000.f
+static float    s_amb_c = 0.f;
+static uint32_t s_amb_n = 0;
+static uint32_t s_amb_t0 = 0;
+static bool     s_amb_ready = false;
+
+static inline uint32_t now_ms(void) { return to_ms_since_boot(get_absolute_time()); }
+
 static inline bool wr8(uint8_t reg, uint8_t val) {
     uint8_t b[2] = { (uint8_t)(CMD_BIT | reg), val };
-    return i2c_write_blocking(s_i2c, s_addr, b, 2, false) == 2;
+    return i2c_dev_write(&s_dev, b, 2);
 }
 static inline bool rd(uint8_t reg, uint8_t *dst, size_t n) {
     uint8_t r = (uint8_t)(CMD_BIT | ((n>1) ? CMD_AUTOINC : 0) | reg);
-    if (i2c_write_blocking(s_i2c, s_addr, &r, 1, true) != 1) return false;
-    return i2c_read_blocking (s_i2c, s_addr, dst, n, false) == (int)n;
+    return i2c_dev_read(&s_dev, &r, 1, dst, n);
+}
+static inline bool clear_int(void) {
+    uint8_t c = CMD_BIT | CMD_SF_CLR;
+    return i2c_dev_write(&s_dev, &c, 1);
+}
+
+static inline uint16_t exp_integ_ms(int i) { return (uint16_t)((k_exp[i].cycles * 12u + 4u) / 5u); }
+static inline uint32_t exp_max_count(int i) {
+    uint32_t m = 1024u * k_exp[i].cycles;
+    return m > 65535u ? 65535u : m;
+}
+static inline float exp_product(int i) { return (float)k_gain[k_exp[i].again] * k_exp[i].cycles; }
+
+static bool exp_apply(int i) {
+    if (!wr8(REG_ATIME, (uint8_t)(256 - k_exp[i].cycles))) return false;
+    if (!wr8(REG_CONTROL, k_exp[i].again)) return false;
+    s_exp = i;
+    s_discard = true;
+    return true;
+}
+
+// Um passo por integração: o próximo dado já diz se precisa de outro
+static void exp_adjust(uint16_t c, uint16_t r, uint16_t g, uint16_t b) {
+    uint16_t peak = c;
+    if (r > peak) peak = r;
+    if (g > peak) peak = g;
+    if (b > peak) peak = b;
+    int next = s_exp;
+    if (peak > COR_EXP_HIGH * exp_max_count(s_exp)) {
+        if (s_exp > 0) next = s_exp - 1;
+    } else if (s_exp + 1 < COR_EXP_COUNT) {
+        float k = exp_product(s_exp + 1) / exp_product(s_exp);
+        if (peak * k < COR_EXP_LOW * exp_max_count(s_exp + 1)) next = s_exp + 1;
+    }
+    if (next != s_exp && exp_apply(next)) s_stats.exposure_changes++;
+}
+
+static void ambient_add(float c_ref, uint32_t t, uint16_t integ_ms) {
+    if (!s_amb_ready) {
+        s_amb_n++;
+        s_amb_c += (c_ref - s_amb_c) / (float)s_amb_n;
+        s_amb_ready = (int32_t)(t - s_amb_t0) >= COR_AMB_WARMUP_MS && s_amb_n >= COR_AMB_MIN_N;
+    } else if (fabsf(c_ref - s_amb_c) < COR_AMB_TRACK * s_amb_c) {
+        s_amb_c += (c_ref - s_amb_c) * (float)integ_ms / COR_AMB_TAU_MS;
+        s_amb_n++;
+    }
 }
 
 // ---------- API ----------
 bool cor_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin)
 {
-    s_i2c = i2c;
-
-    // I2C a 100 kHz (ou 400k se preferir)
-    i2c_init(s_i2c, 100 * 1000);
-    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
-    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
-    gpio_pull_up(sda_pin);
-    gpio_pull_up(scl_pin);
+    // I2C a 100 kHz; se o oxímetro já abriu o barramento, vale o dele
+    i2c_dev_init(&s_dev, i2c_bus_open(i2c, sda_pin, scl_pin, 100 * 1000), TCS34725_ADDR, "tcs34725");
 
     // Verifica ID do TCS34725 (datasheet: 0x44 ou 0x4D)
     uint8_t id = 0;
     if (!rd(REG_ID, &id, 1)) return false;
     if (!(id == 0x44 || id == 0x4D)) return false;
 
-    // Tempo de integração ~100ms (ATIME = 0xD5 => 43 * 2.4ms ≈ 103ms)
-    wr8(REG_ATIME, 0xD5);
+    // Exposição inicial = o antigo fixo: ~103 ms (ATIME 0xD5), ganho 16x
+    if (!exp_apply(COR_EXP_REF)) return false;
 
-    // Ganho 16x (CONTROL: 0x00=1x, 0x01=4x, 0x02=16x, 0x03=60x)
-    wr8(REG_CONTROL, 0x02);
+    // Persistência 0: AINT (e o pino INT) a cada integração, sem limiar.
+    // Vira o "dado novo" que o AVALID sozinho não dá (ele fica em 1)
+    wr8(REG_PERS, 0x00);
 
-    // Liga: PON depois AEN
-    wr8(REG_ENABLE, 0x01);         // PON
+    // Liga: PON depois AEN + AIEN
+    wr8(REG_ENABLE, ENABLE_PON);
     sleep_ms(3);
-    wr8(REG_ENABLE, 0x03);         // PON | AEN
+    wr8(REG_ENABLE, ENABLE_PON | ENABLE_AEN | ENABLE_AIEN);
+    clear_int();
 
-    // Pequeno tempo para primeira conversão
-    sleep_ms(5);
+    memset(&s_stats, 0, sizeof s_stats);
+    s_discard = false;
+    s_next_ms = now_ms() + exp_integ_ms(s_exp);
+    cor_ambient_reset();
+    s_open = true;
     return true;
 }
 
+void cor_set_int_pin(uint pin)
+{
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+    gpio_pull_up(pin);
+    s_int_pin = (int)pin;
+}
+
 bool cor_read_raw(uint16_t *clear, uint16_t *red, uint16_t *green, uint16_t *blue)
 {
-    if (!s_i2c) return false;
+    if (!s_open) return false;
     uint8_t d[8];
     if (!rd(REG_CDATAL, d, 8)) return false;
 
@@ -79,21 +185,79 @@ bool cor_read_raw(uint16_t *clear, uint16_t *red, uint16_t *green, uint16_t *blu
     return true;
 }
 
-bool cor_read_rgb_norm(float *r, float *g, float *b, float *c_norm)
+bool cor_poll(cor_sample_t *out)
 {
-    uint16_t c, rr, gg, bb;
-    if (!cor_read_raw(&c, &rr, &gg, &bb)) return false;
+    if (!s_open) return false;
+    uint32_t t = now_ms();
+    if (s_int_pin >= 0) {
+        if (gpio_get((uint)s_int_pin)) return false;      // INT ativo em baixo
+    } else if ((int32_t)(t - s_next_ms) < 0) {
+        return false;                                    // integração ainda em curso
+    }
+
+    // STATUS + C,R,G,B numa transação (auto-incremento de 0x13 a 0x1B)
+    uint8_t d[9];
+    if (!rd(REG_STATUS, d, sizeof d)) {
+        s_stats.errors++;
+        s_next_ms = t + COR_RETRY_MS;
+        return false;
+    }
+    if ((d[0] & (STATUS_AVALID | STATUS_AINT)) != (STATUS_AVALID | STATUS_AINT)) {
+        s_stats.not_ready++;
+        s_next_ms = t + COR_POLL_MS;
+        return false;
+    }
+    clear_int();
+    int exp = s_exp;
+    s_next_ms = t + exp_integ_ms(exp) - COR_POLL_MS;
+    if (s_discard) { s_discard = false; return false; }   // mistura das duas exposições
+
+    uint16_t c = (uint16_t)d[1] | ((uint16_t)d[2] << 8);
+    uint16_t r = (uint16_t)d[3] | ((uint16_t)d[4] << 8);
+    uint16_t g = (uint16_t)d[5] | ((uint16_t)d[6] << 8);
+    uint16_t b = (uint16_t)d[7] | ((uint16_t)d[8] << 8);
+    exp_adjust(c, r, g, b);
 
     float cf = (float)c;
     if (cf < 1.0f) cf = 1.0f;                // evita divisão por zero
+    float c_ref = (float)c * exp_product(COR_EXP_REF) / exp_product(exp);
+    ambient_add(c_ref, t, exp_integ_ms(exp));
+    s_stats.samples++;
 
-    if (r) *r = (float)rr / cf;
-    if (g) *g = (float)gg / cf;
-    if (b) *b = (float)bb / cf;
-    if (c_norm) *c_norm = (float)c;
+    if (out) {
+        out->c = c; out->r = r; out->g = g; out->b = b;
+        out->rn = (float)r / cf;
+        out->gn = (float)g / cf;
+        out->bn = (float)b / cf;
+        out->c_ref = c_ref;
+        out->integ_ms = exp_integ_ms(exp);
+        out->gain = k_gain[k_exp[exp].again];
+        out->t_ms = t;
+    }
     return true;
 }
 
+void cor_ambient_reset(void)
+{
+    s_amb_c = 0.f;
+    s_amb_n = 0;
+    s_amb_t0 = now_ms();
+    s_amb_ready = false;
+}
+
+bool cor_ambient_ready(void) { return s_amb_ready; }
+
+float cor_ambient_delta_c(float c_ref)
+{
+    if (!s_amb_ready || s_amb_c < 1e-6f) return 1.f;
+    return fabsf(c_ref - s_amb_c) / s_amb_c;
+}
+
+void cor_get_stats(cor_stats_t *out)
+{
+    if (out) *out = s_stats;
+}
+
 // Heurística simples e estável para cartões de cor
 cor_class_t cor_classify(float r, float g, float b, float c_norm)
 {
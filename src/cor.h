@@ -19,15 +19,52 @@ typedef enum {
     COR_CLASS_COUNT                // <-- usado no main.c
 } cor_class_t;
 
+// Uma integração completa do sensor (nunca a mesma duas vezes)
+typedef struct {
+    uint16_t c, r, g, b;       // contagens cruas desta integração
+    float    rn, gn, bn;       // r/c, g/c, b/c (0..1 aprox)
+    float    c_ref;            // clear na exposição de referência (16x, ~103 ms):
+                               // comparável entre exposições, é o c_norm do cor_classify
+    uint16_t integ_ms;         // tempo de integração usado
+    uint8_t  gain;             // 1, 4, 16 ou 60
+    uint32_t t_ms;             // quando foi lida
+} cor_sample_t;
+
+// Contadores desde o cor_init
+typedef struct {
+    uint32_t samples;          // integrações novas entregues
+    uint32_t not_ready;        // consultas antes do fim da integração (dado velho evitado)
+    uint32_t errors;           // NACK/timeout no I2C
+    uint32_t exposure_changes; // passos do auto-exposição
+} cor_stats_t;
+
 // Inicializa o sensor de cor no barramento/pinos informados
-// (configura I2C, verifica ID, liga o sensor, define tempo de integração e ganho)
+// (abre o barramento no i2c_bus, verifica ID, liga o sensor com interrupção
+// a cada integração)
 bool cor_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin);
 
-// Lê valores crus (clear, red, green, blue) – 16 bits cada
+// Pino INT do TCS34725 (dreno aberto, ativo em baixo), se estiver ligado.
+// Com ele o cor_poll só vai ao barramento quando há dado novo; sem ele
+// (padrão, o extensor da BitDog não traz o INT), consulta o STATUS.
+void cor_set_int_pin(uint pin);
+
+// Lê valores crus (clear, red, green, blue) – 16 bits cada, sem esperar integração nova
 bool cor_read_raw(uint16_t *clear, uint16_t *red, uint16_t *green, uint16_t *blue);
 
-// Lê normalizado (0..1 aprox) baseado em 'clear'. Retorna false se leitura falhar.
-bool cor_read_rgb_norm(float *r, float *g, float *b, float *c_norm);
+// Não bloqueia: true só quando terminou uma integração nova desde a última
+// (bit AINT), que vai para *out. Ajusta a exposição e alimenta a média do
+// ambiente. Chamar a cada volta do laço.
+bool cor_poll(cor_sample_t *out);
+
+// Média do ambiente (sem pulseira): recomeça em cor_ambient_reset, fica
+// pronta depois de COR_AMB_WARMUP_MS e segue a luz devagar enquanto as
+// leituras ficam perto dela (pulseira na frente não entra na média).
+void  cor_ambient_reset(void);
+bool  cor_ambient_ready(void);
+// |c_ref - ambiente| / ambiente (1 se não há média)
+float cor_ambient_delta_c(float c_ref);
+
+void cor_get_stats(cor_stats_t *out);
 
 // Classifica a cor a partir dos valores normalizados
 cor_class_t cor_classify(float r, float g, float b, float c_norm);
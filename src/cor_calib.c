@@ -0,0 +1,122 @@
+#include "cor_calib.h"
+#include <stddef.h>
+#include <string.h>
+
+#define COR_PROFILE_MAGIC   0x50524F43u   // "CORP"
+#define COR_PROFILE_VERSION 1
+#define COR_CAL_MIN_N       8
+
+// 32 leituras paradas na calibração dão uma nuvem mais apertada do que a
+// pulseira no punho (ângulo, distância, brilho do silicone): a covariância
+// medida vale x4 (sigma x2) e ganha um piso (unidades² de Q12; sigma 24 ~
+// 0,6% de cromaticidade). Ajustados no host/cor_bench.
+#define COR_CAL_SPREAD      4
+#define COR_CAL_VAR_FLOOR   (24 * 24)
+
+bool cor_cal_chroma(uint16_t r, uint16_t g, uint16_t b, int32_t *x, int32_t *y)
+{
+    uint32_t sum = (uint32_t)r + g + b;
+    if (!sum) return false;
+    // r << 12 cabe em 32 bits; divisão de 32 bits (divisor do RP2040)
+    *x = (int32_t)(((uint32_t)r << 12) / sum);
+    *y = (int32_t)(((uint32_t)g << 12) / sum);
+    return true;
+}
+
+void cor_cal_acc_reset(cor_cal_acc_t *a)
+{
+    memset(a, 0, sizeof *a);
+}
+
+bool cor_cal_acc_add(cor_cal_acc_t *a, uint16_t r, uint16_t g, uint16_t b)
+{
+    int32_t x, y;
+    if (!cor_cal_chroma(r, g, b, &x, &y)) return false;
+    a->n++;
+    a->sx  += x;
+    a->sy  += y;
+    a->sxx += (int64_t)x * x;
+    a->syy += (int64_t)y * y;
+    a->sxy += (int64_t)x * y;
+    return true;
+}
+
+bool cor_cal_acc_finish(const cor_cal_acc_t *a, cor_class_t cls, cor_centroid_t *out)
+{
+    if (a->n < COR_CAL_MIN_N) return false;
+    int64_t n = a->n, nn = n * n;
+    int64_t cxx = COR_CAL_SPREAD * (n * a->sxx - a->sx * a->sx) / nn + COR_CAL_VAR_FLOOR;
+    int64_t cyy = COR_CAL_SPREAD * (n * a->syy - a->sy * a->sy) / nn + COR_CAL_VAR_FLOOR;
+    int64_t cxy = COR_CAL_SPREAD * (n * a->sxy - a->sx * a->sy) / nn;
+    // Com o piso somado na diagonal, det > 0 sempre
+    int64_t det = cxx * cyy - cxy * cxy;
+    if (det <= 0) return false;
+
+    memset(out, 0, sizeof *out);
+    out->cls = (uint8_t)cls;
+    out->n   = (uint16_t)(a->n > 0xFFFF ? 0xFFFF : a->n);
+    out->mx  = (int32_t)((a->sx + n / 2) / n);
+    out->my  = (int32_t)((a->sy + n / 2) / n);
+    out->ia  = (int32_t)((cyy << 24) / det);
+    out->ib  = (int32_t)((-cxy * (1 << 24)) / det);
+    out->ic  = (int32_t)((cxx << 24) / det);
+    return true;
+}
+
+static uint32_t fnv1a(const void *data, size_t n)
+{
+    const uint8_t *p = data;
+    uint32_t h = 2166136261u;
+    while (n--) { h ^= *p++; h *= 16777619u; }
+    return h;
+}
+
+void cor_profile_init(cor_profile_t *p)
+{
+    memset(p, 0, sizeof *p);
+}
+
+bool cor_profile_add(cor_profile_t *p, const cor_centroid_t *c)
+{
+    for (uint16_t i = 0; i < p->count; i++) {
+        if (p->c[i].cls == c->cls) { p->c[i] = *c; return true; }
+    }
+    if (p->count >= COR_CAL_MAX) return false;
+    p->c[p->count++] = *c;
+    return true;
+}
+
+void cor_profile_seal(cor_profile_t *p)
+{
+    p->magic   = COR_PROFILE_MAGIC;
+    p->version = COR_PROFILE_VERSION;
+    p->check   = fnv1a(p, offsetof(cor_profile_t, check));
+}
+
+bool cor_profile_valid(const cor_profile_t *p)
+{
+    return p->magic == COR_PROFILE_MAGIC && p->version == COR_PROFILE_VERSION &&
+           p->count > 0 && p->count <= COR_CAL_MAX &&
+           p->check == fnv1a(p, offsetof(cor_profile_t, check));
+}
+
+cor_class_t cor_cal_classify(const cor_profile_t *p, uint16_t r, uint16_t g, uint16_t b, uint32_t *d2_q8)
+{
+    int32_t x, y;
+    int64_t best = INT64_MAX;
+    cor_class_t cls = COR_DESCONHECIDA;
+    if (cor_cal_chroma(r, g, b, &x, &y)) {
+        for (uint16_t i = 0; i < p->count; i++) {
+            const cor_centroid_t *c = &p->c[i];
+            int64_t dx = x - c->mx, dy = y - c->my;
+            // d² em Q24: dx, dy <= 4096 e ia/ib/ic < 2^15 cabem folgados em 64 bits
+            int64_t d2 = c->ia * dx * dx + 2 * c->ib * dx * dy + c->ic * dy * dy;
+            if (d2 < best) { best = d2; cls = (cor_class_t)c->cls; }
+        }
+    }
+    uint32_t q8 = best == INT64_MAX ? UINT32_MAX
+                : best <= 0 ? 0
+                : (best >> 16) > UINT32_MAX ? UINT32_MAX : (uint32_t)(best >> 16);
+    if (d2_q8) *d2_q8 = q8;
+    return q8 <= ((uint32_t)COR_CAL_REJECT_D2 << 8) ? cls : COR_DESCONHECIDA;
+}
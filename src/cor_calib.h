@@ -0,0 +1,55 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "cor.h"
+
+// Classificador calibrado das pulseiras: centróide + covariância de cada cor
+// na cromaticidade (r, g) = (R, G) / (R + G + B), medidos sob a luz do local
+// (modo de calibração no main.c) e guardados na flash (cor_flash.c). Só
+// inteiros: distância de Mahalanobis até cada centróide, a menor vence se
+// ficar abaixo do limiar de rejeição. Sem perfil salvo, vale o cor_classify.
+
+#define COR_CAL_ONE        4096      // cromaticidade em Q12 (1.0 = 4096)
+#define COR_CAL_MAX        4         // cores no perfil (hoje: verde, amarelo, vermelho)
+#define COR_CAL_SAMPLES    32        // leituras por cor na calibração
+#define COR_CAL_REJECT_D2  16        // d² de Mahalanobis acima disso: desconhecida (4 sigma)
+
+typedef struct {
+    uint8_t  cls;                    // cor_class_t
+    uint8_t  pad;
+    uint16_t n;                      // leituras usadas
+    int32_t  mx, my;                 // centróide (Q12)
+    int32_t  ia, ib, ic;             // inversa da covariância, Q24 por unidade² de Q12
+} cor_centroid_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    cor_centroid_t c[COR_CAL_MAX];
+    uint32_t check;                  // FNV-1a de tudo acima
+} cor_profile_t;
+
+// Acumulador de uma cor durante a calibração
+typedef struct {
+    uint32_t n;
+    int64_t  sx, sy, sxx, syy, sxy;
+} cor_cal_acc_t;
+
+// (r, g) em Q12 a partir das contagens cruas; false se R+G+B = 0
+bool cor_cal_chroma(uint16_t r, uint16_t g, uint16_t b, int32_t *x, int32_t *y);
+
+void cor_cal_acc_reset(cor_cal_acc_t *a);
+bool cor_cal_acc_add(cor_cal_acc_t *a, uint16_t r, uint16_t g, uint16_t b);
+// Fecha a cor: centróide e inversa da covariância (com piso de variância)
+bool cor_cal_acc_finish(const cor_cal_acc_t *a, cor_class_t cls, cor_centroid_t *out);
+
+// Perfil: vazio, adiciona cor, fecha (magic + check) e valida
+void cor_profile_init(cor_profile_t *p);
+bool cor_profile_add(cor_profile_t *p, const cor_centroid_t *c);
+void cor_profile_seal(cor_profile_t *p);
+bool cor_profile_valid(const cor_profile_t *p);
+
+// Cor mais próxima, ou COR_DESCONHECIDA se nenhuma fica abaixo de
+// COR_CAL_REJECT_D2. *d2_q8 = menor d² em Q8 (pode ser NULL)
+cor_class_t cor_cal_classify(const cor_profile_t *p, uint16_t r, uint16_t g, uint16_t b, uint32_t *d2_q8);
@@ -0,0 +1,34 @@
+#include "cor_flash.h"
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+#define COR_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define COR_FLASH_BYTES  ((sizeof(cor_profile_t) + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE)
+
+_Static_assert(COR_FLASH_BYTES <= FLASH_SECTOR_SIZE, "perfil cabe num setor");
+
+bool cor_flash_load(cor_profile_t *p)
+{
+    // Leitura direta pelo XIP
+    memcpy(p, (const void *)(XIP_BASE + COR_FLASH_OFFSET), sizeof *p);
+    return cor_profile_valid(p);
+}
+
+bool cor_flash_save(const cor_profile_t *p)
+{
+    if (!cor_profile_valid(p)) return false;
+    static uint8_t page[COR_FLASH_BYTES];
+    memset(page, 0xFF, sizeof page);
+    memcpy(page, p, sizeof *p);
+
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(COR_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(COR_FLASH_OFFSET, page, sizeof page);
+    restore_interrupts(irq);
+
+    cor_profile_t back;
+    return cor_flash_load(&back) && !memcmp(&back, p, sizeof back);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <stdbool.h>
+#include "cor_calib.h"
+
+// Perfil de calibração das cores no último setor (4 KB) da flash: sobrevive
+// a reset e regravação do firmware (o .uf2 não chega lá)
+
+// Lê e valida; false se o setor está apagado ou o perfil não confere
+bool cor_flash_load(cor_profile_t *p);
+
+// Apaga o setor e grava p (já selado). Interrupções desligadas durante a
+// gravação (~50 ms): chamar fora de medição, com o core 1 parado
+bool cor_flash_save(const cor_profile_t *p);
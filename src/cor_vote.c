@@ -0,0 +1,39 @@
+#include "cor_vote.h"
+#include <string.h>
+
+void cor_vote_reset(cor_vote_t *v)
+{
+    memset(v, 0, sizeof *v);
+}
+
+static uint8_t count(const cor_vote_t *v, cor_class_t cls)
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < v->len; i++) n += v->hist[i] == (uint8_t)cls;
+    return n;
+}
+
+cor_class_t cor_vote_push(cor_vote_t *v, cor_class_t cls)
+{
+    v->hist[v->pos] = (uint8_t)cls;
+    v->pos = (uint8_t)((v->pos + 1) % COR_VOTE_M);
+    if (v->len < COR_VOTE_M) v->len++;
+    if (v->leituras < UINT16_MAX) v->leituras++;
+    // Só a cor que acabou de votar pode ter passado de N agora
+    if (cls == COR_DESCONHECIDA) return COR_DESCONHECIDA;
+    return count(v, cls) >= COR_VOTE_N ? cls : COR_DESCONHECIDA;
+}
+
+cor_class_t cor_vote_leader(const cor_vote_t *v, uint8_t *votos)
+{
+    cor_class_t best = COR_DESCONHECIDA;
+    uint8_t bn = 0;
+    for (uint8_t i = 0; i < v->len; i++) {
+        cor_class_t c = (cor_class_t)v->hist[i];
+        if (c == COR_DESCONHECIDA || c == best) continue;
+        uint8_t n = count(v, c);
+        if (n > bn) { bn = n; best = c; }
+    }
+    if (votos) *votos = bn;
+    return best;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "cor.h"
+
+// Votação temporal da pulseira: cada integração nova do sensor (já passada
+// pelos portões de luz/croma/delta-C e classificada) é um voto; a cor
+// confirma quando tem COR_VOTE_N votos entre os últimos COR_VOTE_M. Leitura
+// reprovada ou rejeitada entra como COR_DESCONHECIDA e ocupa a vaga, então
+// pulseira passando rápido ou tremendo não confirma.
+
+#define COR_VOTE_M  7                // janela (integrações)
+#define COR_VOTE_N  5                // votos iguais para confirmar
+
+typedef struct {
+    uint8_t  hist[COR_VOTE_M];       // cor_class_t, anel
+    uint8_t  pos, len;
+    uint16_t leituras;               // votos desde o reset
+} cor_vote_t;
+
+void cor_vote_reset(cor_vote_t *v);
+
+// Acrescenta um voto; devolve a cor confirmada (>= N entre os últimos M)
+// ou COR_DESCONHECIDA
+cor_class_t cor_vote_push(cor_vote_t *v, cor_class_t cls);
+
+// Cor com mais votos na janela (desconhecida não conta) e quantos; para a tela
+cor_class_t cor_vote_leader(const cor_vote_t *v, uint8_t *votos);
@@ -0,0 +1,47 @@
+#include "fmt.h"
+#include <math.h>
+#include <stdbool.h>
+
+static const uint32_t k_pow10[FMT_FIXED_MAX_DEC + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+char *fmt_str(char *p, const char *s) {
+    while (*s) *p++ = *s++;
+    *p = 0;
+    return p;
+}
+
+char *fmt_u32(char *p, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);   // divisor de hardware (SIO)
+    while (n) *p++ = tmp[--n];
+    *p = 0;
+    return p;
+}
+
+char *fmt_i32(char *p, int32_t v) {
+    if (v < 0) { *p++ = '-'; return fmt_u32(p, 0u - (uint32_t)v); }
+    return fmt_u32(p, (uint32_t)v);
+}
+
+char *fmt_fixed(char *p, float v, unsigned decimals) {
+    if (decimals > FMT_FIXED_MAX_DEC) decimals = FMT_FIXED_MAX_DEC;
+    float a = fabsf(v);
+    if (!(a < 4294967296.f)) return fmt_str(p, "null");          // NaN/inf também caem aqui
+
+    // Parte inteira e fração escalada, arredondada; o "vai um" sobe p/ o inteiro
+    uint32_t ip = (uint32_t)a;
+    uint32_t scale = k_pow10[decimals];
+    uint32_t fr = (uint32_t)((a - (float)ip) * (float)scale + 0.5f);
+    if (fr >= scale) { fr -= scale; ip++; }
+
+    if (v < 0.f && (ip || fr)) *p++ = '-';                       // sem "-0.000"
+    p = fmt_u32(p, ip);
+    if (decimals) {
+        *p++ = '.';
+        for (unsigned i = decimals; i--; ) { p[i] = (char)('0' + fr % 10); fr /= 10; }
+        p += decimals;
+    }
+    *p = 0;
+    return p;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Formatação numérica sem printf (JSON/CSV/OLED). Cada função escreve a partir
+// de p, termina com NUL e devolve o ponteiro para esse NUL, para encadear:
+//     p = fmt_str(p, "\"bpm\":"); p = fmt_fixed(p, bpm, 3);
+// Quem chama garante espaço: FMT_NUM_MAX por número.
+#define FMT_NUM_MAX      20      // "-4294967295.999999" + NUL
+#define FMT_FIXED_MAX_DEC 6
+
+char *fmt_str(char *p, const char *s);
+char *fmt_u32(char *p, uint32_t v);
+char *fmt_i32(char *p, int32_t v);
+// `decimals` casas (0..6), arredondado; NaN, infinito ou |v| >= 2^32 -> "null"
+char *fmt_fixed(char *p, float v, unsigned decimals);
+
+#ifdef __cplusplus
+}
+#endif
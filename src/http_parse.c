@@ -0,0 +1,172 @@
+#include "http_parse.h"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+enum { HH_NONE, HH_ACCEPT_ENCODING, HH_CONNECTION, HH_CONTENT_LENGTH,
+       HH_IF_NONE_MATCH, HH_SEC_WS_KEY, HH_TRANSFER_ENCODING, HH_UPGRADE };
+
+// Nomes em minúsculas, ordem alfabética
+static const struct { const char *name; uint8_t id; } k_http_headers[] = {
+    { "accept-encoding",   HH_ACCEPT_ENCODING },
+    { "connection",        HH_CONNECTION },
+    { "content-length",    HH_CONTENT_LENGTH },
+    { "if-none-match",     HH_IF_NONE_MATCH },
+    { "sec-websocket-key", HH_SEC_WS_KEY },
+    { "transfer-encoding", HH_TRANSFER_ENCODING },
+    { "upgrade",           HH_UPGRADE },
+};
+
+bool http_value_has(const char *v, const char *tok) {
+    size_t n = strlen(tok);
+    for (; v && *v && *v != '\r'; v++) {
+        if (!strncasecmp(v, tok, n)) return true;
+    }
+    return false;
+}
+
+void http_req_reset(http_req_t *r) {
+    memset(r, 0, sizeof *r);
+}
+
+bool http_req_idle(const http_req_t *r) {
+    return r->st == HP_METHOD && !r->head;
+}
+
+static void http_req_fail(http_req_t *r, uint16_t status) {
+    r->status = status;
+    r->st = HP_DONE;
+}
+
+/* Fim de uma linha de cabeçalho: interpreta o valor em r->tok */
+static void http_req_header(http_req_t *r) {
+    uint16_t n = r->n < HTTP_HVAL_MAX ? r->n : HTTP_HVAL_MAX;
+    while (n && (r->tok[n - 1] == ' ' || r->tok[n - 1] == '\t')) n--;
+    r->tok[n] = 0;
+    const char *v = r->tok;
+
+    switch (r->hdr) {
+    case HH_ACCEPT_ENCODING:
+        if (http_value_has(v, "gzip")) r->flags |= HQ_GZIP;
+        break;
+    case HH_CONNECTION:
+        if (http_value_has(v, "close"))      r->flags |= HQ_CLOSE;
+        if (http_value_has(v, "keep-alive")) r->flags |= HQ_KEEP;
+        break;
+    case HH_CONTENT_LENGTH: {
+        uint32_t len = 0;
+        if (!n || n > 9) { http_req_fail(r, 400); break; }
+        for (const char *p = v; *p; p++) {
+            if (*p < '0' || *p > '9') { http_req_fail(r, 400); return; }
+            len = len * 10 + (uint32_t)(*p - '0');
+        }
+        r->content_len = len;
+        break;
+    }
+    case HH_IF_NONE_MATCH:
+        memcpy(r->etag, v, n + 1);
+        break;
+    case HH_SEC_WS_KEY:
+        if (n < sizeof r->ws_key) memcpy(r->ws_key, v, n + 1);
+        break;
+    case HH_TRANSFER_ENCODING:                      // corpo chunked: não aceitamos
+        http_req_fail(r, 501);
+        break;
+    case HH_UPGRADE:
+        if (http_value_has(v, "websocket")) r->flags |= HQ_UPGRADE;
+        break;
+    }
+}
+
+static uint8_t http_header_id(const char *name) {
+    for (size_t i = 0; i < sizeof k_http_headers / sizeof k_http_headers[0]; i++) {
+        if (!strcmp(name, k_http_headers[i].name)) return k_http_headers[i].id;
+    }
+    return HH_NONE;
+}
+
+uint16_t http_parse(http_req_t *r, const char *p, uint16_t len) {
+    uint16_t i = 0;
+    while (i < len && r->st != HP_DONE) {
+        char ch = p[i++];
+        if (r->st != HP_BODY) {
+            if (++r->head > HTTP_HEAD_MAX) { http_req_fail(r, 431); break; }
+            if (ch == '\r') continue;               // aceita "\r\n" e "\n"
+        }
+        switch (r->st) {
+        case HP_METHOD:
+            if (ch == '\n' && !r->n) { r->head = 0; break; }   // linhas vazias antes
+            if (ch == ' ') {
+                r->tok[r->n] = 0;
+                r->method = !strcmp(r->tok, "GET") ? HTTP_GET : !strcmp(r->tok, "POST") ? HTTP_POST : 0;
+                r->n = 0;
+                r->st = HP_TARGET;
+            } else if (ch == '\n' || r->n >= 7) {
+                http_req_fail(r, 400);
+            } else {
+                r->tok[r->n++] = ch;
+            }
+            break;
+        case HP_TARGET:
+            if (ch == ' ') {
+                if (!r->n || r->target[0] != '/') { http_req_fail(r, 400); break; }
+                r->target[r->n] = 0;
+                r->n = 0;
+                r->st = HP_VERSION;
+            } else if ((unsigned char)ch <= ' ' || ch == 0x7F) {
+                http_req_fail(r, 400);
+            } else if (r->n >= HTTP_TARGET_MAX) {
+                http_req_fail(r, 414);
+            } else if (ch == '?' && !r->query) {
+                r->target[r->n++] = 0;
+                r->query = r->n;
+            } else {
+                r->target[r->n++] = ch;
+            }
+            break;
+        case HP_VERSION:
+            if (ch != '\n') {
+                if (r->n >= 8) { http_req_fail(r, 400); break; }
+                r->tok[r->n++] = ch;
+                break;
+            }
+            r->tok[r->n] = 0;
+            if (!strcmp(r->tok, "HTTP/1.0"))      r->flags |= HQ_HTTP10;
+            else if (strcmp(r->tok, "HTTP/1.1")) { http_req_fail(r, 400); break; }
+            r->n = 0;
+            r->st = HP_NAME;
+            break;
+        case HP_NAME:
+            if (ch == '\n') {                       // linha em branco: fim do cabeçalho
+                if (r->n) http_req_fail(r, 400);
+                else if (r->content_len > HTTP_BODY_MAX) { r->flags |= HQ_BIGBODY; r->st = HP_DONE; }
+                else r->st = r->content_len ? HP_BODY : HP_DONE;
+            } else if (ch == ':') {
+                r->tok[r->n <= HTTP_HNAME_MAX ? r->n : 0] = 0;
+                r->hdr = r->n <= HTTP_HNAME_MAX ? http_header_id(r->tok) : HH_NONE;
+                r->n = 0;
+                r->st = HP_VALUE;
+            } else {
+                if (r->n < HTTP_HNAME_MAX) r->tok[r->n] = (char)tolower((unsigned char)ch);
+                r->n++;
+            }
+            break;
+        case HP_VALUE:
+            if (ch == '\n') {
+                http_req_header(r);
+                if (r->st == HP_DONE) break;
+                r->n = 0;
+                r->st = HP_NAME;
+            } else if (r->n || (ch != ' ' && ch != '\t')) {
+                if (r->hdr && r->n < HTTP_HVAL_MAX) r->tok[r->n] = ch;
+                r->n++;
+            }
+            break;
+        case HP_BODY:
+            r->body[r->body_len++] = ch;
+            if (r->body_len == r->content_len) r->st = HP_DONE;
+            break;
+        }
+    }
+    return i;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parser HTTP incremental do web_ap.c, sem lwIP (host/ testa e mede à parte).
+// Consome a requisição byte a byte direto dos pbufs, sem juntar o cabeçalho
+// num buffer: guarda só o alvo (caminho e query), os cabeçalhos que o servidor
+// usa e um corpo de POST pequeno. Para em qualquer byte e continua no próximo
+// segmento; ao fim de uma requisição para de consumir (pipelining).
+#define HTTP_TARGET_MAX  160     // caminho + query
+#define HTTP_HNAME_MAX   24      // nomes maiores não interessam
+#define HTTP_HVAL_MAX    64      // valores além disso são truncados
+#define HTTP_BODY_MAX    64      // corpo de POST (formulário do survey)
+#define HTTP_HEAD_MAX    4096    // linha de requisição + cabeçalhos -> 431
+
+enum { HTTP_GET = 1, HTTP_POST = 2 };                // método (máscara nas rotas)
+
+enum { HP_METHOD, HP_TARGET, HP_VERSION, HP_NAME, HP_VALUE, HP_BODY, HP_DONE };
+
+#define HQ_GZIP     0x01         // Accept-Encoding: gzip
+#define HQ_CLOSE    0x02         // Connection: close
+#define HQ_KEEP     0x04         // Connection: keep-alive
+#define HQ_HTTP10   0x08
+#define HQ_UPGRADE  0x10         // Upgrade: websocket
+#define HQ_BIGBODY  0x20         // corpo > HTTP_BODY_MAX não lido: só rotas RT_SINK
+
+typedef struct {
+    uint8_t  st;                 // HP_*
+    uint8_t  method;             // HTTP_GET/HTTP_POST; 0 = outro
+    uint8_t  flags;              // HQ_*
+    uint8_t  hdr;                // cabeçalho da linha atual (interno)
+    uint16_t status;             // != 0: requisição recusada com esse código
+    uint16_t n;                  // bytes do token atual
+    uint16_t head;               // bytes de cabeçalho lidos
+    uint16_t query;              // início da query em target (0 = sem query)
+    uint16_t body_len;
+    uint32_t content_len;
+    char  tok[HTTP_HVAL_MAX + 1];      // método, versão, nome ou valor em curso
+    char  target[HTTP_TARGET_MAX + 1]; // "caminho\0query\0"
+    char  etag[HTTP_HVAL_MAX + 1];     // If-None-Match
+    char  ws_key[32];                  // Sec-WebSocket-Key (24 em base64)
+    char  body[HTTP_BODY_MAX + 1];
+} http_req_t;
+
+void http_req_reset(http_req_t *r);
+
+// Nada lido da próxima requisição ainda
+bool http_req_idle(const http_req_t *r);
+
+// Consome até len bytes de p; devolve quantos usou. Para em HP_DONE
+// (requisição completa ou recusada, status != 0), deixando o resto para a próxima.
+uint16_t http_parse(http_req_t *r, const char *p, uint16_t len);
+
+// `tok` aparece no valor (até o fim da linha)? Sem diferenciar caixa
+bool http_value_has(const char *v, const char *tok);
+
+#ifdef __cplusplus
+}
+#endif
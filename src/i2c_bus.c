@@ -0,0 +1,138 @@
+#include "i2c_bus.h"
+
+#define I2C_BUS_RECOVER_HALF_US 5      // meio período dos pulsos: ~100 kHz
+
+static i2c_bus_t  s_bus[2];
+static i2c_dev_t *s_devs[I2C_BUS_MAX_DEVS];
+static uint8_t    s_ndevs = 0;
+
+static void bus_config(i2c_bus_t *b)
+{
+    i2c_init(b->i2c, b->hz);
+    gpio_set_function(b->sda, GPIO_FUNC_I2C);
+    gpio_set_function(b->scl, GPIO_FUNC_I2C);
+    gpio_pull_up(b->sda);
+    gpio_pull_up(b->scl);
+}
+
+i2c_bus_t *i2c_bus_open(i2c_inst_t *i2c, uint sda, uint scl, uint hz)
+{
+    i2c_bus_t *b = &s_bus[i2c_hw_index(i2c)];
+    if (b->open) return b;
+    b->i2c = i2c;
+    b->sda = sda;
+    b->scl = scl;
+    b->hz  = hz;
+    b->byte_us = 9u * 1000000u / hz + 1u;
+    bus_config(b);
+    b->open = true;
+    return b;
+}
+
+// Dreno aberto na mão: "0" puxa a linha, "1" solta (o pull-up sobe)
+static inline void line(uint pin, bool high)
+{
+    gpio_set_dir(pin, high ? GPIO_IN : GPIO_OUT);
+    busy_wait_us_32(I2C_BUS_RECOVER_HALF_US);
+}
+
+static bool bus_recover(i2c_bus_t *b)
+{
+    i2c_deinit(b->i2c);
+    gpio_set_dir(b->sda, GPIO_IN);
+    gpio_set_dir(b->scl, GPIO_IN);
+    gpio_put(b->sda, 0);
+    gpio_put(b->scl, 0);
+    gpio_set_function(b->sda, GPIO_FUNC_SIO);
+    gpio_set_function(b->scl, GPIO_FUNC_SIO);
+    busy_wait_us_32(I2C_BUS_RECOVER_HALF_US);
+
+    // Escravo no meio de um byte segura o SDA: até 9 pulsos para ele
+    // terminar (o NACK do 9º o solta)
+    for (int i = 0; i < 9 && !gpio_get(b->sda); i++) {
+        line(b->scl, false);
+        line(b->scl, true);
+    }
+    // STOP: SDA sobe com SCL em alto
+    line(b->scl, false);
+    line(b->sda, false);
+    line(b->scl, true);
+    line(b->sda, true);
+
+    bool ok = gpio_get(b->sda) && gpio_get(b->scl);
+    bus_config(b);
+    return ok;
+}
+
+bool i2c_dev_recover(i2c_dev_t *d)
+{
+    d->stats.recoveries++;
+    return bus_recover(d->bus);
+}
+
+bool i2c_bus_stuck(const i2c_bus_t *b)
+{
+    return !gpio_get(b->sda) || !gpio_get(b->scl);
+}
+
+void i2c_dev_init(i2c_dev_t *d, i2c_bus_t *bus, uint8_t addr, const char *name)
+{
+    d->bus  = bus;
+    d->addr = addr;
+    d->name = name;
+    for (uint8_t i = 0; i < s_ndevs; i++) if (s_devs[i] == d) return;
+    d->stats = (i2c_dev_stats_t){0};
+    if (s_ndevs < I2C_BUS_MAX_DEVS) s_devs[s_ndevs++] = d;
+}
+
+void i2c_dev_account(i2c_dev_t *d, bool ok, uint32_t us)
+{
+    d->stats.xfers++;
+    if (!ok) d->stats.errors++;
+    d->stats.us_sum += us;
+    if (us > d->stats.us_max) d->stats.us_max = us;
+}
+
+static inline uint timeout_us(const i2c_dev_t *d, size_t n)
+{
+    // n bytes + o byte de endereço, folga de 2x
+    return (uint)(I2C_BUS_TIMEOUT_BASE_US + 2u * (n + 1u) * d->bus->byte_us);
+}
+
+// Fecha a transação: contadores e, se expirou, recuperação do barramento
+static bool done(i2c_dev_t *d, uint32_t t0, int rc, size_t want)
+{
+    bool ok = rc == (int)want;
+    i2c_dev_account(d, ok, time_us_32() - t0);
+    if (rc == PICO_ERROR_TIMEOUT) {
+        d->stats.timeouts++;
+        i2c_dev_recover(d);
+    }
+    return ok;
+}
+
+bool i2c_dev_write(i2c_dev_t *d, const uint8_t *src, size_t n)
+{
+    uint32_t t0 = time_us_32();
+    int rc = i2c_write_timeout_us(d->bus->i2c, d->addr, src, n, false, timeout_us(d, n));
+    return done(d, t0, rc, n);
+}
+
+bool i2c_dev_read(i2c_dev_t *d, const uint8_t *cmd, size_t ncmd, uint8_t *dst, size_t n)
+{
+    uint32_t t0 = time_us_32();
+    int rc = i2c_write_timeout_us(d->bus->i2c, d->addr, cmd, ncmd, true, timeout_us(d, ncmd));
+    if (rc != (int)ncmd) return done(d, t0, rc, ncmd);
+    rc = i2c_read_timeout_us(d->bus->i2c, d->addr, dst, n, false, timeout_us(d, n));
+    return done(d, t0, rc, n);
+}
+
+uint8_t i2c_bus_dev_count(void)
+{
+    return s_ndevs;
+}
+
+const i2c_dev_t *i2c_bus_dev(uint8_t i)
+{
+    return i < s_ndevs ? s_devs[i] : NULL;
+}
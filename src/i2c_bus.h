@@ -0,0 +1,71 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+// Dono dos controladores I2C: cada barramento é configurado uma vez (pinos,
+// pull-ups, velocidade) por quem pedir primeiro, e os drivers falam com os
+// seus dispositivos por aqui. Cada transação tem timeout pelo tamanho (o
+// SDA preso não trava mais o laço); depois de um timeout o barramento passa
+// pela recuperação de 9 pulsos de SCL + STOP e o controlador é reiniciado.
+//
+// Sem fila: tudo roda no laço principal, uma transação por vez, e cada uma
+// termina (ou expira) antes da próxima. A ordem do laço é a prioridade:
+// oxímetro, depois cor (os dois no I2C0, nunca na mesma tela), e o OLED vai
+// por DMA no I2C1, que não disputa o I2C0.
+
+#define I2C_BUS_MAX_DEVS        4
+#define I2C_BUS_TIMEOUT_BASE_US 500    // + 2x o tempo de fio dos bytes
+
+typedef struct {
+    i2c_inst_t *i2c;
+    uint        sda, scl;
+    uint        hz;
+    uint32_t    byte_us;               // 9 bits na velocidade do barramento
+    bool        open;
+} i2c_bus_t;
+
+// Contadores por dispositivo (lidos sem trava pelo /metrics)
+typedef struct {
+    uint32_t xfers;                    // transações (escrita, ou escrita + leitura)
+    uint32_t errors;                   // NACK ou timeout
+    uint32_t timeouts;
+    uint32_t recoveries;               // do barramento, depois de erro deste dispositivo
+    uint32_t us_sum, us_max;           // latência da transação, do início ao fim
+} i2c_dev_stats_t;
+
+typedef struct {
+    i2c_bus_t      *bus;
+    uint8_t         addr;
+    const char     *name;              // rótulo no /metrics
+    i2c_dev_stats_t stats;
+} i2c_dev_t;
+
+// Barramento do controlador; o primeiro pedido configura, os seguintes
+// (mesmo com outra velocidade) só devolvem o mesmo
+i2c_bus_t *i2c_bus_open(i2c_inst_t *i2c, uint sda, uint scl, uint hz);
+
+// SDA ou SCL em baixo com o barramento parado
+bool i2c_bus_stuck(const i2c_bus_t *b);
+
+// Registra o dispositivo (uma vez; o /metrics lista na ordem de registro)
+void i2c_dev_init(i2c_dev_t *d, i2c_bus_t *bus, uint8_t addr, const char *name);
+
+// Escrita com STOP
+bool i2c_dev_write(i2c_dev_t *d, const uint8_t *src, size_t n);
+// Escreve cmd (registrador), repeated start, lê n bytes
+bool i2c_dev_read(i2c_dev_t *d, const uint8_t *cmd, size_t ncmd, uint8_t *dst, size_t n);
+
+// Transação feita fora daqui (ex.: quadro do OLED por DMA): só contabiliza
+void i2c_dev_account(i2c_dev_t *d, bool ok, uint32_t us);
+
+// Recuperação do barramento de d (automática depois de timeout; à mão para
+// o que não passa por aqui): 9 pulsos de SCL até o escravo soltar o SDA,
+// STOP, controlador reiniciado. true se SDA e SCL ficaram em alto
+bool i2c_dev_recover(i2c_dev_t *d);
+
+// Dispositivos registrados, para o /metrics (vaga i < I2C_BUS_MAX_DEVS, NULL se livre)
+uint8_t          i2c_bus_dev_count(void);
+const i2c_dev_t *i2c_bus_dev(uint8_t i);
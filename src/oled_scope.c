@@ -0,0 +1,89 @@
+#include "oled_scope.h"
+
+#include <string.h>
+
+#define BURST_MS 250                 // saldo máximo: 250 ms de orçamento
+
+void oled_scope_init(oled_scope_t *s, ssd1306_t *p, uint8_t page0, uint8_t page1, uint32_t budget_bps) {
+    memset(s, 0, sizeof *s);
+    s->p = p;
+    s->page0 = page0;
+    s->page1 = page1 < p->pages ? page1 : (uint8_t)(p->pages - 1);
+    s->budget_bps = budget_bps;
+    s->bytes_seen = p->stats.bytes;
+    s->last_y = -1;
+}
+
+static void column_clear(oled_scope_t *s, uint8_t x) {
+    for (uint8_t pg = s->page0; pg <= s->page1; pg++)
+        s->p->buffer[pg * s->p->width + x] = 0;
+}
+
+void oled_scope_clear(oled_scope_t *s) {
+    for (uint8_t pg = s->page0; pg <= s->page1; pg++)
+        memset(s->p->buffer + pg * s->p->width, 0, s->p->width);
+    s->x = 0;
+    s->filled = 0;
+    s->last_y = -1;
+}
+
+void oled_scope_push(oled_scope_t *s, int16_t v) {
+    uint8_t w = s->p->width > 128 ? 128 : s->p->width;
+    s->col[s->x] = v;
+    if (s->filled < w) s->filled++;
+    s->samples++;
+
+    // escala pelo que está na tela (a varredura troca uma coluna por vez)
+    int16_t mn = v, mx = v;
+    for (uint8_t i = 0; i < s->filled; i++) {
+        if (s->col[i] < mn) mn = s->col[i];
+        if (s->col[i] > mx) mx = s->col[i];
+    }
+    int32_t span = mx - mn;
+    if (span < OLED_SCOPE_MIN_SPAN) {
+        mn -= (int16_t)((OLED_SCOPE_MIN_SPAN - span) / 2);
+        span = OLED_SCOPE_MIN_SPAN;
+    }
+
+    // uma linha de folga em cima e embaixo, para o traço não encostar no texto
+    int32_t top = s->page0 * 8 + 1, h = (s->page1 - s->page0 + 1) * 8 - 2;
+    int32_t y = top + h - 1 - (int32_t)(v - mn) * (h - 1) / span;
+    if (y < top) y = top;
+    if (y > top + h - 1) y = top + h - 1;
+
+    // liga à amostra anterior com um traço vertical nesta coluna
+    int32_t y0 = s->last_y < 0 ? y : s->last_y, y1 = y;
+    if (y0 > y1) { int32_t t = y0; y0 = y1; y1 = t; }
+    column_clear(s, s->x);
+    for (int32_t r = y0; r <= y1; r++)
+        s->p->buffer[(r >> 3) * s->p->width + s->x] |= (uint8_t)(1u << (r & 7));
+
+    s->last_y = (int16_t)y;
+    if (s->x + 1 < w) {
+        column_clear(s, (uint8_t)(s->x + 1));   // barra à frente do traço
+        s->x++;
+    } else {
+        s->x = 0;
+        s->last_y = -1;                          // não liga a borda direita à esquerda
+    }
+}
+
+bool oled_scope_flush(oled_scope_t *s, uint32_t now_ms) {
+    int32_t cap = (int32_t)(s->budget_bps * BURST_MS / 1000);
+    uint32_t dt = now_ms - s->t_ms;
+    if (dt > BURST_MS) dt = BURST_MS;
+    s->tokens += (int32_t)(dt * s->budget_bps / 1000);
+    s->t_ms = now_ms;
+    if (s->tokens > cap) s->tokens = cap;
+
+    uint32_t b = s->p->stats.bytes;          // inclui o que foi enviado fora daqui
+    s->tokens -= (int32_t)(b - s->bytes_seen);
+    s->bytes_seen = b;
+    if (s->tokens < 0) {
+        s->held++;
+        return false;
+    }
+    ssd1306_show_async(s->p);
+    s->flushes++;
+    return true;
+}
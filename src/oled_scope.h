@@ -0,0 +1,47 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ssd1306.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Traço de pulso (PPG) numa faixa de páginas do OLED, em varredura: cada
+// amostra apaga e redesenha só a sua coluna (e limpa a seguinte, a "barra"
+// que mostra onde o traço está), então o quadro que sai pelo I2C é uma faixa
+// de 2 colunas dessas páginas, não o 1 KB inteiro. O que fica fora da faixa
+// (texto) não é tocado. Escala automática pelo que está na tela.
+//
+// oled_scope_flush() manda o quadro respeitando um orçamento de bytes/s no
+// barramento do OLED (conta tudo o que o driver enviou, texto inclusive);
+// sem saldo, as colunas se acumulam no buffer e vão juntas no próximo.
+#define OLED_SCOPE_MIN_SPAN   16     // amplitude mínima (unidades do PPG) na escala
+
+typedef struct {
+    ssd1306_t *p;
+    uint8_t    page0, page1;         // faixa do traço (inclusive)
+    uint8_t    x;                    // próxima coluna
+    int16_t    last_y;               // linha da amostra anterior, -1 = nenhuma
+    int16_t    col[128];             // amostra desenhada em cada coluna
+    uint8_t    filled;               // colunas com amostra (até a largura)
+
+    uint32_t   budget_bps;           // orçamento do barramento, bytes/s
+    int32_t    tokens;               // saldo em bytes
+    uint32_t   t_ms;                 // último reabastecimento
+    uint32_t   bytes_seen;           // p->stats.bytes já descontado
+    uint32_t   samples, flushes, held;   // held: flushes adiados por falta de saldo
+} oled_scope_t;
+
+void oled_scope_init(oled_scope_t *s, ssd1306_t *p, uint8_t page0, uint8_t page1, uint32_t budget_bps);
+// limpa a faixa e recomeça na coluna 0
+void oled_scope_clear(oled_scope_t *s);
+// desenha uma amostra no buffer (não envia)
+void oled_scope_push(oled_scope_t *s, int16_t v);
+// ssd1306_show_async se o orçamento deixa; devolve se enviou
+bool oled_scope_flush(oled_scope_t *s, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
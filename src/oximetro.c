@@ -2,6 +2,7 @@
 #include <string.h>
 #include <math.h>
 #include "hardware/i2c.h"
+#include "i2c_bus.h"
 
 
 
@@ -48,19 +49,14 @@
 #define LED_CURR              0x5F   // ~19–25 mA
 
 // ====== I2C helpers ======
-static i2c_inst_t *g_i2c = NULL;
-static uint g_sda=0, g_scl=0;
+static i2c_dev_t g_dev;
 
 static inline bool w8(uint8_t r, uint8_t v){
     uint8_t b[2]={r,v};
-    int w = i2c_write_timeout_us(g_i2c, I2C_ADDR, b, 2, false, 2000);
-    return (w == 2);
+    return i2c_dev_write(&g_dev, b, 2);
 }
 static inline bool rn(uint8_t r, uint8_t *d, size_t n){
-    int w = i2c_write_timeout_us(g_i2c, I2C_ADDR, &r, 1, true, 2000);
-    if(w < 0) return false;
-    int rr = i2c_read_timeout_us(g_i2c, I2C_ADDR, d, n, false, 2000);
-    return (rr == (int)n);
+    return i2c_dev_read(&g_dev, &r, 1, d, n);
 }
 
 // ====== MAX30100 ======
@@ -160,6 +156,15 @@ static float ac_buf[AC_SAMPLES];
 static int   ac_n=0, ac_head=0;
 static uint32_t ac_last_ms=0;
 
+// forma de onda p/ o dashboard (/ws): sinal suavizado sem DC, 25 Hz, int16
+#define WAVE_DECIM            2     // 50 Hz -> 25 Hz
+#define WAVE_DC_SHIFT         5     // linha de base: EMA com alfa 1/32
+static int16_t           wave_buf[OXI_WAVE_LEN];
+static volatile uint32_t wave_head=0;          // nº total de amostras escritas
+static float             wave_dc=0;
+static uint8_t           wave_div=0;
+static float             q_live=0.0f;
+
 // histórico de estimativas p/ final
 #define EST_BUF 8
 static float bpm_hist[EST_BUF];
@@ -178,11 +183,23 @@ static inline void ac_push(float y){
     if(ac_n<AC_SAMPLES){ ac_buf[ac_head]=y; ac_head=(ac_head+1)%AC_SAMPLES; ac_n++; }
     else { ac_buf[ac_head]=y; ac_head=(ac_head+1)%AC_SAMPLES; }
 }
+static inline void wave_push(float y){
+    if(ac_n==1) wave_dc=y;                       // 1ª amostra após reset_buffers()
+    wave_dc += (y - wave_dc) / (float)(1 << WAVE_DC_SHIFT);
+    if(++wave_div < WAVE_DECIM) return;
+    wave_div=0;
+    float v = wave_dc - y;                       // invertido: pulso p/ cima
+    if(v >  32767.f) v =  32767.f;
+    if(v < -32768.f) v = -32768.f;
+    wave_buf[wave_head % OXI_WAVE_LEN] = (int16_t)v;
+    wave_head++;                                 // publica depois de escrever
+}
 static void reset_buffers(void){
     smooth_n=0; smooth_head=0; smooth_sum=0;
     ac_n=0; ac_head=0;
     est_n=0; good_estimates=0;
     bpm_live=0.0f; bpm_final=NAN;
+    q_live=0.0f; wave_div=0;
 }
 
 // calcula média da janela
@@ -281,14 +298,8 @@ static bool read_sample(float *ir_f, float *red_f){
 
 // ====== API ======
 bool oxi_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin){
-    g_i2c=i2c; g_sda=sda_pin; g_scl=scl_pin;
-
-
-
-    i2c_init(g_i2c, 100000);
-    gpio_set_function(g_sda, GPIO_FUNC_I2C);
-    gpio_set_function(g_scl, GPIO_FUNC_I2C);
-    gpio_pull_up(g_sda); gpio_pull_up(g_scl);
+    // barramento compartilhado com o TCS34725: quem chega primeiro configura
+    i2c_dev_init(&g_dev, i2c_bus_open(i2c, sda_pin, scl_pin, 100000), I2C_ADDR, "max3010x");
 
     uint8_t tmp=0;
     if(!rn(0x00,&tmp,1) && !rn(0x01,&tmp,1)) { g_inited=false; g_state=OXI_ERROR; return false; }
@@ -392,12 +403,14 @@ void oxi_poll(uint32_t now_ms){
 
         // enche janela de autocorrelação (6s)
         ac_push(y);
+        wave_push(y);
 
         // recalcula ~1x/s quando a janela está cheia
         if(ac_n == AC_SAMPLES && (now_ms - ac_last_ms) >= AC_RECOMP_MS){
             ac_last_ms = now_ms;
             float est_bpm=0, q=0;
             if(ac_estimate_bpm(&est_bpm, &q)){
+                q_live = q < 0 ? 0 : (q > 1 ? 1 : q);
                 // valida banda e qualidade
                 if(est_bpm>=BPM_MIN && est_bpm<=BPM_MAX && q>=Q_MIN){
                     // suaviza BPM live (EMA)
@@ -475,4 +488,16 @@ void oxi_get_progress(int *valid_count, int *target_valid){
     if(target_valid) *target_valid = FINAL_GOOD_EST;
 }
 float oxi_get_bpm_live(void){ return bpm_live; }
+float oxi_get_quality(void){ return q_live; }
+
+uint32_t oxi_wave_read(uint32_t *cursor, int16_t *dst, uint32_t max){
+    uint32_t head = wave_head;
+    uint32_t from = *cursor;
+    if(head - from > OXI_WAVE_LEN) from = head - OXI_WAVE_LEN;   // leitor atrasado: pula p/ o mais antigo
+    uint32_t n = head - from;
+    if(n > max) n = max;
+    for(uint32_t i=0;i<n;i++) dst[i] = wave_buf[(from + i) % OXI_WAVE_LEN];
+    *cursor = from + n;
+    return n;
+}
 float oxi_get_bpm_final(void){ return bpm_final; }
\ No newline at end of file
@@ -46,6 +46,16 @@ float oxi_get_bpm_live(void);
 /* Resultado final (após DONE). Retorna NAN se não houver. */
 float oxi_get_bpm_final(void);
 
+/* Qualidade da última estimativa (pico da autocorrelação, 0..1) */
+float oxi_get_quality(void);
+
+/* Forma de onda (PPG suavizado, sem DC, ~25 Hz) num anel de OXI_WAVE_LEN
+   amostras. `cursor` é do leitor (comece com 0): copia até `max` amostras
+   novas e o avança. Se o leitor atrasou mais que o anel, pula para a mais
+   antiga disponível. Pode ser chamado de outro contexto (ex.: lwIP). */
+#define OXI_WAVE_LEN 64
+uint32_t oxi_wave_read(uint32_t *cursor, int16_t *dst, uint32_t max);
+
 
 
 #ifdef __cplusplus
@@ -0,0 +1,23 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SHA-1 mínimo (só o handshake do WebSocket usa: Sec-WebSocket-Accept)
+typedef struct {
+    uint32_t h[5];
+    uint64_t len;        // bytes processados
+    uint8_t  blk[64];
+    uint8_t  n;          // bytes pendentes em blk
+} sha1_ctx_t;
+
+void sha1_init(sha1_ctx_t *c);
+void sha1_update(sha1_ctx_t *c, const void *data, size_t len);
+void sha1_final(sha1_ctx_t *c, uint8_t out[20]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -57,9 +57,63 @@ typedef enum {
 } ssd1306_command_t;
 
 /**
-*	@brief holds the configuration
+*	@brief bus cost counters, accumulated by ssd1306_show
+*/
+typedef struct {
+    uint32_t frames;	/**< calls to ssd1306_show */
+    uint32_t skipped;	/**< frames identical to what the panel shows (nothing sent) */
+    uint32_t bytes;		/**< bytes on the wire, address bytes included */
+    uint32_t us;		/**< time on the bus: blocking writes, or start to completion when async */
+    uint32_t coalesced;	/**< async frames replaced by a newer one before they were sent */
+    uint32_t errors;	/**< async transfers that failed or timed out */
+} ssd1306_stats_t;
+
+/**
+*	@brief one byte as written to the RP2040 IC_DATA_CMD register; this bit asks for a STOP after it
+*/
+#define SSD1306_WORD_STOP (1u<<9)
+
+/**
+*	@brief an async flush still running after this long is aborted by the next ssd1306_show_async
+*/
+#define SSD1306_FLUSH_TIMEOUT_US 100000
+
+/**
+*	@brief transport for ssd1306_show_async
+*
+*	start() gets the frame as IC_DATA_CMD words (STOP-delimited transactions
+*	to addr) and returns at once; the backend reports the end of the transfer
+*	by calling ssd1306_flush_done.
+*/
+typedef struct {
+    bool (*start)(void *ctx, uint8_t addr, const uint16_t *words, size_t n); /**< queue a transfer, false if it could not start */
+    void (*abort)(void *ctx);	/**< drop the transfer in flight */
+    void *ctx;					/**< backend state */
+} ssd1306_bus_t;
+
+/**
+*	@brief columns c0..c1 of pages p0..p1
+*/
+typedef struct {
+    uint8_t c0, c1, p0, p1;
+} ssd1306_window_t;
+
+/**
+*	@brief an encoded frame for the async transport
 */
 typedef struct {
+    uint16_t *words;			/**< IC_DATA_CMD words */
+    size_t n;					/**< words used */
+    ssd1306_window_t win[8];	/**< windows, in the order they are encoded */
+    uint8_t nwin;				/**< windows used */
+} ssd1306_tx_t;
+
+typedef struct ssd1306 ssd1306_t;
+
+/**
+*	@brief holds the configuration
+*/
+struct ssd1306 {
     uint8_t width; 		/**< width of display */
     uint8_t height; 	/**< height of display */
     uint8_t pages;		/**< stores pages of display (calculated on initialization*/
@@ -68,7 +122,17 @@ typedef struct {
     bool external_vcc; 	/**< whether display uses external vcc */ 
     uint8_t *buffer;	/**< display buffer */
     size_t bufsize;		/**< buffer size */
-} ssd1306_t;
+    uint8_t *shadow;	/**< copy of the panel RAM, diffed against buffer on show */
+    bool shadow_valid;	/**< false: next show sends the whole frame */
+    ssd1306_stats_t stats;	/**< bus cost counters */
+    const ssd1306_bus_t *bus;	/**< async transport, NULL until ssd1306_async_init */
+    ssd1306_tx_t tx[2];		/**< tx[front] is on the wire, the other one waits */
+    uint8_t front;			/**< index of the frame in flight */
+    volatile bool busy;		/**< tx[front] is on the wire */
+    volatile bool pending;	/**< the back frame is ready to go */
+    uint32_t busy_since;	/**< time_us_32 when the transfer started */
+    void (*on_done)(ssd1306_t *p, bool ok);	/**< completion callback */
+};
 
 /**
 *	@brief initialize display
@@ -130,11 +194,71 @@ void ssd1306_invert(ssd1306_t *p, uint8_t inv);
 /**
 	@brief display buffer, should be called on change
 
+	Only pages that differ from the last frame sent are transmitted, each as
+	a column window (or one full-width block when that costs fewer bytes).
+	An unchanged frame sends nothing.
+
 	@param[in] p : instance of display
 
 */
 void ssd1306_show(ssd1306_t *p);
 
+/**
+	@brief attach an async transport
+
+	Allocates the two encoded-frame buffers. While a transfer is on the bus
+	the blocking calls (ssd1306_show, contrast, power, ...) must not be used.
+
+	@param[in] p : instance of display
+	@param[in] bus : transport, must outlive p
+	@param[in] done : called after each transfer, from the context that
+		calls ssd1306_flush_done (an IRQ on the RP2040); may be NULL
+
+	@return false if out of memory
+*/
+bool ssd1306_async_init(ssd1306_t *p, const ssd1306_bus_t *bus, void (*done)(ssd1306_t *p, bool ok));
+
+/**
+	@brief display buffer without waiting for the bus
+
+	The changed windows are encoded at once, so the buffer can be redrawn as
+	soon as this returns. Besides the windows ssd1306_show uses, a change
+	confined to a few columns of several pages goes as one column strip. If a transfer is in flight the frame waits in the
+	second buffer and goes out when it completes; a newer frame replaces it
+	(only the latest is sent). Without a transport this is ssd1306_show.
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_show_async(ssd1306_t *p);
+
+/**
+	@brief end of an async transfer, called by the transport
+
+	Starts the waiting frame, if any, then calls the completion callback.
+
+	@param[in] p : instance of display
+	@param[in] ok : false if the transfer failed (the next frame is sent whole)
+
+*/
+void ssd1306_flush_done(ssd1306_t *p, bool ok);
+
+/**
+	@brief whether a frame is on the bus or waiting for it
+
+	@param[in] p : instance of display
+
+*/
+bool ssd1306_busy(const ssd1306_t *p);
+
+/**
+	@brief forget what the panel shows: next ssd1306_show sends the whole frame
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_invalidate(ssd1306_t *p);
+
 /**
 	@brief clear display buffer
 
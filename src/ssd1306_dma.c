@@ -0,0 +1,69 @@
+#include <pico/stdlib.h>
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+
+#include "ssd1306_dma.h"
+
+static ssd1306_t *s_oled;
+static int s_chan=-1;
+static ssd1306_bus_t s_bus;
+
+static bool dma_start(void *ctx, uint8_t addr, const uint16_t *words, size_t n) {
+    i2c_inst_t *i2c=ctx;
+    i2c_hw_t *hw=i2c_get_hw(i2c);
+
+    // TAR only changes with the controller off, which also flushes the FIFO:
+    // skip it when the previous frame (same device) may still be draining
+    if(hw->tar!=addr) {
+        hw->enable=0;
+        hw->tar=addr;
+        hw->enable=1;
+    }
+    (void)hw->clr_tx_abrt;
+
+    dma_channel_config c=dma_channel_get_default_config(s_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    dma_channel_configure(s_chan, &c, &hw->data_cmd, words, n, true);
+    return true;
+}
+
+static void dma_abort(void *ctx) {
+    i2c_hw_t *hw=i2c_get_hw((i2c_inst_t *)ctx);
+    dma_channel_abort(s_chan);
+    dma_hw->ints1=1u<<s_chan;
+    hw->enable=0;       // flushes whatever is left in the FIFO
+    hw->enable=1;
+}
+
+// the last word is in the FIFO: the bus still has up to 16 bytes to clock
+// out, but the next frame can already be queued behind them
+static void dma_irq(void) {
+    if(!(dma_hw->ints1&(1u<<s_chan)))
+        return;
+    dma_hw->ints1=1u<<s_chan;
+
+    i2c_hw_t *hw=i2c_get_hw(s_oled->i2c_i);
+    bool ok=!(hw->raw_intr_stat&I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS);
+    if(!ok)
+        (void)hw->clr_tx_abrt;
+    ssd1306_flush_done(s_oled, ok);
+}
+
+bool ssd1306_dma_attach(ssd1306_t *p, void (*done)(ssd1306_t *p, bool ok)) {
+    if(s_chan<0 && (s_chan=dma_claim_unused_channel(false))<0)
+        return false;
+
+    s_oled=p;
+    s_bus=(ssd1306_bus_t) {dma_start, dma_abort, p->i2c_i};
+    if(!ssd1306_async_init(p, &s_bus, done))
+        return false;
+
+    irq_add_shared_handler(DMA_IRQ_1, dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq1_enabled(s_chan, true);
+    irq_set_enabled(DMA_IRQ_1, true);
+    return true;
+}
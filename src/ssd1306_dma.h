@@ -0,0 +1,26 @@
+/**
+* @file ssd1306_dma.h
+*
+* RP2040 transport for ssd1306_show_async: the encoded frame goes from RAM to
+* the I2C TX FIFO by DMA, the DMA interrupt reports completion.
+*/
+
+#ifndef _inc_ssd1306_dma
+#define _inc_ssd1306_dma
+#include "ssd1306.h"
+
+/**
+	@brief claim a DMA channel and attach it to an initialized display
+
+	Only one display can use it. The channel's completion interrupt is
+	DMA_IRQ_1 (shared handler), so done runs in IRQ context.
+
+	@param[in] p : instance of display, after ssd1306_init
+	@param[in] done : completion callback, may be NULL
+
+	@return false if no DMA channel is free or out of memory; the display
+		keeps working with blocking writes
+*/
+bool ssd1306_dma_attach(ssd1306_t *p, void (*done)(ssd1306_t *p, bool ok));
+
+#endif
@@ -25,7 +25,9 @@ SOFTWARE.
 
 #include <pico/stdlib.h>
 #include "hardware/i2c.h"
+#include "hardware/sync.h"
 #include <pico/binary_info.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -39,17 +41,20 @@ inline static void swap(int32_t *a, int32_t *b) {
     *b=*t;
 }
 
-inline static void fancy_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, char *name) {
+// address byte + control byte + 6 commands, then address byte + 0x40
+#define SSD1306_WINDOW_OVERHEAD 10
+
+inline static bool fancy_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, char *name) {
     switch(i2c_write_blocking(i2c, addr, src, len, false)) {
     case PICO_ERROR_GENERIC:
         printf("[%s] addr not acknowledged!\n", name);
-        break;
+        return false;
     case PICO_ERROR_TIMEOUT:
         printf("[%s] timeout!\n", name);
-        break;
+        return false;
     default:
         //printf("[%s] wrote successfully %lu bytes!\n", name, len);
-        break;
+        return true;
     }
 }
 
@@ -58,6 +63,17 @@ inline static void ssd1306_write(ssd1306_t *p, uint8_t val) {
     fancy_write(p->i2c_i, p->address, d, 2, "ssd1306_write");
 }
 
+// one transaction: control byte 0x00 (Co=0) followed by all the commands
+static bool ssd1306_write_cmds(ssd1306_t *p, const uint8_t *cmds, size_t n) {
+    uint8_t d[40];
+    if(n>sizeof(d)-1)
+        n=sizeof(d)-1;
+    d[0]=0x00;
+    memcpy(d+1, cmds, n);
+    p->stats.bytes+=n+2;
+    return fancy_write(p->i2c_i, p->address, d, n+1, "ssd1306_write_cmds");
+}
+
 bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance) {
     p->width=width;
     p->height=height;
@@ -68,12 +84,18 @@ bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address
 
 
     p->bufsize=(p->pages)*(p->width);
-    if((p->buffer=malloc(p->bufsize+1))==NULL) {
+    // [0x40][buffer][shadow]: one allocation, freed by ssd1306_deinit
+    if((p->buffer=malloc(2*p->bufsize+1))==NULL) {
         p->bufsize=0;
         return false;
     }
 
     ++(p->buffer);
+    p->shadow=p->buffer+p->bufsize;
+    p->shadow_valid=false;
+    memset(&p->stats, 0, sizeof(p->stats));
+    p->bus=NULL;
+    p->busy=p->pending=false;
 
     // from https://github.com/makerportal/rpi-pico-ssd1306
     uint8_t cmds[]= {
@@ -109,10 +131,7 @@ bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address
         0x00,  // horizontal
     };
 
-    for(size_t i=0; i<sizeof(cmds); ++i)
-        ssd1306_write(p, cmds[i]);
-
-    return true;
+    return ssd1306_write_cmds(p, cmds, sizeof(cmds));
 }
 
 inline void ssd1306_deinit(ssd1306_t *p) {
@@ -128,8 +147,8 @@ inline void ssd1306_poweron(ssd1306_t *p) {
 }
 
 inline void ssd1306_contrast(ssd1306_t *p, uint8_t val) {
-    ssd1306_write(p, SET_CONTRAST);
-    ssd1306_write(p, val);
+    uint8_t cmds[]= {SET_CONTRAST, val};
+    ssd1306_write_cmds(p, cmds, sizeof(cmds));
 }
 
 inline void ssd1306_invert(ssd1306_t *p, uint8_t inv) {
@@ -193,10 +212,22 @@ void ssd1306_draw_empty_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t wi
     ssd1306_draw_line(p, x+width, y, x+width, y+height);
 }
 
-void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
-    if(c<font[3]||c>font[4])
-        return;
+// scale 2..4: nibble of a font column -> the same bits, each repeated scale times
+static const uint16_t ssd1306_expand_tab[3][16]= {
+    {0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F, 0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF},
+    {0x000, 0x007, 0x038, 0x03F, 0x1C0, 0x1C7, 0x1F8, 0x1FF, 0xE00, 0xE07, 0xE38, 0xE3F, 0xFC0, 0xFC7, 0xFF8, 0xFFF},
+    {0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF, 0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF},
+};
+
+static inline uint32_t ssd1306_expand(uint8_t b, uint32_t scale) {
+    if(scale==1)
+        return b;
+    const uint16_t *t=ssd1306_expand_tab[scale-2];
+    return t[b&15]|(uint32_t)t[b>>4]<<(4*scale);
+}
 
+// pixel by pixel, for scales without an expansion table
+static void ssd1306_draw_char_slow(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
     uint32_t parts_per_line=(font[0]>>3)+((font[0]&7)>0);
     for(uint8_t w=0; w<font[1]; ++w) { // width
         uint32_t pp=(c-font[3])*font[1]*parts_per_line+w*parts_per_line+5;
@@ -213,6 +244,64 @@ void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t
     }
 }
 
+// Font columns are bytes with the top pixel in bit 0, the same layout as a
+// page of the buffer: each one (expanded by scale) is shifted by y%8 and
+// ORed into the pages it covers.
+void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
+    if(c<font[3]||c>font[4])
+        return;
+    if(scale>4) {
+        ssd1306_draw_char_slow(p, x, y, scale, font, c);
+        return;
+    }
+
+    uint32_t parts_per_line=(font[0]>>3)+((font[0]&7)>0);
+    const uint8_t *g=font+5+(c-font[3])*font[1]*parts_per_line;
+
+    // the common case: 8 px font, scale 1, whole glyph on screen
+    if(scale==1 && parts_per_line==1 && x<p->width && x+font[1]<=p->width && y<p->height) {
+        uint8_t *d=p->buffer+(y>>3)*p->width+x;
+        uint32_t shift=y&7;
+        bool below=shift && (y>>3)+1<p->pages;
+        for(uint8_t w=0; w<font[1]; ++w) {
+            uint32_t v=(uint32_t)g[w]<<shift;
+            d[w]|=(uint8_t)v;
+            if(below)
+                d[w+p->width]|=(uint8_t)(v>>8);
+        }
+        return;
+    }
+
+    for(uint8_t w=0; w<font[1]; ++w, g+=parts_per_line) {
+        // columns of this font column, clipped to the screen
+        int32_t xs=(int32_t)(x+w*scale);
+        int32_t x0=xs<0?0:xs, x1=xs+(int32_t)scale;
+        if(x1>p->width)
+            x1=p->width;
+        if(x0>=x1)
+            continue;
+        for(uint32_t lp=0; lp<parts_per_line; ++lp) {
+            if(!g[lp])
+                continue;
+            // top row of this part; y "above" the screen clips the top bits
+            int32_t row=(int32_t)(y+lp*8*scale);
+            uint64_t v=ssd1306_expand(g[lp], scale);
+            uint32_t pg=0;
+            if(row<0)
+                v=row>-32?v>>-row:0;
+            else {
+                pg=row>>3;
+                v<<=row&7;
+            }
+            for(; v && pg<p->pages; ++pg, v>>=8) {
+                uint8_t *d=p->buffer+pg*p->width;
+                for(int32_t i=x0; i<x1; ++i)
+                    d[i]|=(uint8_t)v;
+            }
+        }
+    }
+}
+
 void ssd1306_draw_string_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, const char *s) {
     for(int32_t x_n=x; *s; x_n+=(font[1]+font[2])*scale) {
         ssd1306_draw_char_with_font(p, x_n, y, scale, font, *(s++));
@@ -290,17 +379,231 @@ inline void ssd1306_bmp_show_image(ssd1306_t *p, const uint8_t *data, const long
     ssd1306_bmp_show_image_with_offset(p, data, size, 0, 0);
 }
 
+inline void ssd1306_invalidate(ssd1306_t *p) {
+    p->shadow_valid=false;
+}
+
+// Sends columns c0..c1 of pages p0..p1. The data has to be contiguous in the
+// buffer: a single page, or full-width rows. The byte before it is borrowed
+// for the 0x40 control byte (buffer[-1] is reserved for that at column 0).
+static bool ssd1306_send_window(ssd1306_t *p, const ssd1306_window_t *w) {
+    uint8_t off=p->width==64?32:0;
+    uint8_t cmds[]= {SET_COL_ADDR, w->c0+off, w->c1+off, SET_PAGE_ADDR, w->p0, w->p1};
+    if(!ssd1306_write_cmds(p, cmds, sizeof(cmds)))
+        return false;
+
+    uint8_t *d=p->buffer+w->p0*p->width+w->c0-1;
+    size_t len=(size_t)(w->p1-w->p0)*p->width+(w->c1-w->c0+1);
+    uint8_t saved=*d;
+    *d=0x40;
+    bool ok=fancy_write(p->i2c_i, p->address, d, len+1, "ssd1306_show");
+    *d=saved;
+    p->stats.bytes+=len+2;
+    return ok;
+}
+
+// diff buffer against shadow: one window per changed page, one full-width
+// block, or (strip) one window spanning the changed columns of all changed
+// pages, whichever costs fewer bytes. A strip is not contiguous in the
+// buffer, so only the encoded (async) path can send it. Returns the window
+// count, 0 = unchanged.
+static uint8_t ssd1306_plan(ssd1306_t *p, ssd1306_window_t *win, bool strip) {
+    int16_t lo[8], hi[8];           // changed columns per page, -1 = clean
+    int16_t first=-1, last=-1, cmin=p->width, cmax=-1;
+    size_t windows=0;
+
+    for(uint8_t pg=0; pg<p->pages && pg<8; ++pg) {
+        const uint8_t *a=p->buffer+pg*p->width;
+        const uint8_t *b=p->shadow+pg*p->width;
+        lo[pg]=hi[pg]=-1;
+        if(p->shadow_valid && !memcmp(a, b, p->width))
+            continue;
+        int16_t l=0, h=p->width-1;
+        if(p->shadow_valid) {
+            while(a[l]==b[l]) ++l;
+            while(a[h]==b[h]) --h;
+        }
+        lo[pg]=l;
+        hi[pg]=h;
+        windows+=h-l+1+SSD1306_WINDOW_OVERHEAD;
+        if(l<cmin)
+            cmin=l;
+        if(h>cmax)
+            cmax=h;
+        if(first<0)
+            first=pg;
+        last=pg;
+    }
+
+    if(first<0)
+        return 0;
+
+    size_t block=(size_t)(last-first+1)*p->width+SSD1306_WINDOW_OVERHEAD;
+    size_t column=strip?(size_t)(last-first+1)*(cmax-cmin+1)+SSD1306_WINDOW_OVERHEAD:SIZE_MAX;
+    if(block<=windows && block<=column) {
+        win[0]=(ssd1306_window_t) {0, p->width-1, first, last};
+        return 1;
+    }
+    if(column<windows) {
+        win[0]=(ssd1306_window_t) {cmin, cmax, first, last};
+        return 1;
+    }
+    uint8_t n=0;
+    for(int16_t pg=first; pg<=last; ++pg)
+        if(lo[pg]>=0)
+            win[n++]=(ssd1306_window_t) {lo[pg], hi[pg], pg, pg};
+    return n;
+}
+
 void ssd1306_show(ssd1306_t *p) {
-    uint8_t payload[]= {SET_COL_ADDR, 0, p->width-1, SET_PAGE_ADDR, 0, p->pages-1};
-    if(p->width==64) {
-        payload[1]+=32;
-        payload[2]+=32;
+    ssd1306_window_t win[8];
+
+    ++p->stats.frames;
+    uint8_t n=ssd1306_plan(p, win, false);
+    if(!n) {
+        ++p->stats.skipped;
+        return;
+    }
+
+    uint32_t t0=time_us_32();
+    bool ok=true;
+    for(uint8_t i=0; i<n; ++i)
+        ok&=ssd1306_send_window(p, &win[i]);
+    p->stats.us+=time_us_32()-t0;
+
+    // a failed write leaves the panel unknown: resend everything next time
+    memcpy(p->shadow, p->buffer, p->bufsize);
+    p->shadow_valid=ok;
+}
+
+/* ---------- asynchronous flush ---------- */
+
+// control byte + 6 commands, then control byte 0x40, per window
+#define SSD1306_WORDS_PER_WINDOW 8
+
+// the frame as IC_DATA_CMD words: each window is a command transaction and a
+// data transaction, the last byte of each flagged with STOP
+static void ssd1306_encode(ssd1306_t *p, ssd1306_tx_t *tx) {
+    uint8_t off=p->width==64?32:0;
+    uint16_t *w=tx->words;
+
+    tx->nwin=ssd1306_plan(p, tx->win, true);
+    for(uint8_t i=0; i<tx->nwin; ++i) {
+        const ssd1306_window_t *v=&tx->win[i];
+        *w++=0x00;
+        *w++=SET_COL_ADDR;
+        *w++=v->c0+off;
+        *w++=v->c1+off;
+        *w++=SET_PAGE_ADDR;
+        *w++=v->p0;
+        *w++=v->p1|SSD1306_WORD_STOP;
+        *w++=0x40;
+        for(uint8_t pg=v->p0; pg<=v->p1; ++pg) {
+            const uint8_t *src=p->buffer+pg*p->width;
+            for(uint8_t c=v->c0; c<=v->c1; ++c)
+                *w++=src[c];
+        }
+        w[-1]|=SSD1306_WORD_STOP;
+    }
+    tx->n=w-tx->words;
+}
+
+// the panel will show tx once it is on the wire: fold its windows into shadow
+static void ssd1306_commit(ssd1306_t *p, const ssd1306_tx_t *tx) {
+    const uint16_t *w=tx->words;
+    for(uint8_t i=0; i<tx->nwin; ++i) {
+        const ssd1306_window_t *v=&tx->win[i];
+        w+=SSD1306_WORDS_PER_WINDOW;
+        for(uint8_t pg=v->p0; pg<=v->p1; ++pg)
+            for(uint8_t c=v->c0; c<=v->c1; ++c)
+                p->shadow[pg*p->width+c]=(uint8_t)*w++;
+    }
+    p->shadow_valid=true;
+}
+
+// hand tx[front] to the bus; interrupts off
+static void ssd1306_start(ssd1306_t *p) {
+    const ssd1306_tx_t *tx=&p->tx[p->front];
+    ssd1306_commit(p, tx);
+    p->stats.bytes+=tx->n+2*tx->nwin;
+    p->busy_since=time_us_32();
+    p->busy=true;
+    if(!p->bus->start(p->bus->ctx, p->address, tx->words, tx->n)) {
+        p->busy=false;
+        p->shadow_valid=false;
+        ++p->stats.errors;
+    }
+}
+
+bool ssd1306_async_init(ssd1306_t *p, const ssd1306_bus_t *bus, void (*done)(ssd1306_t *p, bool ok)) {
+    size_t max=(size_t)p->pages*(p->width+SSD1306_WORDS_PER_WINDOW);
+    uint16_t *w=malloc(2*max*sizeof(uint16_t));
+    if(w==NULL)
+        return false;
+    p->tx[0].words=w;
+    p->tx[1].words=w+max;
+    p->front=0;
+    p->busy=p->pending=false;
+    p->on_done=done;
+    p->bus=bus;
+    return true;
+}
+
+void ssd1306_show_async(ssd1306_t *p) {
+    if(p->bus==NULL) {
+        ssd1306_show(p);
+        return;
     }
 
-    for(size_t i=0; i<sizeof(payload); ++i)
-        ssd1306_write(p, payload[i]);
+    ++p->stats.frames;
+    uint32_t irq=save_and_disable_interrupts();
+    if(p->busy && time_us_32()-p->busy_since>SSD1306_FLUSH_TIMEOUT_US) {
+        // never completed (bus held low?): drop it, the panel is unknown now
+        p->bus->abort(p->bus->ctx);
+        p->busy=p->pending=false;
+        p->shadow_valid=false;
+        ++p->stats.errors;
+    }
 
-    *(p->buffer-1)=0x40;
+    if(p->busy) {
+        // shadow already holds the frame in flight: diff against it into the
+        // back buffer, replacing any frame still waiting there
+        ssd1306_tx_t *tx=&p->tx[p->front^1];
+        if(p->pending)
+            ++p->stats.coalesced;
+        ssd1306_encode(p, tx);
+        p->pending=tx->nwin>0;
+        if(!p->pending)
+            ++p->stats.skipped;
+    } else {
+        ssd1306_tx_t *tx=&p->tx[p->front];
+        ssd1306_encode(p, tx);
+        if(tx->nwin)
+            ssd1306_start(p);
+        else
+            ++p->stats.skipped;
+    }
+    restore_interrupts(irq);
+}
 
-    fancy_write(p->i2c_i, p->address, p->buffer-1, p->bufsize+1, "ssd1306_show");
-}
\ No newline at end of file
+void ssd1306_flush_done(ssd1306_t *p, bool ok) {
+    p->stats.us+=time_us_32()-p->busy_since;
+    p->busy=false;
+    if(!ok) {
+        // what was pending diffs against a panel we no longer know
+        p->pending=false;
+        p->shadow_valid=false;
+        ++p->stats.errors;
+    }
+    if(p->pending) {
+        p->pending=false;
+        p->front^=1;
+        ssd1306_start(p);
+    }
+    if(p->on_done)
+        p->on_done(p, ok);
+}
+
+bool ssd1306_busy(const ssd1306_t *p) {
+    return p->busy || p->pending;
+}
@@ -0,0 +1,21 @@
+#include "stackmark.h"
+#include <stdint.h>
+
+// Limites da pilha do core 0 (scratch Y), definidos no linker script do SDK
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+
+#define STACKMARK_WORD   0x5AC0FFEEu
+#define STACKMARK_MARGIN 16           // palavras poupadas abaixo do frame atual
+
+__attribute__((noinline)) void stackmark_paint(void) {
+    uint32_t *p   = &__StackBottom;
+    uint32_t *end = (uint32_t *)__builtin_frame_address(0) - STACKMARK_MARGIN;
+    while (p < end) *p++ = STACKMARK_WORD;
+}
+
+uint32_t stackmark_free_min(void) {
+    const uint32_t *p = &__StackBottom;
+    while (p < &__StackTop && *p == STACKMARK_WORD) p++;
+    return (uint32_t)((uintptr_t)p - (uintptr_t)&__StackBottom);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Marca d'água da pilha do core 0: pinta a área livre no boot e mede depois
+// quanto nunca foi tocado (pior caso desde o boot).
+void     stackmark_paint(void);          // chamar no início do main()
+uint32_t stackmark_free_min(void);       // bytes da pilha nunca usados
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,5 @@
 #include "stats.h"
+#include "fmt.h"
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
@@ -221,6 +222,10 @@ void appstats_add_humor(uint8_t level) {
     s_sample_id++;
 }
 
+uint32_t stats_get_sample_id(void) {
+    return s_sample_id;
+}
+
 static void fill_snapshot_overall(stats_snapshot_t *out) {
     out->sample_id = s_sample_id;
 
@@ -304,16 +309,6 @@ size_t appstats_dump_csv(char *dst, size_t maxlen) {
     stats_snapshot_t s;
     appstats_get_snapshot(&s);
 
-    // Se vier NaN, substitui por 0 para não imprimir "nan"
-    double bpm_mean = isnan(s.bpm_mean_trimmed) ? 0.0 : s.bpm_mean_trimmed;
-    double bpm_last = isnan(s.bpm_last)         ? 0.0 : s.bpm_last;
-    double bpm_std  = isnan(s.bpm_stddev)       ? 0.0 : s.bpm_stddev;
-    double ans_mean = isnan(s.ans_mean)         ? 0.0 : s.ans_mean;
-    double ene_mean = isnan(s.energy_mean)      ? 0.0 : s.energy_mean;
-    double hum_mean = isnan(s.humor_mean)       ? 0.0 : s.humor_mean;
-    double wellbeing = isnan(s.wellbeing_index) ? 0.0 : s.wellbeing_index;
-    double calm      = isnan(s.calm_index)      ? 0.0 : s.calm_index;
-
     size_t total = 0;
 
     int w = snprintf(dst + total, (total < maxlen) ? (maxlen - total) : 0,
@@ -322,19 +317,33 @@ size_t appstats_dump_csv(char *dst, size_t maxlen) {
     total += (size_t)((w > 0) ? w : 0);
     if (total >= maxlen) return maxlen;
 
-    w = snprintf(dst + total, (total < maxlen) ? (maxlen - total) : 0,
-                 "%.3f,%.3f,%.3f,%lu,%.3f,%lu,%.3f,%lu,%.3f,%lu,%lu,%lu,%lu,%.3f,%.3f\r\n",
-                 bpm_mean,  bpm_last, bpm_std, (unsigned long)s.bpm_count,
-                 ans_mean,  (unsigned long)s.ans_count,
-                 ene_mean,  (unsigned long)s.energy_count,
-                 hum_mean,  (unsigned long)s.humor_count,
-                 (unsigned long)s.cor_verde,
-                 (unsigned long)s.cor_amarelo,
-                 (unsigned long)s.cor_vermelho,
-                 wellbeing,
-                 calm);
-    if (w < 0) return total;
-    total += (size_t)((w > 0) ? w : 0);
+    // Linha de dados com fmt.h (sem float no printf); NaN vira 0, não "null"
+    #define NZ(x) (isnan(x) ? 0.f : (x))
+    char row[15 * FMT_NUM_MAX + 2];
+    char *p = row;
+    p = fmt_fixed(p, NZ(s.bpm_mean_trimmed), 3); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.bpm_last), 3); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.bpm_stddev), 3); *p++ = ',';
+    p = fmt_u32(p, s.bpm_count); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.ans_mean), 3); *p++ = ',';
+    p = fmt_u32(p, s.ans_count); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.energy_mean), 3); *p++ = ',';
+    p = fmt_u32(p, s.energy_count); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.humor_mean), 3); *p++ = ',';
+    p = fmt_u32(p, s.humor_count); *p++ = ',';
+    p = fmt_u32(p, s.cor_verde); *p++ = ',';
+    p = fmt_u32(p, s.cor_amarelo); *p++ = ',';
+    p = fmt_u32(p, s.cor_vermelho); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.wellbeing_index), 3); *p++ = ',';
+    p = fmt_fixed(p, NZ(s.calm_index), 3);
+    p = fmt_str(p, "\r\n");
+    #undef NZ
+
+    size_t n = (size_t)(p - row);
+    size_t room = maxlen - total - 1;              // deixa o NUL, como o snprintf
+    memcpy(dst + total, row, n < room ? n : room);
+    dst[total + (n < room ? n : room)] = 0;
+    total += n;
 
     if (total > maxlen) total = maxlen;
     return total;
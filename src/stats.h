@@ -11,6 +11,7 @@
 #define stats_dump_csv               appstats_dump_csv
 // NEW: getter da cor corrente do ciclo
 #define stats_get_current_color      appstats_get_current_color
+#define stats_get_sample_id          appstats_get_sample_id
 
 #pragma once
 #include <stdint.h>
@@ -78,5 +79,8 @@ void   stats_get_snapshot(stats_snapshot_t *out);
 // Snapshot filtrado por cor específica
 void   stats_get_snapshot_by_color(stat_color_t color, stats_snapshot_t *out);
 
+// Contador que muda a cada nova amostra (o /events usa para saber quando empurrar)
+uint32_t stats_get_sample_id(void);
+
 // Gera CSV agregado para download (/download.csv)
 size_t stats_dump_csv(char *dst, size_t maxlen);
@@ -2,11 +2,30 @@
 //   /                -> Painel do profissional (com filtro por grupo e KPIs)
 //   /display         -> Espelho do OLED (redireciona p/ /survey via /survey_state.json)
 //   /oled.json       -> JSON com as 4 linhas do OLED
+//   /fb.bin          -> Framebuffer do OLED (1 KB) em RLE, ou delta desde ?v=N;
+//                       304 se nada mudou (desenhado num canvas no /display)
 //   /stats.json      -> Métricas + "survey" agregado (aceita ?color=verde|amarelo|vermelho)
+//   /stats.bin       -> Mesmo conteúdo em binário fixo little-endian (v1, 128 bytes)
 //   /download.csv    -> CSV agregado (stats.c)
 //   /survey          -> Questionário (10 perguntas sim/não)
-//   /survey_submit   -> Submissão (?ans=10 bits)
+//   /survey_submit   -> Submissão (GET ?ans=10 bits ou POST ans=10 bits)
 //   /survey_state.json -> {"mode":0|1}
+//   /events          -> Server-Sent Events (?stats&color=..., ?oled&survey): empurra
+//                       mudanças em vez de o navegador ficar consultando
+//   /ws              -> WebSocket binário com a onda PPG (~25 Hz) + BPM ao vivo
+//   /metrics         -> Contadores e histogramas do servidor (texto Prometheus)
+//   /metrics.json    -> Idem em JSON
+//   /bench           -> Teste de vazão do AP (página para o instalador)
+//   /bench/down      -> ?bytes=N gerados da flash, sem cópia
+//   /bench/up        -> POST de N bytes descartados; responde com /bench.json
+//   /bench.json      -> Último teste de cada sentido, medido no servidor
+//
+// As páginas HTML/CSS/JS ficam em web/ e viram web_assets.c no build
+// (tools/gen_web_assets.py: minify + gzip; servidas com Content-Encoding: gzip
+// quando o cliente aceita; ETag + 304 nas recargas).
+//
+// Só depende do lwIP (raw API, NO_SYS) e de time_us_32(): o rádio fica em
+// web_ap_cyw43.c, e host/ compila este arquivo no Linux sobre uma tap.
 
 #include <stdio.h>
 #include <string.h>
@@ -14,24 +33,29 @@
 #include <stdbool.h>
 #include <math.h>
 #include <stdint.h>
+#include <ctype.h>
+#include <strings.h>
 
 #include "pico/stdlib.h"
-#include "pico/cyw43_arch.h"
 #include "lwip/tcp.h"
 #include "lwip/inet.h"
+#include "lwip/timeouts.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
 
 #include "dhcpserver/dhcpserver.h"
 #include "dnsserver/dnsserver.h"
 
 #include "stats.h"
+#include "oximetro.h"
+#include "i2c_bus.h"
+#include "sha1.h"
+#include "fmt.h"
+#include "http_parse.h"
+#include "stackmark.h"
 #include "web_ap.h"
+#include "web_assets.h"
 
-#ifndef CYW43_AUTH_WPA2_AES_PSK
-#define CYW43_AUTH_WPA2_AES_PSK 4
-#endif
-
-#define AP_SSID   "TheraLink"
-#define AP_PASS   ""
 #define HTTP_PORT 80
 
 static dhcp_server_t s_dhcp;
@@ -43,11 +67,57 @@ typedef struct {
 } oled_state_t;
 static oled_state_t g_oled = { "", "", "", "" };
 
+/* ---------- Eventos pendentes p/ /events ----------
+   Só marcam "algo mudou" (podem vir do laço principal); o timer do SSE, no
+   contexto do lwIP, lê o estado atual e distribui para os clientes. */
+static volatile bool s_sse_oled_dirty   = false;
+static volatile bool s_sse_survey_dirty = false;
+static volatile bool s_sse_stats_dirty  = false;
+
+static bool oled_set_line(char *dst, size_t n, const char *src) {
+    if (!src) src = "";
+    if (!strncmp(dst, src, n - 1)) return false;
+    snprintf(dst, n, "%s", src);
+    return true;
+}
+
 void web_display_set_lines(const char *l1, const char *l2, const char *l3, const char *l4) {
-    snprintf(g_oled.l1, sizeof g_oled.l1, "%s", l1 ? l1 : "");
-    snprintf(g_oled.l2, sizeof g_oled.l2, "%s", l2 ? l2 : "");
-    snprintf(g_oled.l3, sizeof g_oled.l3, "%s", l3 ? l3 : "");
-    snprintf(g_oled.l4, sizeof g_oled.l4, "%s", l4 ? l4 : "");
+    bool changed = false;
+    changed |= oled_set_line(g_oled.l1, sizeof g_oled.l1, l1);
+    changed |= oled_set_line(g_oled.l2, sizeof g_oled.l2, l2);
+    changed |= oled_set_line(g_oled.l3, sizeof g_oled.l3, l3);
+    changed |= oled_set_line(g_oled.l4, sizeof g_oled.l4, l4);
+    if (changed) s_sse_oled_dirty = true;
+}
+
+/* ---------- Framebuffer do OLED (espelho bit a bit p/ /fb.bin) ----------
+   Em vez de guardar quadros antigos, cada byte lembra a versão (16 bits
+   baixos) em que mudou pela última vez: o delta "desde a versão N" de
+   qualquer cliente sai de um quadro só. Sem trava, como o resto do espelho:
+   o laço principal escreve byte e depois versão, e publica a versão do
+   quadro por último. Um leitor no meio da escrita pode mandar byte novo com
+   a versão velha; o próximo delta (v=versão velha) manda de novo. */
+#define FB_SIZE  1024
+#define FB_PAGES 8
+#define FB_WIDTH 128
+static uint8_t           g_fb[FB_SIZE];
+static uint16_t          g_fb_ver[FB_SIZE];
+static volatile uint32_t s_fb_version = 0;     // 0 = nenhum quadro ainda
+static uint32_t          s_fb_delta = 0, s_fb_key = 0, s_fb_304 = 0;
+
+void web_display_set_fb(const uint8_t *fb, size_t len) {
+    if (!fb || len != FB_SIZE) return;
+    uint32_t v = s_fb_version + 1;
+    bool changed = v == 1;                     // o primeiro quadro conta mesmo todo zerado
+    for (size_t i = 0; i < FB_SIZE; i++) {
+        if (g_fb[i] == fb[i]) continue;
+        g_fb[i] = fb[i];
+        g_fb_ver[i] = (uint16_t)v;
+        changed = true;
+    }
+    if (!changed) return;
+    s_fb_version = v;
+    s_sse_oled_dirty = true;
 }
 
 /* ---------- Survey (estado + agregados em RAM) ---------- */
@@ -84,6 +154,7 @@ void web_set_survey_mode(bool on) {
     } else {
         s_survey_mode = false;
     }
+    s_sse_survey_dirty = true;
 }
 
 
@@ -119,6 +190,7 @@ void web_assign_survey_token_to_color(uint32_t token, stat_color_t color) {
     for (int i = 0; i < 10; i++) {
         if (bits & (1u << i)) s_svy_yes_c[color][i] += 1;
     }
+    s_sse_stats_dirty = true;
 }
 
 /* ============ Wrappers p/ compatibilidade antiga ============ */
@@ -130,324 +202,119 @@ bool web_take_survey(char out_bits_10[11]) {
     return true;
 }
 
-/* ---------- TX state ---------- */
-typedef struct { const char *buf; u16_t len; u16_t off; } http_tx_t;
-static http_tx_t g_tx = {0};
-static char g_resp[8192];
-
-static bool http_send_chunk(struct tcp_pcb *tpcb) {
-    while (g_tx.off < g_tx.len) {
-        u16_t wnd = tcp_sndbuf(tpcb);
-        if (!wnd) break;
-        u16_t chunk = g_tx.len - g_tx.off;
-        if (chunk > 1200) chunk = 1200;
-        if (chunk > wnd)  chunk = wnd;
-        err_t e = tcp_write(tpcb, g_tx.buf + g_tx.off, chunk, TCP_WRITE_FLAG_COPY);
-        if (e == ERR_MEM) break;
-        if (e != ERR_OK) { tcp_abort(tpcb); return true; }
-        g_tx.off += chunk;
+/* ---------- helpers: parâmetros (query ou corpo de formulário) ---------- */
+// Valor do parâmetro `key` em "a=1&b" (até '&' ou fim); "" se sem '='; NULL se ausente
+static const char *http_param_in(const char *s, const char *key) {
+    size_t kn = strlen(key);
+    while (s && *s) {
+        if (!strncmp(s, key, kn) && (s[kn] == '=' || s[kn] == '&' || !s[kn]))
+            return s[kn] == '=' ? s + kn + 1 : s + kn;
+        s = strchr(s, '&');
+        if (s) s++;
     }
-    tcp_output(tpcb);
-    return (g_tx.off >= g_tx.len);
+    return NULL;
 }
 
-static err_t http_sent_cb(void *arg, struct tcp_pcb *tpcb, u16_t len) {
-    (void)arg; (void)len;
-    if (http_send_chunk(tpcb)) {
-        tcp_sent(tpcb, NULL);
-        tcp_recv(tpcb, NULL);
-        tcp_close(tpcb);
-    }
-    return ERR_OK;
+static const char *http_param(const http_req_t *r, const char *key) {
+    const char *v = r->query ? http_param_in(r->target + r->query, key) : NULL;
+    if (!v && r->method == HTTP_POST) v = http_param_in(r->body, key);
+    return v;
 }
 
-/* ---------- helpers: parse color query ---------- */
-static bool parse_color_query(const char *req, stat_color_t *out_color, bool *has_color) {
+static void parse_color_query(const http_req_t *r, stat_color_t *out_color, bool *has_color) {
     *has_color = false;
-    if (!req) return false;
-    const char *q = strstr(req, "GET /stats.json");
-    if (!q) return true;
-    const char *p = strstr(q, "color=");
-    if (!p) return true;
-    p += 6;
-    if (!strncmp(p, "verde", 5))      { *out_color = STAT_COLOR_VERDE; *has_color = true; return true; }
-    if (!strncmp(p, "amarelo", 7))    { *out_color = STAT_COLOR_AMARELO; *has_color = true; return true; }
-    if (!strncmp(p, "vermelho", 8))   { *out_color = STAT_COLOR_VERMELHO; *has_color = true; return true; }
-    return true;
+    const char *p = http_param(r, "color");
+    if (!p) return;
+    if (!strncmp(p, "verde", 5))      { *out_color = STAT_COLOR_VERDE; *has_color = true; return; }
+    if (!strncmp(p, "amarelo", 7))    { *out_color = STAT_COLOR_AMARELO; *has_color = true; return; }
+    if (!strncmp(p, "vermelho", 8))   { *out_color = STAT_COLOR_VERMELHO; *has_color = true; return; }
 }
 
-/* ---------- HTML: Painel Profissional (/) ---------- */
-static void make_html_pro(char *out, size_t outsz) {
-    const char *body =
-        "<!doctype html><html lang=pt-br><head><meta charset=utf-8>"
-        "<meta name=viewport content='width=device-width,initial-scale=1'>"
-        "<title>TheraLink — Profissional</title>"
-        "<style>"
-        "body{font-family:system-ui,-apple-system,Segoe UI,Roboto,Arial,sans-serif;margin:16px;background:#f4f6fb;color:#0e1320}"
-        "nav{display:flex;gap:12px;margin-bottom:12px;flex-wrap:wrap}"
-        "nav a{padding:8px 12px;border:1px solid #e2e6ef;background:#fff;border-radius:12px;text-decoration:none;color:#0e1320}"
-        ".chips{display:flex;gap:8px;flex-wrap:wrap;margin:6px 0 10px}"
-        ".chip{display:inline-flex;align-items:center;gap:8px;padding:8px 12px;border:1px solid #e2e6ef;border-radius:999px;background:#fff;cursor:pointer;user-select:none}"
-        ".chip .dot{width:10px;height:10px;border-radius:999px;display:inline-block}"
-        ".chip[data-c='all'] .dot{background:linear-gradient(90deg,#12b886,#fab005,#fa5252)}"
-        ".chip[data-c='verde'] .dot{background:#12b886}.chip[data-c='amarelo'] .dot{background:#fab005}.chip[data-c='vermelho'] .dot{background:#fa5252}"
-        ".chip.active{box-shadow:0 0 0 2px rgba(17,17,17,.08);border-color:#c9cfda}"
-        ".hint{font-size:12px;color:#5f6b86}"
-        ".grid{display:grid;grid-template-columns:1fr;gap:12px}"
-        "@media(min-width:980px){.grid{grid-template-columns:1.1fr .9fr}}"
-        ".card{border:1px solid #e6e9f2;border-radius:16px;padding:14px;background:#fff;box-shadow:0 6px 24px rgba(0,0,0,.05)}"
-        ".title{margin:0 0 8px;font-size:18px;font-weight:700}"
-        ".row{display:flex;gap:12px;align-items:flex-start;flex-wrap:wrap}"
-        ".kpi{border:1px solid #edf0f7;padding:12px;border-radius:14px;background:#fbfcff;min-width:170px}"
-        ".kpi .l{font-size:12px;color:#6a7490}.kpi .v{font-size:30px;font-weight:800;margin-top:2px}"
-        ".kpi .s{font-size:12px;color:#6a7490;margin-top:4px;font-weight:600}"
-        ".pill{display:inline-flex;gap:8px;align-items:center;padding:6px 10px;border:1px solid #e6e9f2;border-radius:999px;background:#fff;font-size:12px}"
-        "canvas{width:100%;height:240px;background:#fafbff;border:1px solid #eef1f7;border-radius:12px}"
-        ".lst{display:grid;grid-template-columns:repeat(10,1fr);gap:6px;margin-top:8px}"
-        ".dot{display:flex;align-items:center;justify-content:center;height:28px;border:1px solid #e6e9f2;border-radius:8px;background:#fff;font-weight:800}"
-        "</style></head><body>"
-        "<nav><a href='/'>Profissional</a><a href='/display'>Display</a><a href='/download.csv'>Baixar CSV</a></nav>"
-        "<h1 style='font-size:20px;margin:6px 0 8px'>Painel — Profissional</h1>"
-        "<div class='chips' id='chips'>"
-          "<div class='chip active' data-c='all'><span class='dot'></span><span>Todos</span></div>"
-          "<div class='chip' data-c='verde'><span class='dot'></span><span>Grupo Verde</span></div>"
-          "<div class='chip' data-c='amarelo'><span class='dot'></span><span>Grupo Amarelo</span></div>"
-          "<div class='chip' data-c='vermelho'><span class='dot'></span><span>Grupo Vermelho</span></div>"
-        "</div>"
-        "<div class='hint'>Filtre por grupo para analisar BPM e distribuição por pulseira.</div>"
-        "<div class=grid>"
-          "<div class=card>"
-            "<div class=title>Ritmo (BPM) e check-ins</div>"
-            "<div class=row>"
-              "<div class=kpi><div class=l>BPM m&eacute;dio</div><div id=kpiBpm class=v>--</div><div class=s id=kpiBpmLast>&Uacute;ltimo: --</div></div>"
-              "<div class=kpi><div class=l>Varia&ccedil;&atilde;o de BPM</div><div id=kpiBpmStd class=v>--</div><div class=s>Desvio padr&atilde;o</div></div>"
-              "<div class=kpi><div class=l>Check-ins registrados</div><div id=kpiN class=v>0</div><div class=s id=kpiEngagement>Engajamento: --</div></div>"
-              "<div class=kpi><div class=l>Sim por pessoa</div><div id=kpiAvgYes class=v>--</div><div class=s id=kpiSurveyCount>Respostas: 0</div></div>"
-            "</div>"
-            "<canvas id=chartBpm></canvas>"
-          "</div>"
-          "<div class=card>"
-            "<div class=title>Bem-estar e clima emocional</div>"
-            "<div class=row>"
-              "<div class=kpi><div class=l>&Iacute;ndice de bem-estar</div><div id=kpiWellness class=v>--</div><div class=s>0 a 100%</div></div>"
-              "<div class=kpi><div class=l>Calmaria emocional</div><div id=kpiCalm class=v>--</div><div class=s>0 a 100%</div></div>"
-            "</div>"
-          "</div>"
-          "<div class=card>"
-            "<div class=title>Distribui&ccedil;&atilde;o por cor</div>"
-            "<canvas id=chartCores></canvas>"
-            "<div class='hint' id=fltDesc>Todos os grupos</div>"
-          "</div>"
-          "<div class=card>"
-            "<div class=title>Alertas</div>"
-            "<div class=row>"
-              "<span class=pill>Crise agora: <b id=alCrisis>0</b></span>"
-              "<span class=pill>Evita grupo: <b id=alAvoid>0</b></span>"
-              "<span class=pill>Quer falar: <b id=alTalk>0</b></span>"
-            "</div>"
-          "</div>"
-          "<div class=card>"
-            "<div class=title>Necessidades b&aacute;sicas</div>"
-            "<div class=row>"
-              "<div class=kpi><div class=l>Sem refei&ccedil;&atilde;o recente</div><div id=basicMeal class=v>--</div></div>"
-              "<div class=kpi><div class=l>Sem sono adequado</div><div id=basicSleep class=v>--</div></div>"
-            "</div>"
-          "</div>"
-          "<div class=card style='grid-column:1 / -1'>"
-            "<div class=title>Question&aacute;rio — contagem de <b>Sim</b> por pergunta</div>"
-            "<canvas id=chartQs></canvas>"
-            "<div class='title' style='font-size:16px;margin-top:10px'>&Uacute;ltima resposta</div>"
-            "<div class=lst id=lastList></div>"
-          "</div>"
-        "</div>"
-        "<script>"
-        "let hist=[];const maxPts=180;let flt='all';"
-        "const Cb=document.getElementById('chartBpm').getContext('2d');"
-        "const Cc=document.getElementById('chartCores').getContext('2d');"
-        "const Cq=document.getElementById('chartQs').getContext('2d');"
-        "function drawLine(ctx,arr){const w=ctx.canvas.clientWidth,h=ctx.canvas.clientHeight;ctx.canvas.width=w;ctx.canvas.height=h;"
-          "ctx.clearRect(0,0,w,h);if(arr.length<2)return;let mn=200,mx=40;for(const v of arr){if(v>0){mn=Math.min(mn,v);mx=Math.max(mx,v);}}"
-          "if(!isFinite(mn)||!isFinite(mx))return;if(mx-mn<5){mn=Math.max(20,mn-3);mx=mn+5;}ctx.beginPath();"
-          "for(let i=0;i<arr.length;i++){const v=arr[i];if(v<=0)continue;const x=i*(w-8)/(arr.length-1)+4;const y=h-4-(v-mn)/(mx-mn)*(h-8);i?ctx.lineTo(x,y):ctx.moveTo(x,y);}ctx.stroke();}"
-        "function drawBars(ctx,data,labels){const w=ctx.canvas.clientWidth,h=ctx.canvas.clientHeight;ctx.canvas.width=w;ctx.canvas.height=h;"
-          "ctx.clearRect(0,0,w,h);const n=data.length;const bw=Math.min(60,(w-40)/n);const gap=(w-n*bw)/(n+1);let x=gap;const M=Math.max(...data,1);"
-          "ctx.font='12px system-ui';for(let i=0;i<n;i++){const v=data[i];const y=h-22;const bh=(v/M)*(h-50);ctx.fillRect(x,y-bh,bw,bh);ctx.fillText(labels[i],x,y+14);ctx.fillText(String(v.toFixed?Math.round(v):v),x+bw/2-8,y-bh-6);x+=bw+gap;}}"
-        "function lastDots(bits){const el=document.getElementById('lastList');el.innerHTML='';for(let i=0;i<10;i++){const on=((bits>>i)&1)!==0;const d=document.createElement('div');d.className='dot';d.textContent=on?'●':'○';el.appendChild(d);}}"
-        "function sel(c){flt=c;document.querySelectorAll('.chip').forEach(el=>el.classList.toggle('active',el.dataset.c===c));hist=[];tick();}"
-        "document.getElementById('chips').addEventListener('click',e=>{const el=e.target.closest('.chip');if(!el)return;sel(el.dataset.c)});"
-        "function fltLabel(){if(flt==='verde')return 'Apenas Grupo Verde';if(flt==='amarelo')return 'Apenas Grupo Amarelo';if(flt==='vermelho')return 'Apenas Grupo Vermelho';return 'Todos os grupos';}"
-        "function isFiniteNum(v){return typeof v==='number'&&Number.isFinite(v);}"
-        "async function tick(){try{let url='/stats.json?t='+Date.now();if(flt!=='all'){url+='&color='+flt;}const r=await fetch(url,{cache:'no-store'});const s=await r.json();"
-            "document.getElementById('fltDesc').textContent=fltLabel();"
-            "const live=(isFiniteNum(s.bpm_live)&&s.bpm_live>=20&&s.bpm_live<=250)?s.bpm_live:0;"
-            "const last=isFiniteNum(s.bpm_last)?s.bpm_last:0;const mean=isFiniteNum(s.bpm_mean)?s.bpm_mean:0;"
-            "let headline=0;if(live)headline=live;else if(last)headline=last;else if(mean)headline=mean;"
-            "document.getElementById('kpiBpm').textContent=headline?headline.toFixed(1):'--';"
-            "document.getElementById('kpiBpmLast').textContent=last?('Último: '+Math.round(last)+' bpm'):'Último: --';"
-            "const bpmStd=isFiniteNum(s.bpm_stddev)?s.bpm_stddev:NaN;document.getElementById('kpiBpmStd').textContent=isFiniteNum(bpmStd)?(bpmStd.toFixed(1)+' bpm'):'--';"
-            "const engagement=isFiniteNum(s.engagement_rate)?s.engagement_rate:NaN;"
-            "const wellness=isFiniteNum(s.wellbeing_index)?s.wellbeing_index:NaN;document.getElementById('kpiWellness').textContent=isFiniteNum(wellness)?Math.round(wellness)+'%':'--';"
-            "const calm=isFiniteNum(s.calm_index)?s.calm_index:NaN;document.getElementById('kpiCalm').textContent=isFiniteNum(calm)?Math.round(calm)+'%':'--';"
-            "const checkins=isFiniteNum(s.checkins_total)?s.checkins_total:0;"
-            "const plotted=headline;if(plotted){hist.push(plotted);if(hist.length>maxPts)hist.shift();}drawLine(Cb,hist);"
-            "drawBars(Cc,[s.cores.verde||0,s.cores.amarelo||0,s.cores.vermelho||0],['Verde','Amarelo','Vermelho']);"
-            "const sv=s.survey||{};const n=sv.n||0;const rate=sv.rate||[];const avg=sv.avg_yes||0;"
-            "document.getElementById('kpiN').textContent=String(checkins);document.getElementById('kpiAvgYes').textContent=n?((Math.round(avg*100)/100).toFixed(2)):'--';document.getElementById('kpiSurveyCount').textContent='Respostas: '+n;"
-            "let engageText='Engajamento: --';"
-            "if(checkins>0&&isFiniteNum(engagement)){const pct=Math.round(engagement*100);const answered=Math.min(n,checkins);engageText='Engajamento: '+answered+'/'+checkins+' ('+pct+'%)';}"
-            "else if(checkins>0){engageText='Engajamento: 0/'+checkins+' (0%)';}"
-            "document.getElementById('kpiEngagement').textContent=engageText;"
-            "document.getElementById('alCrisis').textContent=String(sv.alerts?sv.alerts.crisis||0:0);"
-            "document.getElementById('alAvoid').textContent=String(sv.alerts?sv.alerts.avoid||0:0);"
-            "document.getElementById('alTalk').textContent=String(sv.alerts?sv.alerts.talk||0:0);"
-            "document.getElementById('basicMeal').textContent=String(sv.basic?sv.basic.no_meal||0:0);"
-            "document.getElementById('basicSleep').textContent=String(sv.basic?sv.basic.poor_sleep||0:0);"
-            "const perc=(rate||[]).map(v=>v*100);drawBars(Cq,perc,['Q1','Q2','Q3','Q4','Q5','Q6','Q7','Q8','Q9','Q10']);"
-            "lastDots(sv.last_bits||0);"
-          "}catch(e){}}"
-        "setInterval(tick,1000); tick();"
-        "</script></body></html>";
-
-    snprintf(out, outsz,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/html; charset=UTF-8\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n%s", body);
-}
-
-/* ---------- HTML: Display (espelho + auto jump para /survey) ---------- */
-static void make_html_display(char *out, size_t outsz) {
-    const char *body =
-        "<!doctype html><html lang=pt-br><head><meta charset=utf-8>"
-        "<meta name=viewport content='width=device-width,initial-scale=1'>"
-        "<title>TheraLink — Display</title>"
-        "<style>"
-        "html,body{height:100%;margin:0}"
-        "body{font-family:system-ui,-apple-system,Segoe UI,Roboto,Arial,sans-serif;background:radial-gradient(60% 80% at 50% 10%,#171a20,#0e1014);color:#f2f4f8;display:flex;align-items:center;justify-content:center}"
-        ".panel{width:min(960px,94vw);padding:24px 22px;border-radius:20px;background:linear-gradient(180deg,#141821,#101218);box-shadow:0 12px 40px rgba(0,0,0,.45),inset 0 1px rgba(255,255,255,.05)}"
-        ".hdr{display:flex;justify-content:space-between;align-items:center;margin-bottom:8px;opacity:.9}.hdr .brand{font-weight:700;letter-spacing:.3px}"
-        ".btn{font-size:12px;padding:6px 10px;border-radius:10px;border:1px solid #303440;background:#1a1f2b;color:#f2f4f8}"
-        ".lines{display:grid;gap:6px;margin-top:8px}"
-        ".line{min-height:1lh;font-weight:800;letter-spacing:.5px;text-shadow:0 2px 10px rgba(0,0,0,.25);padding:2px 4px;border-radius:8px}"
-        "#l1{font-size:clamp(20px,6.2vh,36px)}#l2,#l3,#l4{font-size:clamp(22px,7.2vh,44px)}"
-        ".fade{animation:fade .22s ease}@keyframes fade{from{opacity:.45;transform:translateY(1px)}to{opacity:1;transform:none}}"
-        ".tag{font-weight:900}.tag.green{color:#12b886}.tag.yellow{color:#fab005}.tag.red{color:#fa5252}"
-        "</style></head><body>"
-        "<div class=panel><div class=hdr><div class=brand>TheraLink — Display</div><button class=btn onclick='fs()'>Tela cheia</button></div>"
-        "<div class=lines><div id=l1 class='line'>&nbsp;</div><div id=l2 class='line'>&nbsp;</div><div id=l3 class='line'>&nbsp;</div><div id=l4 class='line'>&nbsp;</div></div></div>"
-        "<script>"
-        "function fs(){const d=document.documentElement; if(d.requestFullscreen) d.requestFullscreen();}"
-        "let last=['','','',''];let jumped=false;"
-        "function esc(t){return (t||'').replace(/&/g,'&amp;').replace(/</g,'&lt;').replace(/>/g,'&gt;');}"
-        "function colorize(t){let x=esc(t||'');x=x.replace(/\\b(verde|amarelo|amarela|vermelho|vermelha)\\b/gi,m=>{const k=m.toLowerCase();if(k==='verde')return'<span class=\"tag green\">'+m+'</span>';if(k==='amarelo'||k==='amarela')return'<span class=\"tag yellow\">'+m+'</span>';if(k==='vermelho'||k==='vermelha')return'<span class=\"tag red\">'+m+'</span>';return m;});return x;}"
-        "async function tick(){try{const st=await fetch('/survey_state.json?t='+Date.now(),{cache:'no-store'}).then(r=>r.json()).catch(()=>({mode:0}));"
-          "if(!jumped&&st.mode){jumped=true;location.replace('/survey?t='+Date.now());return;}"
-          "const s=await fetch('/oled.json?t='+Date.now(),{cache:'no-store'}).then(r=>r.json());const arr=[s.l1||'',s.l2||'',s.l3||'',s.l4||''];"
-          "for(let i=0;i<4;i++){if(arr[i]!==last[i]){last[i]=arr[i];const el=document.getElementById('l'+(i+1));el.classList.remove('fade');el.innerHTML=colorize(arr[i])||'&nbsp;';void el.offsetWidth;el.classList.add('fade');}}"
-        "}catch(e){}}setInterval(tick,500);tick();"
-        "</script></body></html>";
-
-    snprintf(out, outsz,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/html; charset=UTF-8\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n%s", body);
-}
-
-/* ---------- HTML: Survey ---------- */
-static void make_html_survey(char *out, size_t outsz) {
-    const char *body_prefix =
-        "<!doctype html><html lang=pt-br><head><meta charset=utf-8>"
-        "<meta name=viewport content='width=device-width,initial-scale=1'>"
-        "<title>TheraLink — Survey</title>"
-        "<style>"
-        "body{font-family:system-ui,-apple-system,Segoe UI,Roboto,Arial,sans-serif;margin:18px;background:#0f1220;color:#eef1f6}"
-        ".wrap{max-width:920px;margin:0 auto}h1{font-size:22px;margin:0 0 12px}"
-        ".card{background:#13172a;border:1px solid #252b45;border-radius:14px;padding:16px;margin:12px 0}"
-        ".q{display:flex;justify-content:space-between;align-items:center;padding:12px 10px;border-bottom:1px solid #1e2440}.q:last-child{border-bottom:none}"
-        ".lbl{max-width:74%;line-height:1.35}.btns{display:flex;gap:8px}"
-        ".chip{padding:10px 12px;border-radius:12px;border:1px solid #2b3358;background:#0f1428;color:#eef1f6;cursor:pointer;user-select:none}"
-        ".chip.sel{outline:2px solid #2d6cdf}.row{display:flex;gap:10px;flex-wrap:wrap}.primary{background:#2d6cdf;border-color:#2d6cdf}"
-        "a{color:#cfe1ff;text-decoration:none}.muted{opacity:.8}"
-        "</style></head><body><div class=wrap><h1>Question&aacute;rio r&aacute;pido (10 perguntas)</h1>";
-
-    const char *body_main =
-        "<div id=content class=card>"
-        "<div class=q><div class=lbl>Dormiu bem nas &uacute;ltimas 24h?</div><div class=btns><span class=chip data-i='0' data-v='1'>Sim</span><span class=chip data-i='0' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Teve conflito forte com algu&eacute;m?</div><div class=btns><span class=chip data-i='1' data-v='1'>Sim</span><span class=chip data-i='1' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Se sentiu muito nervoso(a) hoje?</div><div class=btns><span class=chip data-i='2' data-v='1'>Sim</span><span class=chip data-i='2' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Teve dificuldade de concentrar?</div><div class=btns><span class=chip data-i='3' data-v='1'>Sim</span><span class=chip data-i='3' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Sente risco de crise agora?</div><div class=btns><span class=chip data-i='4' data-v='1'>Sim</span><span class=chip data-i='4' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Est&aacute; evitando estar com o grupo hoje?</div><div class=btns><span class=chip data-i='5' data-v='1'>Sim</span><span class=chip data-i='5' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Quer falar com um adulto ap&oacute;s o check-in?</div><div class=btns><span class=chip data-i='6' data-v='1'>Sim</span><span class=chip data-i='6' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Comeu e se hidratou adequadamente?</div><div class=btns><span class=chip data-i='7' data-v='1'>Sim</span><span class=chip data-i='7' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Sente dor f&iacute;sica relevante agora?</div><div class=btns><span class=chip data-i='8' data-v='1'>Sim</span><span class=chip data-i='8' data-v='0'>N&atilde;o</span></div></div>"
-        "<div class=q><div class=lbl>Se sente seguro(a) neste ambiente?</div><div class=btns><span class=chip data-i='9' data-v='1'>Sim</span><span class=chip data-i='9' data-v='0'>N&atilde;o</span></div></div>"
-        "</div>"
-        "<div class=row><button id=send class='chip primary'>Enviar respostas</button><a class=chip href='/display' id=back>Voltar ao display</a></div>"
-        "<p class=muted style='margin-top:8px'>As respostas s&atilde;o locais e an&ocirc;nimas.</p>"
-        "<script>"
-        "const sel=new Array(10).fill(-1);"
-        "document.querySelectorAll('.chip[data-i]').forEach(b=>{b.addEventListener('click',()=>{const i=Number(b.dataset.i),v=Number(b.dataset.v);sel[i]=v;const sib=b.parentElement.querySelectorAll('.chip');sib.forEach(x=>x.classList.remove('sel'));b.classList.add('sel');});});"
-        "document.getElementById('back').addEventListener('click',e=>{e.preventDefault();location.replace('/display?t='+Date.now());});"
-        "document.getElementById('send').addEventListener('click',()=>{if(sel.some(v=>v<0)){alert('Responda todas as perguntas.');return;}const bits=sel.map(v=>v?1:0).join('');location.replace('/survey_submit?ans='+bits+'&t='+Date.now());});"
-        "</script>";
-
-    const char *body_closed =
-        "<div class=card><p>Question&aacute;rio encerrado.</p><p><a class=chip href='/display'>Voltar ao display</a></p></div>";
-
-    const char *end = "</div></body></html>";
-
-    if (s_survey_mode) {
-        snprintf(out, outsz,
-            "HTTP/1.1 200 OK\r\n"
-            "Content-Type: text/html; charset=UTF-8\r\n"
-            "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-            "Connection: close\r\n\r\n%s%s%s", body_prefix, body_main, end);
-    } else {
-        snprintf(out, outsz,
-            "HTTP/1.1 200 OK\r\n"
-            "Content-Type: text/html; charset=UTF-8\r\n"
-            "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-            "Connection: close\r\n\r\n%s%s%s", body_prefix, body_closed, end);
-    }
+/* HTTP/1.1: persistente salvo "Connection: close"; HTTP/1.0: só com keep-alive */
+static bool http_wants_keep_alive(const http_req_t *r) {
+    if (r->flags & HQ_CLOSE) return false;
+    return (r->flags & HQ_HTTP10) ? (r->flags & HQ_KEEP) != 0 : true;
 }
 
-/* ---------- JSON: stats (/stats.json[?color=...]) ---------- */
-static void make_json_stats(char *out, size_t outsz, const char *req_line) {
-    stats_snapshot_t s;
-    stat_color_t col = STAT_COLOR_VERDE; bool has = false;
-    parse_color_query(req_line, &col, &has);
-
-    if (has) stats_get_snapshot_by_color(col, &s);
-    else     stats_get_snapshot(&s);
-
-    float bpm_mean = isnan(s.bpm_mean_trimmed) ? 0.f : s.bpm_mean_trimmed;
-    const float bpm_live = 0.f;
+/* ---------- Respostas ----------
+   O cabeçalho termina no último campo (sem "Connection" nem linha em branco);
+   o fim é escolhido por conexão: HTTP_TAIL_KEEP ou HTTP_TAIL_CLOSE. Estáticas
+   ficam em .rodata (XIP) e vão sem TCP_WRITE_FLAG_COPY. */
+typedef struct { const char *hdr; u16_t hdr_len; const char *body; u16_t body_len; } http_resp_t;
+#define HTTP_RESP(h, b) { (h), (u16_t)(sizeof(h) - 1), (b), (u16_t)(sizeof(b) - 1) }
+
+#define HTTP_TAIL_KEEP  "\r\n"
+#define HTTP_TAIL_CLOSE "Connection: close\r\n\r\n"
+
+#define HTTP_NO_CACHE "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
+
+#define HTTP_HDR_JSON \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: application/json; charset=UTF-8\r\n" \
+    HTTP_NO_CACHE
+
+/* ---------- Páginas HTML (pasta web/ -> web_assets.c, gerado no build) ----------
+   Cada página existe em duas versões na flash: crua e gzip. Se o navegador já
+   tem a versão atual (If-None-Match com o ETag), vai só o 304. */
+static http_resp_t web_asset_pick(const web_asset_t *a, const http_req_t *r) {
+    bool fresh = r->etag[0] && (!strcmp(r->etag, "*") || http_value_has(r->etag, a->etag));
+    const web_resp_t *w = fresh ? &a->not_modified : (r->flags & HQ_GZIP) ? &a->gz : &a->raw;
+    http_resp_t out = { w->hdr, w->hdr_len, (const char *)w->body, w->body_len };
+    return out;
+}
 
-    /* ====== Survey agregado (respeita o filtro por cor) ====== */
+/* ====== Survey agregado (respeita o filtro por cor) ====== */
+typedef struct {
     uint32_t n;
     uint32_t yes[10];
     uint16_t last_bits;
+} survey_view_t;
+
+static void survey_view(stat_color_t col, bool has, survey_view_t *v) {
     if (has && (unsigned)col < STAT_COLOR_COUNT) {
-        n = s_svy_n_c[col];
-        for (int i = 0; i < 10; i++) yes[i] = s_svy_yes_c[col][i];
-        last_bits = s_svy_last_bits_c[col];
+        v->n = s_svy_n_c[col];
+        for (int i = 0; i < 10; i++) v->yes[i] = s_svy_yes_c[col][i];
+        v->last_bits = s_svy_last_bits_c[col];
     } else {
-        n = s_svy_n;
-        for (int i = 0; i < 10; i++) yes[i] = s_svy_yes[i];
-        last_bits = s_svy_last_bits;
+        v->n = s_svy_n;
+        for (int i = 0; i < 10; i++) v->yes[i] = s_svy_yes[i];
+        v->last_bits = s_svy_last_bits;
     }
+}
 
-    float rate[10]; uint32_t sum_yes = 0;
-    for (int i = 0; i < 10; i++) { rate[i] = n ? (float)yes[i] / (float)n : 0.f; sum_yes += yes[i]; }
-    float avg_yes = n ? (float)sum_yes / (float)n : 0.f;
+static float survey_engagement(uint32_t n, uint32_t checkins) {
+    if (!checkins) return NAN;
+    float e = (float)n / (float)checkins;
+    return e > 1.f ? 1.f : e;
+}
 
-    float engagement = NAN;
-    if (s.checkins_total > 0) {
-        engagement = (float)n / (float)s.checkins_total;
-        if (engagement > 1.f) engagement = 1.f;
-    }
+/* ---------- JSON: stats (/stats.json[?color=...]) ----------
+   Emissor retomável: o snapshot é tirado uma vez (stats_json_begin) e cada
+   chamada de stats_json_field() escreve só o campo `step`, sem avançar. Se o
+   campo não coube, a próxima chamada gera o mesmo texto; assim o HTTP enche a
+   janela de envio campo a campo, sem montar o corpo inteiro na RAM. */
+#define STATS_JSON_FIELD_MAX 160   // maior campo (vetor "yes": 10 x u32), com folga
+
+typedef struct {
+    stats_snapshot_t s;
+    survey_view_t    sv;
+    float            bpm_live;
+} stats_json_t;
+
+static void stats_json_begin(stats_json_t *j, stat_color_t col, bool has) {
+    if (has) stats_get_snapshot_by_color(col, &j->s);
+    else     stats_get_snapshot(&j->s);
+    survey_view(col, has, &j->sv);
+    j->bpm_live = oxi_get_bpm_live();
+}
+
+/* Escreve o campo `step` em out; devolve o tamanho (como snprintf: > outsz-1
+   = não coube) ou 0 quando o objeto já terminou. Números via fmt.h
+   (NaN -> null); o campo é montado em tmp e só copiado se couber. */
+static size_t stats_json_field(const stats_json_t *j, u16_t step, char *out, size_t outsz) {
+    const stats_snapshot_t *s = &j->s;
+    const uint32_t n = j->sv.n;
+    const uint32_t *yes = j->sv.yes;
 
     /* Mapa coerente com a ordem atual do /survey (ver HTML):
        idx 0 Dormiu bem?            (Sim=OK)        -> basic_sleep usa !yes[0]
@@ -461,63 +328,163 @@ static void make_json_stats(char *out, size_t outsz, const char *req_line) {
        idx 8 Dor física relevante   (Sim=alerta?)
        idx 9 Sente-se seguro        (Sim=OK)
     */
-    uint32_t al_crisis   = yes[4];
-    uint32_t al_avoid    = yes[5];
-    uint32_t al_talk     = yes[6];
-    uint32_t basic_meal  = (n >= yes[7] ? n - yes[7] : 0); // não comeu/hidratou
-    uint32_t basic_sleep = (n >= yes[0] ? n - yes[0] : 0); // não dormiu bem
-
-    /* ----- monta JSON ----- */
-    char body[6000]; size_t off = 0;
-    #define APPEND(...) off += (size_t)snprintf(body + off, sizeof(body) - off, __VA_ARGS__)
-    APPEND("{");
-      APPEND("\"bpm_live\":%.3f,", bpm_live);
-      APPEND("\"bpm_mean\":%.3f,\"bpm_n\":%lu,", bpm_mean, (unsigned long)s.bpm_count);
-      if (isnan(s.bpm_last)) APPEND("\"bpm_last\":null,"); else APPEND("\"bpm_last\":%.3f,", s.bpm_last);
-      if (isnan(s.bpm_stddev)) APPEND("\"bpm_stddev\":null,"); else APPEND("\"bpm_stddev\":%.3f,", s.bpm_stddev);
-      if (isnan(s.wellbeing_index)) APPEND("\"wellbeing_index\":null,"); else APPEND("\"wellbeing_index\":%.3f,", s.wellbeing_index);
-      if (isnan(s.calm_index)) APPEND("\"calm_index\":null,"); else APPEND("\"calm_index\":%.3f,", s.calm_index);
-      if (isnan(engagement)) APPEND("\"engagement_rate\":null,"); else APPEND("\"engagement_rate\":%.4f,", engagement);
-      APPEND("\"checkins_total\":%lu,", (unsigned long)s.checkins_total);
-      APPEND("\"cores\":{\"verde\":%lu,\"amarelo\":%lu,\"vermelho\":%lu},",
-             (unsigned long)s.cor_verde, (unsigned long)s.cor_amarelo, (unsigned long)s.cor_vermelho);
-      APPEND("\"survey\":{");
-        APPEND("\"n\":%lu,", (unsigned long)n);
-        APPEND("\"yes\":["); for (int i = 0; i < 10; i++) { APPEND("%lu", (unsigned long)yes[i]); if (i < 9) APPEND(","); } APPEND("],");
-        APPEND("\"rate\":["); for (int i = 0; i < 10; i++) { APPEND("%.4f", rate[i]); if (i < 9) APPEND(","); } APPEND("],");
-        APPEND("\"avg_yes\":%.3f,", avg_yes);
-        APPEND("\"last_bits\":%u,", (unsigned)last_bits);
-        APPEND("\"alerts\":{\"crisis\":%lu,\"avoid\":%lu,\"talk\":%lu},",
-               (unsigned long)al_crisis, (unsigned long)al_avoid, (unsigned long)al_talk);
-        APPEND("\"basic\":{\"no_meal\":%lu,\"poor_sleep\":%lu}", (unsigned long)basic_meal, (unsigned long)basic_sleep);
-      APPEND("}");
-    APPEND("}");
-    #undef APPEND
-
-    snprintf(out, outsz,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: application/json; charset=UTF-8\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n%s", body);
+    char tmp[STATS_JSON_FIELD_MAX];
+    char *p = tmp;
+    switch (step) {
+    case 0:  p = fmt_str(p, "{\"bpm_live\":");      p = fmt_fixed(p, j->bpm_live, 3); break;
+    case 1:  p = fmt_str(p, "\"bpm_mean\":");
+             p = fmt_fixed(p, isnan(s->bpm_mean_trimmed) ? 0.f : s->bpm_mean_trimmed, 3);
+             p = fmt_str(p, ",\"bpm_n\":");          p = fmt_u32(p, s->bpm_count); break;
+    case 2:  p = fmt_str(p, "\"bpm_last\":");        p = fmt_fixed(p, s->bpm_last, 3); break;
+    case 3:  p = fmt_str(p, "\"bpm_stddev\":");      p = fmt_fixed(p, s->bpm_stddev, 3); break;
+    case 4:  p = fmt_str(p, "\"wellbeing_index\":"); p = fmt_fixed(p, s->wellbeing_index, 3); break;
+    case 5:  p = fmt_str(p, "\"calm_index\":");      p = fmt_fixed(p, s->calm_index, 3); break;
+    case 6:  p = fmt_str(p, "\"engagement_rate\":");
+             p = fmt_fixed(p, survey_engagement(n, s->checkins_total), 4); break;
+    case 7:  p = fmt_str(p, "\"checkins_total\":");  p = fmt_u32(p, s->checkins_total); break;
+    case 8:  p = fmt_str(p, "\"cores\":{\"verde\":"); p = fmt_u32(p, s->cor_verde);
+             p = fmt_str(p, ",\"amarelo\":");        p = fmt_u32(p, s->cor_amarelo);
+             p = fmt_str(p, ",\"vermelho\":");       p = fmt_u32(p, s->cor_vermelho);
+             p = fmt_str(p, "}"); break;
+    case 9:  p = fmt_str(p, "\"survey\":{\"n\":");   p = fmt_u32(p, n); break;
+    case 10:
+    case 11:
+        p = fmt_str(p, step == 10 ? "\"yes\":[" : "\"rate\":[");
+        for (int i = 0; i < 10; i++) {
+            if (i) *p++ = ',';
+            if (step == 10) p = fmt_u32(p, yes[i]);
+            else               p = fmt_fixed(p, n ? (float)yes[i] / (float)n : 0.f, 4);
+        }
+        p = fmt_str(p, "]");
+        break;
+    case 12: {
+        uint32_t sum_yes = 0;
+        for (int i = 0; i < 10; i++) sum_yes += yes[i];
+        p = fmt_str(p, "\"avg_yes\":");   p = fmt_fixed(p, n ? (float)sum_yes / (float)n : 0.f, 3);
+        p = fmt_str(p, ",\"last_bits\":"); p = fmt_u32(p, j->sv.last_bits);
+        break;
+    }
+    case 13: p = fmt_str(p, "\"alerts\":{\"crisis\":"); p = fmt_u32(p, yes[4]);
+             p = fmt_str(p, ",\"avoid\":");  p = fmt_u32(p, yes[5]);
+             p = fmt_str(p, ",\"talk\":");   p = fmt_u32(p, yes[6]);
+             p = fmt_str(p, "}"); break;
+    case 14: p = fmt_str(p, "\"basic\":{\"no_meal\":");
+             p = fmt_u32(p, n >= yes[7] ? n - yes[7] : 0);      // não comeu/hidratou
+             p = fmt_str(p, ",\"poor_sleep\":");
+             p = fmt_u32(p, n >= yes[0] ? n - yes[0] : 0);      // não dormiu bem
+             p = fmt_str(p, "}}}"); break;
+    default: return 0;
+    }
+    if (step < 14) *p++ = ',';
+
+    size_t k = (size_t)(p - tmp);
+    if (k < outsz) { memcpy(out, tmp, k); out[k] = 0; }
+    return k;
 }
 
-/* ---------- JSON: survey_state (/survey_state.json) ---------- */
-static void make_json_survey_state(char *out, size_t outsz) {
-    snprintf(out, outsz,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: application/json; charset=UTF-8\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n"
-        "{\"mode\":%d}", s_survey_mode ? 1 : 0);
+/* Corpo inteiro num buffer (eventos SSE) */
+static size_t make_json_stats(char *out, size_t outsz, stat_color_t col, bool has) {
+    stats_json_t j;
+    stats_json_begin(&j, col, has);
+    size_t off = 0;
+    for (u16_t step = 0;; step++) {
+        size_t k = stats_json_field(&j, step, out + off, outsz - off);
+        if (!k || k >= outsz - off) break;
+        off += k;
+    }
+    out[off] = 0;
+    return off;
+}
+
+/* ---------- Binário: stats (/stats.bin[?color=...]) ----------
+   Layout fixo v1, little-endian, floats IEEE-754 (NaN = sem dado). Copiado
+   direto do snapshot, sem formatar número. Campos novos só no fim (e sobem
+   `size`); mudança incompatível sobe a versão. Decodificado em web/pro.js.
+     0 u8  versão (1)            1 u8  filtro de cor (255 = todas)
+     2 u16 tamanho total         4 u32 sample_id
+     8 f32 bpm_live             12 f32 bpm_mean (aparada)
+    16 u32 bpm_count            20 f32 bpm_last
+    24 f32 bpm_stddev           28 u32 cor verde / 32 amarelo / 36 vermelho
+    40 u32 checkins_total       44 f32 ans_mean      48 u32 ans_count
+    52 f32 energy_mean          56 u32 energy_count
+    60 f32 humor_mean           64 u32 humor_count
+    68 f32 wellbeing_index      72 f32 calm_index    76 f32 engagement_rate
+    80 u32 survey n             84 u32 yes[10]
+   124 u16 last_bits           126 u16 reservado (0) */
+#define STATS_BIN_VERSION 1
+#define STATS_BIN_SIZE    128
+
+static void bin_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void bin_u32(uint8_t *p, uint32_t v) { bin_u16(p, (uint16_t)v); bin_u16(p + 2, (uint16_t)(v >> 16)); }
+static void bin_f32(uint8_t *p, float f)    { uint32_t v; memcpy(&v, &f, 4); bin_u32(p, v); }
+
+static size_t make_bin_stats(uint8_t *out, size_t outsz, stat_color_t col, bool has) {
+    if (outsz < STATS_BIN_SIZE) return 0;
+    stats_snapshot_t s;
+    if (has) stats_get_snapshot_by_color(col, &s);
+    else     stats_get_snapshot(&s);
+    survey_view_t sv;
+    survey_view(col, has, &sv);
+
+    memset(out, 0, STATS_BIN_SIZE);
+    out[0] = STATS_BIN_VERSION;
+    out[1] = has ? (uint8_t)col : (uint8_t)STAT_COLOR_NONE;
+    bin_u16(out + 2,  STATS_BIN_SIZE);
+    bin_u32(out + 4,  s.sample_id);
+    bin_f32(out + 8,  oxi_get_bpm_live());
+    bin_f32(out + 12, s.bpm_mean_trimmed);
+    bin_u32(out + 16, s.bpm_count);
+    bin_f32(out + 20, s.bpm_last);
+    bin_f32(out + 24, s.bpm_stddev);
+    bin_u32(out + 28, s.cor_verde);
+    bin_u32(out + 32, s.cor_amarelo);
+    bin_u32(out + 36, s.cor_vermelho);
+    bin_u32(out + 40, s.checkins_total);
+    bin_f32(out + 44, s.ans_mean);
+    bin_u32(out + 48, s.ans_count);
+    bin_f32(out + 52, s.energy_mean);
+    bin_u32(out + 56, s.energy_count);
+    bin_f32(out + 60, s.humor_mean);
+    bin_u32(out + 64, s.humor_count);
+    bin_f32(out + 68, s.wellbeing_index);
+    bin_f32(out + 72, s.calm_index);
+    bin_f32(out + 76, survey_engagement(sv.n, s.checkins_total));
+    bin_u32(out + 80, sv.n);
+    for (int i = 0; i < 10; i++) bin_u32(out + 84 + 4 * i, sv.yes[i]);
+    bin_u16(out + 124, sv.last_bits);
+    return STATS_BIN_SIZE;
 }
 
+#define HTTP_HDR_METRICS \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n" \
+    HTTP_NO_CACHE
+
+#define HTTP_HDR_BIN \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: application/octet-stream\r\n" \
+    HTTP_NO_CACHE
+
+/* Cabeçalhos do /stats.json em streaming (corpo vem do stats_json) */
+static const char k_hdr_json_chunked[] = HTTP_HDR_JSON "Transfer-Encoding: chunked\r\n";
+static const char k_hdr_json_eof[]     = HTTP_HDR_JSON;
+static const http_resp_t k_resp_json_chunked = HTTP_RESP(k_hdr_json_chunked, "");
+static const http_resp_t k_resp_json_eof     = HTTP_RESP(k_hdr_json_eof, "");
+
+/* ---------- JSON: survey_state (/survey_state.json) ---------- */
+#define SURVEY_STATE_0 "{\"mode\":0}"
+#define SURVEY_STATE_1 "{\"mode\":1}"
+static const char k_hdr_survey_state[] = HTTP_HDR_JSON "Content-Length: 10\r\n";
+_Static_assert(sizeof(SURVEY_STATE_0) - 1 == 10 && sizeof(SURVEY_STATE_1) - 1 == 10,
+               "Content-Length de /survey_state.json");
+static const http_resp_t k_survey_state[2] = {
+    HTTP_RESP(k_hdr_survey_state, SURVEY_STATE_0),
+    HTTP_RESP(k_hdr_survey_state, SURVEY_STATE_1),
+};
+
 /* ---------- JSON: OLED (/oled.json) ---------- */
-static void make_json_oled(char *out, size_t outsz) {
-    snprintf(out, outsz,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: application/json; charset=UTF-8\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n"
+static size_t make_json_oled(char *out, size_t outsz) {
+    int n = snprintf(out, outsz,
         "{"
           "\"l1\":\"%s\","
           "\"l2\":\"%s\","
@@ -526,134 +493,1669 @@ static void make_json_oled(char *out, size_t outsz) {
         "}",
         g_oled.l1, g_oled.l2, g_oled.l3, g_oled.l4
     );
+    if (n < 0) return 0;
+    return (size_t)n < outsz ? (size_t)n : outsz - 1;
 }
 
-/* ---------- CSV (download.csv) ---------- */
-static void make_csv(char *out, size_t outsz) {
-    size_t hdr_len = snprintf(out, outsz,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/csv; charset=UTF-8\r\n"
-        "Content-Disposition: attachment; filename=\"theralink_dados.csv\"\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n");
-    if (hdr_len >= outsz) return;
+/* ---------- Binário: framebuffer do OLED (/fb.bin?v=N) ----------
+   O que foi de fato para o painel (web_display_set_fb), desenhado num
+   <canvas> em web/display.js. N = versão que o cliente já tem; igual à
+   atual -> 304 sem corpo. Little-endian:
+     0 u8  'F'    1 u8 'B'    2 u8 tipo: 0 quadro inteiro, 1 delta desde N
+     3 u8  páginas (8)        4 u16 largura (128)      6 u32 versão
+    10 ... tokens sobre os 1024 bytes, página a página, em ordem:
+           0x80|k  pula k+1 bytes (zero no quadro inteiro, inalterados no delta)
+           k       k+1 bytes literais em seguida (k <= 0x7F)
+   Pulo no fim do quadro fica implícito. Tela de texto inteira: ~300-500 B;
+   troca do BPM: algumas dezenas. */
+#define FB_HDR_SIZE 10
+#define FB_RUN_MAX  128
+#define FB_BIN_MAX  (FB_HDR_SIZE + FB_SIZE + FB_SIZE / FB_RUN_MAX)
+
+/* Byte i vai no quadro? Inteiro: se não é zero. Delta: se mudou há menos de
+   `age` versões (idade em 16 bits: vale enquanto ver - since < 65536). */
+static inline bool fb_send(size_t i, uint32_t ver, uint16_t age, bool delta) {
+    return delta ? (uint16_t)((uint16_t)ver - g_fb_ver[i]) < age : g_fb[i] != 0;
+}
 
-    size_t body_max = outsz - hdr_len;
-    size_t csv_len  = stats_dump_csv(out + hdr_len, body_max);
+static size_t make_bin_fb(uint8_t *out, size_t outsz, uint32_t ver, uint32_t since) {
+    if (outsz < FB_BIN_MAX) return 0;
+    bool delta = since != 0;
+    uint16_t age = (uint16_t)(ver - since);
+    out[0] = 'F'; out[1] = 'B';
+    out[2] = delta ? 1 : 0;
+    out[3] = FB_PAGES;
+    bin_u16(out + 4, FB_WIDTH);
+    bin_u32(out + 6, ver);
+    size_t o = FB_HDR_SIZE, i = 0;
+    while (i < FB_SIZE) {
+        size_t j = i;
+        while (j < FB_SIZE && !fb_send(j, ver, age, delta)) j++;
+        if (j == FB_SIZE) break;
+        while (i < j) {
+            size_t k = j - i < FB_RUN_MAX ? j - i : FB_RUN_MAX;
+            out[o++] = (uint8_t)(0x80 | (k - 1));
+            i += k;
+        }
+        while (j < FB_SIZE && j - i < FB_RUN_MAX && fb_send(j, ver, age, delta)) j++;
+        out[o++] = (uint8_t)(j - i - 1);
+        memcpy(out + o, g_fb + i, j - i);
+        o += j - i;
+        i = j;
+    }
+    return o;
+}
 
-    size_t total = hdr_len + csv_len;
-    if (total >= outsz) total = outsz - 1;
-    out[total] = '\0';
+static const char k_hdr_fb_304[] =
+    "HTTP/1.1 304 Not Modified\r\n"
+    HTTP_NO_CACHE;
+static const char k_hdr_fb_404[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    HTTP_NO_CACHE
+    "Content-Length: 0\r\n";
+static const http_resp_t k_resp_fb_304 = HTTP_RESP(k_hdr_fb_304, "");
+static const http_resp_t k_resp_fb_404 = HTTP_RESP(k_hdr_fb_404, "");
+
+/* ---------- CSV (download.csv) ---------- */
+#define HTTP_HDR_CSV \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: text/csv; charset=UTF-8\r\n" \
+    "Content-Disposition: attachment; filename=\"theralink_dados.csv\"\r\n" \
+    HTTP_NO_CACHE
+
+static size_t make_csv(char *out, size_t outsz) {
+    size_t csv_len = stats_dump_csv(out, outsz);
+    return csv_len < outsz ? csv_len : outsz - 1;
 }
 
 /* ---------- Redirect helper ---------- */
-static void make_redirect_display(char *out, size_t outsz) {
-    snprintf(out, outsz,
-        "HTTP/1.1 303 See Other\r\n"
-        "Location: /display\r\n"
-        "Cache-Control: no-store, max-age=0\r\nPragma: no-cache\r\nExpires: 0\r\n"
-        "Connection: close\r\n\r\n"
-        "<!doctype html><meta http-equiv='refresh' content='0;url=/display'>OK");
-}
-
-/* ---- Forward declarations de handlers usados no http_recv_cb ---- */
-static void make_json_stats(char *out, size_t outsz, const char *req_line);
-static void make_json_survey_state(char *out, size_t outsz);
-static void make_json_oled(char *out, size_t outsz);
-static void make_html_display(char *out, size_t outsz);
-static void make_html_survey(char *out, size_t outsz);
-static void make_html_pro(char *out, size_t outsz);
-static void make_csv(char *out, size_t outsz);
-static void make_redirect_display(char *out, size_t outsz);
-
-/* ---------- HTTP ---------- */
-static err_t http_recv_cb(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
-    (void)arg; (void)err;
-    if (!p) { tcp_close(tpcb); return ERR_OK; }
-
-    char req[256] = {0};
-    size_t n = p->tot_len < sizeof(req) - 1 ? p->tot_len : sizeof(req) - 1;
-    pbuf_copy_partial(p, req, n, 0);
-    tcp_recved(tpcb, p->tot_len);
-    pbuf_free(p);
-
-    bool want_stats        = (memcmp(req, "GET /stats.json",        15) == 0);
-    bool want_oled         = (memcmp(req, "GET /oled.json",         14) == 0);
-    bool want_display      = (memcmp(req, "GET /display",           12) == 0);
-    bool want_csv          = (memcmp(req, "GET /download.csv",      17) == 0);
-    bool want_survey       = (memcmp(req, "GET /survey",            11) == 0);
-    bool want_survey_state = (memcmp(req, "GET /survey_state.json", 22) == 0);
-    bool want_submit       = (memcmp(req, "GET /survey_submit",     18) == 0);
-
-    if (want_submit) {
-        // /survey_submit?ans=##########   (10 bits)
-        const char *a = strstr(req, "ans=");
-        char tmp[12] = {0};
-        if (a) {
-            a += 4;
-            size_t i = 0;
-            while (i < 10 && (a[i] == '0' || a[i] == '1')) { tmp[i] = a[i]; i++; }
-            tmp[i] = '\0';
+#define REDIRECT_DISPLAY_BODY "<!doctype html><meta http-equiv='refresh' content='0;url=/display'>OK"
+static const char k_hdr_redirect_display[] =
+    "HTTP/1.1 303 See Other\r\n"
+    "Location: /display\r\n"
+    HTTP_NO_CACHE
+    "Content-Length: 69\r\n";
+_Static_assert(sizeof(REDIRECT_DISPLAY_BODY) - 1 == 69, "Content-Length do redirect");
+static const http_resp_t k_redirect_display = HTTP_RESP(k_hdr_redirect_display, REDIRECT_DISPLAY_BODY);
+
+/* ---------- Portal cativo: sondas de conectividade ----------
+   O DNS responde tudo com o nosso IP, então as sondas do Android, iOS,
+   Windows e Firefox (e o tráfego de fundo dos apps) caem aqui. Sonda
+   conhecida recebe a resposta "online" que o sistema espera (poucos bytes,
+   e o celular não troca o AP pelos dados móveis); o resto leva um 302 seco
+   para /display em vez do painel inteiro. */
+static const char k_hdr_204[] =
+    "HTTP/1.1 204 No Content\r\n"
+    HTTP_NO_CACHE
+    "Content-Length: 0\r\n";
+static const char k_hdr_302_display[] =
+    "HTTP/1.1 302 Found\r\n"
+    "Location: /display\r\n"
+    HTTP_NO_CACHE
+    "Content-Length: 0\r\n";
+
+#define PROBE_APPLE_BODY "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>"
+#define PROBE_MSFT_BODY  "Microsoft Connect Test"
+#define PROBE_NCSI_BODY  "Microsoft NCSI"
+#define PROBE_MOZ_BODY   "success\n"
+#define HTTP_HDR_PROBE(type, len) \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: " type "\r\n" \
+    HTTP_NO_CACHE \
+    "Content-Length: " #len "\r\n"
+static const char k_hdr_probe_apple[] = HTTP_HDR_PROBE("text/html", 68);
+static const char k_hdr_probe_msft[]  = HTTP_HDR_PROBE("text/plain", 22);
+static const char k_hdr_probe_ncsi[]  = HTTP_HDR_PROBE("text/plain", 14);
+static const char k_hdr_probe_moz[]   = HTTP_HDR_PROBE("text/plain", 8);
+_Static_assert(sizeof(PROBE_APPLE_BODY) - 1 == 68 && sizeof(PROBE_MSFT_BODY) - 1 == 22 &&
+               sizeof(PROBE_NCSI_BODY) - 1 == 14 && sizeof(PROBE_MOZ_BODY) - 1 == 8,
+               "Content-Length das sondas");
+
+static const http_resp_t k_resp_204          = HTTP_RESP(k_hdr_204, "");
+static const http_resp_t k_resp_302_display  = HTTP_RESP(k_hdr_302_display, "");
+static const http_resp_t k_resp_probe_apple  = HTTP_RESP(k_hdr_probe_apple, PROBE_APPLE_BODY);
+static const http_resp_t k_resp_probe_msft   = HTTP_RESP(k_hdr_probe_msft, PROBE_MSFT_BODY);
+static const http_resp_t k_resp_probe_ncsi   = HTTP_RESP(k_hdr_probe_ncsi, PROBE_NCSI_BODY);
+static const http_resp_t k_resp_probe_moz    = HTTP_RESP(k_hdr_probe_moz, PROBE_MOZ_BODY);
+
+/* Ordenada por caminho (strcmp) */
+static const struct { const char *path; const http_resp_t *resp; } k_probes[] = {
+    { "/connecttest.txt",           &k_resp_probe_msft },   // Windows 10+
+    { "/favicon.ico",               &k_resp_204 },          // não vale um redirect
+    { "/gen_204",                   &k_resp_204 },          // Android/Chrome
+    { "/generate_204",              &k_resp_204 },          // Android
+    { "/hotspot-detect.html",       &k_resp_probe_apple },  // iOS/macOS
+    { "/library/test/success.html", &k_resp_probe_apple },  // iOS antigo
+    { "/ncsi.txt",                  &k_resp_probe_ncsi },   // Windows 7/8
+    { "/success.txt",               &k_resp_probe_moz },    // Firefox
+};
+#define HTTP_NUM_PROBES (sizeof k_probes / sizeof k_probes[0])
+
+static const http_resp_t *http_probe_find(const char *path) {
+    size_t lo = 0, hi = HTTP_NUM_PROBES;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int d = strcmp(path, k_probes[mid].path);
+        if (!d) return k_probes[mid].resp;
+        if (d < 0) hi = mid; else lo = mid + 1;
+    }
+    return NULL;
+}
+
+// Atendidas pelo caminho curto e bytes poupados em relação ao painel inteiro
+static uint32_t s_probe_hits  = 0;
+static uint32_t s_probe_saved = 0;
+
+void web_probe_stats(uint32_t *hits, uint32_t *bytes_saved) {
+    if (hits)        *hits        = s_probe_hits;
+    if (bytes_saved) *bytes_saved = s_probe_saved;
+}
+
+/* ---------- Requisições recusadas pelo parser (a conexão fecha em seguida) ---------- */
+static const char k_hdr_400[] =
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Content-Length: 0\r\n";
+// 405: Allow com os métodos da rota (GET, POST ou os dois, como /survey_submit)
+static const char k_hdr_405_get[] =
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: GET\r\n"
+    "Content-Length: 0\r\n";
+static const char k_hdr_405_post[] =         // /bench/up
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: POST\r\n"
+    "Content-Length: 0\r\n";
+static const char k_hdr_405_both[] =
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: GET, POST\r\n"
+    "Content-Length: 0\r\n";
+static const char k_hdr_413[] =
+    "HTTP/1.1 413 Payload Too Large\r\n"
+    "Content-Length: 0\r\n";
+static const char k_hdr_414[] =
+    "HTTP/1.1 414 URI Too Long\r\n"
+    "Content-Length: 0\r\n";
+static const char k_hdr_431[] =              // passou de HTTP_HEAD_MAX
+    "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+    "Content-Length: 0\r\n";
+static const char k_hdr_501[] =              // método desconhecido ou corpo chunked
+    "HTTP/1.1 501 Not Implemented\r\n"
+    "Content-Length: 0\r\n";
+static const http_resp_t k_resp_400 = HTTP_RESP(k_hdr_400, "");
+static const http_resp_t k_resp_405[] = {     // por rt->methods
+    [HTTP_GET]             = HTTP_RESP(k_hdr_405_get, ""),
+    [HTTP_POST]            = HTTP_RESP(k_hdr_405_post, ""),
+    [HTTP_GET | HTTP_POST] = HTTP_RESP(k_hdr_405_both, ""),
+};
+static const http_resp_t k_resp_413 = HTTP_RESP(k_hdr_413, "");
+static const http_resp_t k_resp_414 = HTTP_RESP(k_hdr_414, "");
+static const http_resp_t k_resp_431 = HTTP_RESP(k_hdr_431, "");
+static const http_resp_t k_resp_501 = HTTP_RESP(k_hdr_501, "");
+
+static const http_resp_t *http_error_resp(u16_t status) {
+    switch (status) {
+    case 413: return &k_resp_413;
+    case 414: return &k_resp_414;
+    case 431: return &k_resp_431;
+    case 501: return &k_resp_501;
+    default:  return &k_resp_400;
+    }
+}
+
+/* ---------- Buffer das respostas dinâmicas ----------
+   O corpo é escrito em RESP_BODY e o cabeçalho (com Content-Length) é colado
+   logo antes, formando um bloco contíguo. Um dono por vez: liberado assim que
+   o lwIP copiou tudo (TCP_WRITE_FLAG_COPY); quem chega antes espera no rx. */
+#define HTTP_HDR_ROOM 256
+static char g_resp[HTTP_HDR_ROOM + 8192];
+#define RESP_BODY     (g_resp + HTTP_HDR_ROOM)
+#define RESP_BODY_MAX (sizeof g_resp - HTTP_HDR_ROOM)
+
+/* ---------- Métricas (/metrics, /metrics.json) ----------
+   Só contadores u32 incrementados no caminho da requisição; a exportação lê
+   os valores ao vivo, campo a campo (mesmo gerador em streaming do
+   /stats.json). Tempo do handler em buckets log2 de µs: bucket b conta
+   chamadas com t <= 2^b µs; o último é o +Inf. */
+#define HTTP_ROUTES_MAX   20     // k_routes + "outros" (fallback, erros)
+#define HTTP_HIST_BUCKETS 14     // 1 µs .. 4096 µs, +Inf
+
+typedef struct {
+    u32_t n;                     // requisições atendidas
+    u32_t bytes;                 // bytes entregues ao tcp_write
+    u32_t us_sum;                // soma do tempo do handler
+    u32_t hist[HTTP_HIST_BUCKETS];
+} http_route_metrics_t;
+
+static http_route_metrics_t s_rm[HTTP_ROUTES_MAX];
+static struct {
+    u32_t stalls;                // tcp_sndbuf == 0 com resposta pendente
+    u32_t aborts;                // conexões abortadas por nós (tcp_abort)
+    u32_t resets;                // conexões derrubadas pelo lwIP (RST/erro)
+    u32_t refused;               // accept sem slot livre
+    u32_t errors;                // 4xx/501 do parser e 405
+} s_hm;
+
+static inline u8_t http_hist_bucket(u32_t us) {
+    u32_t b = us <= 1 ? 0 : 32 - (u32_t)__builtin_clz(us - 1);
+    return (u8_t)(b < HTTP_HIST_BUCKETS - 1 ? b : HTTP_HIST_BUCKETS - 1);
+}
+
+/* Geradores de corpo em streaming (http_conn_t.gen) */
+#define HTTP_GEN_NONE    0
+#define HTTP_GEN_STATS   1       // /stats.json
+#define HTTP_GEN_METRICS 2       // /metrics (texto Prometheus)
+#define HTTP_GEN_MJSON   3       // /metrics.json
+#define HTTP_GEN_FILL    4       // /bench/down (da flash, sem cópia)
+#define HTTP_GEN_BENCH   5       // /bench.json, resposta do /bench/up
+
+static size_t metrics_field(u8_t gen, u16_t step, char *out, size_t outsz);
+
+/* ---------- Conexões persistentes (keep-alive + pipelining) ----------
+   Um slot por cliente: os pbufs recebidos ficam na fila rx_q (sem cópia) e o
+   parser os consome uma requisição por vez; a janela TCP só reabre com o que
+   foi consumido. A resposta em andamento vai em até 3 segmentos (cabeçalho,
+   fim do cabeçalho, corpo). */
+#define HTTP_MAX_CONN     10
+#define WS_RX_MAX         256    // frames do cliente WebSocket (close/ping)
+#define HTTP_POLL_TICKS   2      // tcp_poll a cada 2 x 500 ms
+#define HTTP_IDLE_POLLS   10     // ~10 s sem requisição -> fecha
+#define HTTP_STALL_POLLS  20     // ~20 s sem o cliente ler nada -> aborta
+#define HTTP_CHUNK_MAX    1200
+
+typedef struct { const char *buf; u16_t len; u8_t flags; } http_seg_t;
+
+/* Teste de vazão em andamento na conexão (/bench/down, /bench/up) */
+#define BENCH_NONE 0
+#define BENCH_DOWN 1
+#define BENCH_UP   2
+typedef struct {
+    u8_t  dir;                   // BENCH_*
+    u32_t target;                // bytes pedidos
+    u32_t bytes;                 // enfileirados (down) ou descartados (up)
+    u32_t t0;                    // time_us_32() no início
+    u32_t stalls;                // tcp_sndbuf == 0: parado esperando ACK
+    u32_t nomem;                 // ERR_MEM: fila/pbufs do lwIP cheios
+    u32_t rexmit0;               // retransmissões (todas as conexões) no início
+} http_bench_t;
+
+typedef struct {
+    struct tcp_pcb *pcb;         // NULL = slot livre
+    u32_t      stamp;            // última atividade (LRU para despejo)
+    u8_t       idle;             // polls sem atividade
+    bool       close_after;      // fecha depois de enfileirar a resposta atual
+    bool       peer_closed;      // cliente mandou FIN: atende o que falta e fecha
+    bool       wait_resp;        // requisição dinâmica esperando g_resp
+    bool       sse;              // virou stream /events: não lê mais requisições
+    u8_t       sse_topics;       // SSE_EV_* assinados
+    u8_t       sse_dirty;        // SSE_EV_* ainda não enviados (coalescidos)
+    u8_t       sse_color;        // filtro do evento stats (STAT_COLOR_*)
+    bool       sse_has_color;
+    bool       ws;               // virou WebSocket /ws
+    u8_t       ws_idle;          // lotes sem amostra (frame de BPM a cada ~1 s)
+    u32_t      ws_cursor;        // próxima amostra do anel do oxímetro
+    u8_t       gen;              // HTTP_GEN_*: corpo gerado sob demanda após os segmentos
+    bool       chunked;          // ...em Transfer-Encoding: chunked (senão até o FIN)
+    u16_t      gen_step;         // próximo campo do gerador
+    u8_t       route;            // índice em k_routes (métricas); HTTP_ROUTE_OTHER = resto
+    stats_json_t js;
+    http_bench_t bench;
+    u8_t       nseg, seg_i;
+    u16_t      seg_off;
+    http_seg_t seg[3];
+    struct pbuf *rx_q;           // entrada ainda não consumida pelo parser
+    union {
+        http_req_t req;          // HTTP: requisição em análise
+        struct { u16_t len; char buf[WS_RX_MAX]; } ws;   // depois do upgrade
+    } in;
+} http_conn_t;
+
+static http_conn_t  s_conn[HTTP_MAX_CONN];
+static http_conn_t *s_resp_owner = NULL;
+static u8_t         s_resp_waiters = 0;      // conexões com wait_resp, contadas ao vivo
+
+static void http_set_wait(http_conn_t *c, bool wait) {
+    if (c->wait_resp == wait) return;
+    c->wait_resp = wait;
+    if (wait) s_resp_waiters++; else s_resp_waiters--;
+}
+static u32_t        s_conn_stamp = 0;
+
+static err_t http_process(http_conn_t *c);
+static void  http_process_waiting(void);
+static void  bench_finish(http_conn_t *c, bool ok);
+
+static void http_conn_release(http_conn_t *c) {
+    bool owner = s_resp_owner == c;
+    if (owner) s_resp_owner = NULL;
+    c->pcb = NULL;
+    c->nseg = c->seg_i = 0;
+    c->seg_off = 0;
+    if (c->rx_q) { pbuf_free(c->rx_q); c->rx_q = NULL; }
+    http_req_reset(&c->in.req);
+    http_set_wait(c, false);
+    c->sse = false;
+    c->sse_topics = c->sse_dirty = 0;
+    c->ws = false;
+    c->gen = HTTP_GEN_NONE;
+    bench_finish(c, false);
+    if (owner) http_process_waiting();           // quem esperava g_resp não espera o poll
+}
+
+/* Fecha (ou aborta) a conexão; devolve ERR_ABRT quando houve tcp_abort */
+static err_t http_conn_close(http_conn_t *c, bool abort) {
+    struct tcp_pcb *pcb = c->pcb;
+    http_conn_release(c);
+    if (!pcb) return ERR_OK;
+    if (abort) s_hm.aborts++;
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_err(pcb, NULL);
+    tcp_poll(pcb, NULL, 0);
+    if (!abort && tcp_close(pcb) == ERR_OK) return ERR_OK;
+    if (!abort) s_hm.aborts++;
+    tcp_abort(pcb);
+    return ERR_ABRT;
+}
+
+/* Dá g_resp à primeira conexão que ficou esperando por ele */
+static void http_process_waiting(void) {
+    for (int i = 0; i < HTTP_MAX_CONN && !s_resp_owner; i++) {
+        http_conn_t *w = &s_conn[i];
+        if (w->pcb && w->wait_resp) {
+            http_set_wait(w, false);
+            http_process(w);
         }
-        if (tmp[0]) {
-            // Converte "##########" -> uint16_t bits (bit i = pergunta i)
-            uint16_t bits = 0;
-            for (int i = 0; i < 10 && tmp[i]; i++) {
-                if (tmp[i] == '1') bits |= (1u << i);
-            }
+    }
+}
 
-            // ---------- Atualiza estado de submissão pendente ----------
-            s_svy_last_bits  = bits;
-            s_svy_last_token = ++s_svy_token;   // novo token
-            s_survey_has     = true;
-            s_survey_mode    = false;           // fecha modo survey
+/* ---------- Teste de vazão (/bench) ----------
+   /bench/down manda N bytes de k_bench_fill (flash) com tcp_write sem cópia,
+   um segmento por escrita; /bench/up consome o corpo direto da rx_q e só
+   conta. O tempo é do servidor: do cabeçalho até o último ACK (down) ou até
+   o último byte lido (up). Retransmissões vêm do MIB2 do lwIP e são de todas
+   as conexões: rode o teste com a rede quieta. Os stalls daqui não entram em
+   http_send_stalls_total (num teste a janela enche o tempo todo). */
+#define BENCH_DEFAULT   (1024u * 1024u)
+#define BENCH_MAX       (64u * 1024u * 1024u)
+#define BENCH_PERIOD    64
+#define BENCH_FIELD_MAX 160
+#define BENCH_LINE  "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n"
+#define BENCH_LINE4 BENCH_LINE BENCH_LINE BENCH_LINE BENCH_LINE
+#define BENCH_LINE16 BENCH_LINE4 BENCH_LINE4 BENCH_LINE4 BENCH_LINE4
+static const char k_bench_fill[] = BENCH_LINE16 BENCH_LINE16;    // 2 KB
+_Static_assert(sizeof(BENCH_LINE) - 1 == BENCH_PERIOD, "linha tem um período");
+_Static_assert(sizeof k_bench_fill - 1 >= TCP_MSS + BENCH_PERIOD, "qualquer fase comporta um MSS");
+
+typedef struct { u32_t target, bytes, us, stalls, nomem, rexmit; bool done; } bench_result_t;
+static bench_result_t s_bench_last[2];          // [BENCH_DOWN - 1], [BENCH_UP - 1]
+static u32_t          s_bench_runs = 0;
+
+static u32_t bench_rexmit(void) {
+#if LWIP_STATS && MIB2_STATS
+    return lwip_stats.mib2.tcpretranssegs;
+#else
+    return 0;
+#endif
+}
 
-            // ---------- Agregado GLOBAL ----------
-            s_svy_n++;
-            for (int i = 0; i < 10; i++) {
-                if (bits & (1u << i)) s_svy_yes[i]++;
+static void bench_begin(http_conn_t *c, u8_t dir, u32_t target) {
+    bench_finish(c, false);                     // anterior ainda sem o último ACK
+    c->bench = (http_bench_t){ dir, target, 0, time_us_32(), 0, 0, bench_rexmit() };
+    s_bench_runs++;
+}
+
+/* Guarda o resultado; ok = terminou de verdade (ACK final ou corpo inteiro) */
+static void bench_finish(http_conn_t *c, bool ok) {
+    http_bench_t *b = &c->bench;
+    if (b->dir == BENCH_NONE) return;
+    bench_result_t *o = &s_bench_last[b->dir - 1];
+    o->target = b->target;
+    o->bytes  = b->bytes;
+    o->us     = time_us_32() - b->t0;
+    o->stalls = b->stalls;
+    o->nomem  = b->nomem;
+    o->rexmit = bench_rexmit() - b->rexmit0;
+    o->done   = ok && b->bytes == b->target;
+#ifndef NDEBUG
+    printf("BENCH: %s %lu/%lu B em %lu us, %lu stalls, %lu rexmit\n",
+           b->dir == BENCH_DOWN ? "down" : "up", (unsigned long)o->bytes, (unsigned long)o->target,
+           (unsigned long)o->us, (unsigned long)o->stalls, (unsigned long)o->rexmit);
+#endif
+    b->dir = BENCH_NONE;
+}
+
+/* /bench/down: enche a janela com fatias de k_bench_fill, sem cópia */
+static err_t bench_fill(http_conn_t *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    http_bench_t *b = &c->bench;
+    while (b->bytes < b->target) {
+        u16_t wnd = tcp_sndbuf(pcb);
+        if (!wnd) { b->stalls++; break; }
+        u32_t n = b->target - b->bytes;
+        if (n > TCP_MSS) n = TCP_MSS;
+        if (n > wnd)     n = wnd;
+        bool more = b->bytes + n < b->target;
+        err_t e = tcp_write(pcb, k_bench_fill + b->bytes % BENCH_PERIOD, (u16_t)n,
+                            more ? TCP_WRITE_FLAG_MORE : 0);
+        if (e == ERR_MEM) { b->nomem++; break; }
+        if (e != ERR_OK) return http_conn_close(c, true);
+        b->bytes += n;
+        s_rm[c->route].bytes += n;
+    }
+    if (b->bytes == b->target) c->gen = HTTP_GEN_NONE;
+    tcp_output(pcb);
+    return ERR_OK;
+}
+
+/* {"down":{...},"up":{...},"runs":N}: um campo por sentido */
+static size_t bench_field(u16_t step, char *out, size_t outsz) {
+    char tmp[BENCH_FIELD_MAX];
+    char *p = tmp;
+    if (step < 2) {
+        const bench_result_t *o = &s_bench_last[step];
+        u32_t kbps = o->us ? (u32_t)((uint64_t)o->bytes * 8000u / o->us) : 0;
+        p = fmt_str(p, step ? ",\"up\":{" : "{\"down\":{");
+        p = fmt_str(p, "\"target\":"); p = fmt_u32(p, o->target);
+        p = fmt_str(p, ",\"bytes\":");  p = fmt_u32(p, o->bytes);
+        p = fmt_str(p, ",\"us\":");     p = fmt_u32(p, o->us);
+        p = fmt_str(p, ",\"kbps\":");   p = fmt_u32(p, kbps);
+        p = fmt_str(p, ",\"stalls\":"); p = fmt_u32(p, o->stalls);
+        p = fmt_str(p, ",\"nomem\":");  p = fmt_u32(p, o->nomem);
+        p = fmt_str(p, ",\"rexmit\":"); p = fmt_u32(p, o->rexmit);
+        p = fmt_str(p, o->done ? ",\"done\":true}" : ",\"done\":false}");
+    } else if (step == 2) {
+        p = fmt_str(p, ",\"runs\":"); p = fmt_u32(p, s_bench_runs);
+        p = fmt_str(p, "}");
+    } else {
+        return 0;
+    }
+    size_t k = (size_t)(p - tmp);
+    if (k < outsz) { memcpy(out, tmp, k); out[k] = 0; }
+    return k;
+}
+
+/* ---------- Corpo em streaming (/stats.json, /metrics) ----------
+   Junta campos inteiros do gerador num pedaço do tamanho da janela livre
+   (tcp_sndbuf) e envia com cópia; o que não coube continua no sent/poll.
+   Pico de RAM por resposta: o estado em http_conn_t + um pedaço na pilha. */
+#define HTTP_STREAM_CHUNK 192
+_Static_assert(HTTP_STREAM_CHUNK <= 0xFF, "tamanho do pedaço cabe em 2 dígitos hex");
+_Static_assert(HTTP_STREAM_CHUNK >= STATS_JSON_FIELD_MAX + 6, "pedaço comporta o maior campo");
+_Static_assert(HTTP_STREAM_CHUNK >= BENCH_FIELD_MAX + 6, "pedaço comporta o maior campo");
+
+/* Campo `step` do gerador da conexão (0 = acabou) */
+static size_t http_gen_field(const http_conn_t *c, u16_t step, char *out, size_t outsz) {
+    if (c->gen == HTTP_GEN_STATS) return stats_json_field(&c->js, step, out, outsz);
+    if (c->gen == HTTP_GEN_BENCH) return bench_field(step, out, outsz);
+    return metrics_field(c->gen, step, out, outsz);
+}
+
+#ifndef NDEBUG
+/* Relata quando a pilha livre mínima (stackmark) cai */
+static void http_stack_report(void) {
+    static uint32_t low = UINT32_MAX;
+    uint32_t f = stackmark_free_min();
+    if (f < low) {
+        low = f;
+        printf("HTTP: pilha livre minima %lu B\n", (unsigned long)f);
+    }
+}
+#endif
+
+static err_t http_stream(http_conn_t *c) {
+    char buf[HTTP_STREAM_CHUNK + 1];              // +1: NUL do snprintf
+    struct tcp_pcb *pcb = c->pcb;
+    const size_t pre  = c->chunked ? 4 : 0;       // "XX\r\n"
+    const size_t post = c->chunked ? 2 : 0;       // "\r\n"
+    if (c->gen == HTTP_GEN_FILL) return bench_fill(c);
+    while (c->gen) {
+        size_t cap = tcp_sndbuf(pcb);
+        if (!cap) { s_hm.stalls++; break; }
+        if (cap > HTTP_STREAM_CHUNK) cap = HTTP_STREAM_CHUNK;
+        u16_t step0 = c->gen_step;
+        size_t off = pre;
+        while (off + post < cap) {
+            size_t k = http_gen_field(c, c->gen_step, buf + off, cap - post - off + 1);
+            if (!k || off + k + post > cap) break;
+            off += k;
+            c->gen_step++;
+        }
+        if (off > pre) {
+            if (c->chunked) {
+                static const char hex[] = "0123456789ABCDEF";
+                size_t n = off - pre;
+                buf[0] = hex[n >> 4]; buf[1] = hex[n & 15]; buf[2] = '\r'; buf[3] = '\n';
+                buf[off++] = '\r'; buf[off++] = '\n';
             }
+            err_t e = tcp_write(pcb, buf, (u16_t)off, TCP_WRITE_FLAG_COPY);
+            if (e == ERR_MEM) { c->gen_step = step0; break; }
+            if (e != ERR_OK) return http_conn_close(c, true);
+            s_rm[c->route].bytes += off;
+            continue;
         }
+        if (http_gen_field(c, c->gen_step, buf, 1)) break;   // próximo campo não coube na janela
+        if (c->chunked && tcp_write(pcb, "0\r\n\r\n", 5, 0) != ERR_OK) break;
+        s_rm[c->route].bytes += c->chunked ? 5 : 0;
+        c->gen = HTTP_GEN_NONE;
+#ifndef NDEBUG
+        http_stack_report();
+#endif
+    }
+    tcp_output(pcb);
+    return ERR_OK;
+}
 
-        make_redirect_display(g_resp, sizeof g_resp);
+/* Enfileira o que couber da resposta atual; o resto segue no sent/poll */
+static err_t http_send(http_conn_t *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    while (c->seg_i < c->nseg) {
+        const http_seg_t *sg = &c->seg[c->seg_i];
+        while (c->seg_off < sg->len) {
+            u16_t wnd = tcp_sndbuf(pcb);
+            if (!wnd) { s_hm.stalls++; break; }
+            u16_t chunk = sg->len - c->seg_off;
+            if (chunk > HTTP_CHUNK_MAX) chunk = HTTP_CHUNK_MAX;
+            if (chunk > wnd)            chunk = wnd;
+            bool more = (c->seg_off + chunk < sg->len) || (c->seg_i + 1 < c->nseg);
+            err_t e = tcp_write(pcb, sg->buf + c->seg_off, chunk,
+                                sg->flags | (more ? TCP_WRITE_FLAG_MORE : 0));
+            if (e == ERR_MEM) break;
+            if (e != ERR_OK) return http_conn_close(c, true);
+            s_rm[c->route].bytes += chunk;
+            c->seg_off += chunk;
+        }
+        if (c->seg_off < sg->len) break;
+        c->seg_i++;
+        c->seg_off = 0;
     }
-    else if (want_survey_state) {
-        make_json_survey_state(g_resp, sizeof g_resp);
+    tcp_output(pcb);
+    if (c->seg_i < c->nseg) return ERR_OK;
+    if (s_resp_owner == c) {                      // o lwIP já copiou g_resp
+        s_resp_owner = NULL;
+        http_process_waiting();
     }
-    else if (want_survey) {
-        make_html_survey(g_resp, sizeof g_resp);
+    if (c->gen) {
+        err_t e = http_stream(c);
+        if (e != ERR_OK || c->gen) return e;
     }
-    else if (want_stats) {
-        make_json_stats(g_resp, sizeof g_resp, req);
+
+    c->nseg = c->seg_i = 0;
+    return c->close_after ? http_conn_close(c, false) : ERR_OK;
+}
+
+/* Estática: cabeçalho e corpo direto da flash, sem cópia */
+static void http_queue_static(http_conn_t *c, const http_resp_t *r) {
+    c->seg[0] = (http_seg_t){ r->hdr, r->hdr_len, 0 };
+    c->seg[1] = c->close_after
+              ? (http_seg_t){ HTTP_TAIL_CLOSE, sizeof(HTTP_TAIL_CLOSE) - 1, 0 }
+              : (http_seg_t){ HTTP_TAIL_KEEP,  sizeof(HTTP_TAIL_KEEP) - 1,  0 };
+    c->seg[2] = (http_seg_t){ r->body, r->body_len, 0 };
+    c->nseg = 3; c->seg_i = 0; c->seg_off = 0;
+}
+
+/* Dinâmica: corpo já está em RESP_BODY; cola o cabeçalho antes e envia com cópia.
+   content_len > body_len: o resto do corpo vem do gerador (c->gen). */
+static void http_queue_head(http_conn_t *c, const char *hdr, u32_t content_len, size_t body_len) {
+    char h[HTTP_HDR_ROOM];
+    int n = snprintf(h, sizeof h, "%sContent-Length: %lu\r\n%s", hdr, (unsigned long)content_len,
+                     c->close_after ? HTTP_TAIL_CLOSE : HTTP_TAIL_KEEP);
+    if (n < 0) n = 0;
+    if (n > (int)sizeof h - 1) n = (int)sizeof h - 1;
+    char *start = RESP_BODY - n;
+    memcpy(start, h, (size_t)n);
+
+    s_resp_owner = c;
+    c->seg[0] = (http_seg_t){ start, (u16_t)((size_t)n + body_len), TCP_WRITE_FLAG_COPY };
+    c->nseg = 1; c->seg_i = 0; c->seg_off = 0;
+}
+
+static void http_queue_dynamic(http_conn_t *c, const char *hdr, size_t body_len) {
+    http_queue_head(c, hdr, (u32_t)body_len, body_len);
+}
+
+/* ---------- Server-Sent Events (/events) ----------
+   Cada cliente guarda só bits "sujos" por tipo de evento: várias mudanças
+   entre dois envios viram um único evento com o estado mais recente. Um
+   evento só é montado quando cabe inteiro no buffer de envio do pcb; se o
+   cliente está lento, o bit fica marcado e nada acumula na RAM. */
+#define SSE_EV_STATS     0x01
+#define SSE_EV_OLED      0x02
+#define SSE_EV_SURVEY    0x04
+#define SSE_EV_PING      0x80
+#define SSE_MAX_CLIENTS  6
+#define SSE_TICK_MS      50
+#define SSE_PING_POLLS   15      // comentário ":" a cada ~15 s sem tráfego
+
+static const char k_hdr_sse[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-store\r\n";
+static const http_resp_t k_resp_sse = HTTP_RESP(k_hdr_sse, "retry: 3000\n\n");
+
+static const char k_hdr_503[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Retry-After: 5\r\n"
+    "Content-Length: 0\r\n";
+static const http_resp_t k_resp_503 = HTTP_RESP(k_hdr_503, "");
+
+static uint32_t s_sse_sample_id = 0;
+
+/* Monta um evento em out; devolve o tamanho (0 se não coube) */
+static size_t sse_build(const http_conn_t *c, u8_t ev, char *out, size_t outsz) {
+    size_t n = 0;
+    switch (ev) {
+    case SSE_EV_STATS:
+        n = (size_t)snprintf(out, outsz, "event: stats\ndata: ");
+        n += make_json_stats(out + n, outsz - n - 2, (stat_color_t)c->sse_color, c->sse_has_color);
+        memcpy(out + n, "\n\n", 2);
+        return n + 2;
+    case SSE_EV_OLED:
+        n = (size_t)snprintf(out, outsz, "event: oled\ndata: ");
+        n += make_json_oled(out + n, outsz - n - 2);
+        memcpy(out + n, "\n\n", 2);
+        return n + 2;
+    case SSE_EV_SURVEY:
+        return (size_t)snprintf(out, outsz, "event: survey\ndata: {\"mode\":%d}\n\n", s_survey_mode ? 1 : 0);
+    case SSE_EV_PING:
+        return (size_t)snprintf(out, outsz, ":\n\n");
+    }
+    return 0;
+}
+
+/* Envia os eventos pendentes que couberem agora; g_resp é só rascunho aqui
+   (cada evento vai inteiro com cópia), então não precisa de dono. */
+static err_t sse_flush(http_conn_t *c) {
+    if (!c->sse || c->nseg || s_resp_owner) return ERR_OK;
+    bool wrote = false;
+    while (c->sse_dirty) {
+        u8_t ev = c->sse_dirty & (u8_t)-c->sse_dirty;    // bit mais baixo
+        size_t n = sse_build(c, ev, g_resp, sizeof g_resp);
+        if (n > tcp_sndbuf(c->pcb)) break;                // cliente lento: coalesce
+        err_t e = tcp_write(c->pcb, g_resp, (u16_t)n, TCP_WRITE_FLAG_COPY);
+        if (e == ERR_MEM) break;
+        if (e != ERR_OK) return http_conn_close(c, true);
+        s_rm[c->route].bytes += n;
+        c->sse_dirty &= (u8_t)~ev;
+        wrote = true;
     }
-    else if (want_oled) {
-        make_json_oled(g_resp, sizeof g_resp);
+    if (wrote) tcp_output(c->pcb);
+    return ERR_OK;
+}
+
+/* ---------- WebSocket (/ws): forma de onda PPG ao vivo ----------
+   RFC 6455 mínimo: só servidor -> cliente (frames binários sem máscara);
+   do cliente só tratamos ping e close. A cada WS_BATCH_TICKS o tick junta as
+   amostras novas de oximetro.c num único frame (um segmento TCP):
+     u8 versão(1) | u8 qualidade 0..100 | u16 bpm_live x10 | u32 seq da 1ª amostra
+     | int16 amostras[n]                                     (little-endian)
+   Orçamento fixo: no máx. WS_MAX_CLIENTS, WS_MAX_SAMPLES por frame, montado
+   na pilha; se o cliente não dá ACK, o frame é pulado (o anel do oxímetro
+   descarta o excesso) e nada bloqueia o laço de amostragem. */
+#define WS_MAX_CLIENTS   2
+#define WS_MAX_SAMPLES   32
+#define WS_BATCH_TICKS   4        // 4 x 50 ms = 200 ms (~5 amostras a 25 Hz)
+#define WS_IDLE_BATCHES  5        // sem amostras: frame só com BPM/qualidade a ~1 s
+#define WS_HDR_LEN       8
+#define WS_GUID          "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+static u8_t s_ws_tick = 0;
+
+static void base64_encode(const uint8_t *in, size_t n, char *out) {
+    static const char tbl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+    for (; i + 2 < n; i += 3) {
+        uint32_t v = ((uint32_t)in[i] << 16) | ((uint32_t)in[i+1] << 8) | in[i+2];
+        *out++ = tbl[v >> 18]; *out++ = tbl[(v >> 12) & 63]; *out++ = tbl[(v >> 6) & 63]; *out++ = tbl[v & 63];
     }
-    else if (want_display) {
-        make_html_display(g_resp, sizeof g_resp);
+    if (i < n) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < n) v |= (uint32_t)in[i+1] << 8;
+        *out++ = tbl[v >> 18]; *out++ = tbl[(v >> 12) & 63];
+        *out++ = (i + 1 < n) ? tbl[(v >> 6) & 63] : '=';
+        *out++ = '=';
     }
-    else if (want_csv) {
-        make_csv(g_resp, sizeof g_resp);
+    *out = '\0';
+}
+
+static void put_le16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_le32(uint8_t *p, uint32_t v) { put_le16(p, (uint16_t)v); put_le16(p + 2, (uint16_t)(v >> 16)); }
+
+/* Um frame com as amostras novas (ou só cabeçalho, se `force`) */
+static err_t ws_flush(http_conn_t *c, bool force) {
+    if (!c->ws || c->nseg) return ERR_OK;
+    // mais de um segmento sem ACK: cliente lento, pula esta rodada
+    if (tcp_sndbuf(c->pcb) < TCP_SND_BUF - TCP_MSS) return ERR_OK;
+
+    uint8_t f[4 + WS_HDR_LEN + 2 * WS_MAX_SAMPLES];
+    int16_t smp[WS_MAX_SAMPLES];
+    uint32_t n = oxi_wave_read(&c->ws_cursor, smp, WS_MAX_SAMPLES);
+    uint32_t first = c->ws_cursor - n;
+    if (!n && !force) return ERR_OK;
+
+    size_t plen = WS_HDR_LEN + 2 * n;
+    size_t h = 0;
+    f[h++] = 0x82;                                    // FIN + binário
+    if (plen < 126) f[h++] = (uint8_t)plen;
+    else { f[h++] = 126; f[h++] = (uint8_t)(plen >> 8); f[h++] = (uint8_t)plen; }
+
+    float bpm = oxi_get_bpm_live();
+    float q   = oxi_get_quality();
+    uint8_t *p = f + h;
+    p[0] = 1;
+    p[1] = (uint8_t)(q * 100.f + 0.5f);
+    put_le16(p + 2, (uint16_t)(bpm > 0.f ? bpm * 10.f + 0.5f : 0.f));
+    put_le32(p + 4, first);
+    for (uint32_t i = 0; i < n; i++) put_le16(p + WS_HDR_LEN + 2 * i, (uint16_t)smp[i]);
+
+    err_t e = tcp_write(c->pcb, f, (u16_t)(h + plen), TCP_WRITE_FLAG_COPY);
+    if (e == ERR_MEM) { c->ws_cursor = first; return ERR_OK; }   // tenta no próximo lote
+    if (e != ERR_OK) return http_conn_close(c, true);
+    s_rm[c->route].bytes += h + plen;
+    c->ws_idle = 0;
+    tcp_output(c->pcb);
+    return ERR_OK;
+}
+
+/* Frames do cliente (sempre mascarados): responde ping, fecha no close */
+static err_t ws_rx(http_conn_t *c) {
+    while (c->in.ws.len >= 2) {
+        const uint8_t *b = (const uint8_t *)c->in.ws.buf;
+        u8_t  op   = b[0] & 0x0F;
+        bool  mask = b[1] & 0x80;
+        u16_t len  = b[1] & 0x7F, h = 2;
+        if (len == 127 || !mask) return http_conn_close(c, true);     // não usamos/ilegal
+        if (len == 126) {
+            if (c->in.ws.len < 4) break;
+            len = (u16_t)((b[2] << 8) | b[3]); h = 4;
+        }
+        if ((size_t)h + 4 + len > WS_RX_MAX) return http_conn_close(c, true);
+        if (c->in.ws.len < h + 4 + len) break;
+
+        uint8_t *pl = (uint8_t *)c->in.ws.buf + h + 4;
+        for (u16_t i = 0; i < len; i++) pl[i] ^= b[h + (i & 3)];
+
+        if (op == 0x8) {                                             // close: ecoa e fecha
+            uint8_t fr[4] = { 0x88, 0x02, 0x03, 0xE8 };              // 1000 = normal
+            tcp_write(c->pcb, fr, sizeof fr, TCP_WRITE_FLAG_COPY);
+            return http_conn_close(c, false);
+        }
+        if (op == 0x9 && len <= 125) {                               // ping -> pong
+            uint8_t fr[2] = { 0x8A, (uint8_t)len };
+            if (tcp_write(c->pcb, fr, 2, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) == ERR_OK)
+                tcp_write(c->pcb, pl, len, TCP_WRITE_FLAG_COPY);
+            tcp_output(c->pcb);
+        }
+        u16_t used = h + 4 + len;
+        c->in.ws.len -= used;
+        memmove(c->in.ws.buf, c->in.ws.buf + used, c->in.ws.len);
     }
-    else {
-        make_html_pro(g_resp, sizeof g_resp);
+    return ERR_OK;
+}
+
+/* Handshake: 101 + Sec-WebSocket-Accept = base64(SHA-1(chave + GUID)) */
+static void ws_open(http_conn_t *c, const http_req_t *r) {
+    c->close_after = true;
+    if (!(r->flags & HQ_UPGRADE) || !r->ws_key[0]) { http_queue_static(c, &k_resp_400); return; }
+
+    int n = 0;
+    for (int i = 0; i < HTTP_MAX_CONN; i++) n += (s_conn[i].pcb && s_conn[i].ws);
+    if (n >= WS_MAX_CLIENTS) { http_queue_static(c, &k_resp_503); return; }
+
+    sha1_ctx_t sh;
+    uint8_t dig[20];
+    char acc[32];
+    sha1_init(&sh);
+    sha1_update(&sh, r->ws_key, strlen(r->ws_key));
+    sha1_update(&sh, WS_GUID, sizeof(WS_GUID) - 1);
+    sha1_final(&sh, dig);
+    base64_encode(dig, sizeof dig, acc);
+
+    char hdr[160];
+    int hl = snprintf(hdr, sizeof hdr,
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: %s\r\n\r\n", acc);
+    if (tcp_write(c->pcb, hdr, (u16_t)hl, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+        http_queue_static(c, &k_resp_503);
+        return;
     }
+    tcp_output(c->pcb);
+    c->close_after = false;
+    c->ws          = true;
+    c->ws_cursor   = 0;          // começa pelo que houver no anel (~2,5 s)
+    c->in.ws.len   = 0;          // a requisição acaba aqui: o union passa aos frames
+    c->ws_idle     = 0;
+    c->idle        = 0;
+}
 
-    g_tx.buf = g_resp;
-    g_tx.len = (u16_t)strlen(g_resp);
-    g_tx.off = 0;
+/* Timer no contexto do lwIP: junta as mudanças e distribui aos clientes
+   (eventos SSE a cada tick; lote do WebSocket a cada WS_BATCH_TICKS) */
+static void http_push_tick(void *arg) {
+    (void)arg;
+    u8_t ev = 0;
+    if (s_sse_oled_dirty)   { s_sse_oled_dirty = false;   ev |= SSE_EV_OLED; }
+    if (s_sse_survey_dirty) { s_sse_survey_dirty = false; ev |= SSE_EV_SURVEY; }
+    if (s_sse_stats_dirty)  { s_sse_stats_dirty = false;  ev |= SSE_EV_STATS; }
+    uint32_t sid = stats_get_sample_id();
+    if (sid != s_sse_sample_id) { s_sse_sample_id = sid; ev |= SSE_EV_STATS; }
+
+    bool ws_batch = (++s_ws_tick >= WS_BATCH_TICKS);
+    if (ws_batch) s_ws_tick = 0;
+
+    for (int i = 0; i < HTTP_MAX_CONN; i++) {
+        http_conn_t *c = &s_conn[i];
+        if (!c->pcb) continue;
+        if (c->sse) {
+            c->sse_dirty |= ev & c->sse_topics;
+            if (c->sse_dirty) sse_flush(c);
+        } else if (c->ws && ws_batch) {
+            ws_flush(c, ++c->ws_idle >= WS_IDLE_BATCHES);
+        }
+    }
+    sys_timeout(SSE_TICK_MS, http_push_tick, NULL);
+}
 
-    tcp_sent(tpcb, http_sent_cb);
-    if (http_send_chunk(tpcb)) {
-        tcp_sent(tpcb, NULL);
-        tcp_close(tpcb);
+/* Transforma a conexão em stream; o estado inicial completo sai no próximo tick */
+static void sse_open(http_conn_t *c, const http_req_t *r) {
+    int n = 0;
+    for (int i = 0; i < HTTP_MAX_CONN; i++) n += (s_conn[i].pcb && s_conn[i].sse);
+    if (n >= SSE_MAX_CLIENTS) {
+        c->close_after = true;               // cliente cai para polling
+        http_queue_static(c, &k_resp_503);
+        return;
     }
+    u8_t topics = 0;
+    if (http_param(r, "stats"))  topics |= SSE_EV_STATS;
+    if (http_param(r, "oled"))   topics |= SSE_EV_OLED;
+    if (http_param(r, "survey")) topics |= SSE_EV_SURVEY;
+    if (!topics) topics = SSE_EV_STATS | SSE_EV_OLED | SSE_EV_SURVEY;
+
+    stat_color_t col = STAT_COLOR_VERDE; bool has = false;
+    parse_color_query(r, &col, &has);
+
+    c->close_after   = false;
+    c->sse           = true;
+    c->sse_topics    = topics;
+    c->sse_dirty     = topics;
+    c->sse_color     = (u8_t)col;
+    c->sse_has_color = has;
+    c->idle          = 0;
+    http_queue_static(c, &k_resp_sse);
+}
+
+/* ---------- HTTP: rotas ----------
+   Tabela ordenada por caminho (strcmp), busca binária. Caminho desconhecido
+   cai em route_fallback (sonda ou 302 para /display). Rotas com
+   RT_RESP escrevem em g_resp: se ocupado, a requisição espera no parser.
+   RT_PRIO passa direto pela admissão; RT_POLL é o que as páginas consultam
+   em loop (custa mais sob pressão). Só rotas RT_SINK aceitam corpo maior
+   que HTTP_BODY_MAX (as outras respondem 413). */
+#define RT_RESP 0x01
+#define RT_PRIO 0x02
+#define RT_POLL 0x04
+#define RT_SINK 0x08
+
+typedef void (*http_handler_t)(http_conn_t *c, const http_req_t *r);
+typedef struct {
+    const char    *path;
+    u8_t           methods;      // HTTP_GET | HTTP_POST
+    u8_t           flags;        // RT_*
+    http_handler_t fn;
+} http_route_t;
+
+static void route_pro(http_conn_t *c, const http_req_t *r) {
+    http_resp_t p = web_asset_pick(&web_asset_pro, r);
+    http_queue_static(c, &p);
+}
+
+static void route_display(http_conn_t *c, const http_req_t *r) {
+    http_resp_t p = web_asset_pick(&web_asset_display, r);
+    http_queue_static(c, &p);
+}
+
+static void route_survey(http_conn_t *c, const http_req_t *r) {
+    http_resp_t p = web_asset_pick(s_survey_mode ? &web_asset_survey : &web_asset_survey_closed, r);
+    http_queue_static(c, &p);
+}
+
+static void route_survey_state(http_conn_t *c, const http_req_t *r) {
+    (void)r;
+    http_queue_static(c, &k_survey_state[s_survey_mode ? 1 : 0]);
+}
+
+// /survey_submit?ans=##########  (GET) ou corpo "ans=##########" (POST), 10 bits
+static void route_survey_submit(http_conn_t *c, const http_req_t *r) {
+    const char *a = http_param(r, "ans");
+    char tmp[12] = {0};
+    if (a) {
+        size_t i = 0;
+        while (i < 10 && (a[i] == '0' || a[i] == '1')) { tmp[i] = a[i]; i++; }
+        tmp[i] = '\0';
+    }
+    if (tmp[0]) {
+        // Converte "##########" -> uint16_t bits (bit i = pergunta i)
+        uint16_t bits = 0;
+        for (int i = 0; i < 10 && tmp[i]; i++) {
+            if (tmp[i] == '1') bits |= (1u << i);
+        }
+
+        // ---------- Atualiza estado de submissão pendente ----------
+        s_svy_last_bits  = bits;
+        s_svy_last_token = ++s_svy_token;   // novo token
+        s_survey_has     = true;
+        s_survey_mode    = false;           // fecha modo survey
+
+        // ---------- Agregado GLOBAL ----------
+        s_svy_n++;
+        for (int i = 0; i < 10; i++) {
+            if (bits & (1u << i)) s_svy_yes[i]++;
+        }
+        s_sse_survey_dirty = true;
+        s_sse_stats_dirty  = true;
+    }
+
+    http_queue_static(c, &k_redirect_display);
+}
+
+// Sonda conhecida -> resposta enlatada; qualquer outro caminho -> 302 /display
+static void route_fallback(http_conn_t *c, const http_req_t *r) {
+    const http_resp_t *p = http_probe_find(r->target);
+    if (!p) p = &k_resp_302_display;
+
+    // O que o portal mandava antes: o painel inteiro
+    http_resp_t full = web_asset_pick(&web_asset_pro, r);
+    u32_t was = (u32_t)full.hdr_len + full.body_len;
+    u32_t now = (u32_t)p->hdr_len + p->body_len;
+    s_probe_hits++;
+    if (was > now) s_probe_saved += was - now;
+#ifndef NDEBUG
+    if ((s_probe_hits & 15u) == 1u) {
+        printf("HTTP: %lu sondas/desconhecidos, %lu B poupados\n",
+               (unsigned long)s_probe_hits, (unsigned long)s_probe_saved);
+    }
+#endif
+    http_queue_static(c, p);
+}
+
+static void route_stats(http_conn_t *c, const http_req_t *r) {
+    stat_color_t col = STAT_COLOR_VERDE; bool has = false;
+    parse_color_query(r, &col, &has);
+    // Tamanho desconhecido: chunked no HTTP/1.1; no 1.0 o corpo termina no FIN
+    c->chunked = !(r->flags & HQ_HTTP10);
+    if (!c->chunked) c->close_after = true;
+    stats_json_begin(&c->js, col, has);
+    c->gen = HTTP_GEN_STATS;
+    c->gen_step = 0;
+    http_queue_static(c, c->chunked ? &k_resp_json_chunked : &k_resp_json_eof);
+}
+
+static const char k_hdr_metrics_chunked[] = HTTP_HDR_METRICS "Transfer-Encoding: chunked\r\n";
+static const char k_hdr_metrics_eof[]     = HTTP_HDR_METRICS;
+static const http_resp_t k_resp_metrics_chunked = HTTP_RESP(k_hdr_metrics_chunked, "");
+static const http_resp_t k_resp_metrics_eof     = HTTP_RESP(k_hdr_metrics_eof, "");
+
+static void route_metrics(http_conn_t *c, const http_req_t *r) {
+    bool json = !strcmp(r->target, "/metrics.json");
+    c->chunked = !(r->flags & HQ_HTTP10);
+    if (!c->chunked) c->close_after = true;
+    c->gen = json ? HTTP_GEN_MJSON : HTTP_GEN_METRICS;
+    c->gen_step = 0;
+    if (json) http_queue_static(c, c->chunked ? &k_resp_json_chunked : &k_resp_json_eof);
+    else      http_queue_static(c, c->chunked ? &k_resp_metrics_chunked : &k_resp_metrics_eof);
+}
+
+static void route_stats_bin(http_conn_t *c, const http_req_t *r) {
+    stat_color_t col = STAT_COLOR_VERDE; bool has = false;
+    parse_color_query(r, &col, &has);
+    http_queue_dynamic(c, HTTP_HDR_BIN, make_bin_stats((uint8_t *)RESP_BODY, RESP_BODY_MAX, col, has));
+}
+
+static void route_oled(http_conn_t *c, const http_req_t *r) {
+    (void)r;
+    http_queue_dynamic(c, HTTP_HDR_JSON, make_json_oled(RESP_BODY, RESP_BODY_MAX));
+}
+
+// /fb.bin?v=N: 304 se N é a versão atual, delta desde N, ou o quadro inteiro
+// (sem v, N à frente da placa, p.ex. depois de um reboot, ou atrás demais)
+static void route_fb(http_conn_t *c, const http_req_t *r) {
+    uint32_t ver = s_fb_version;
+    if (!ver) { http_queue_static(c, &k_resp_fb_404); return; }   // display.js fica no texto
+    const char *v = http_param(r, "v");
+    uint32_t since = v ? (uint32_t)strtoul(v, NULL, 10) : 0;
+    if (since == ver) { s_fb_304++; http_queue_static(c, &k_resp_fb_304); return; }
+    if (since > ver || ver - since > UINT16_MAX) since = 0;
+    if (since) s_fb_delta++; else s_fb_key++;
+    http_queue_dynamic(c, HTTP_HDR_BIN, make_bin_fb((uint8_t *)RESP_BODY, RESP_BODY_MAX, ver, since));
+}
+
+static void route_csv(http_conn_t *c, const http_req_t *r) {
+    (void)r;
+    http_queue_dynamic(c, HTTP_HDR_CSV, make_csv(RESP_BODY, RESP_BODY_MAX));
+}
+
+static void route_bench(http_conn_t *c, const http_req_t *r) {
+    http_resp_t p = web_asset_pick(&web_asset_bench, r);
+    http_queue_static(c, &p);
+}
+
+static void route_bench_json(http_conn_t *c, const http_req_t *r) {
+    c->chunked = !(r->flags & HQ_HTTP10);
+    if (!c->chunked) c->close_after = true;
+    c->gen = HTTP_GEN_BENCH;
+    c->gen_step = 0;
+    http_queue_static(c, c->chunked ? &k_resp_json_chunked : &k_resp_json_eof);
+}
+
+// /bench/down?bytes=N (padrão 1 MiB, até BENCH_MAX): cabeçalho em g_resp, corpo da flash
+static void route_bench_down(http_conn_t *c, const http_req_t *r) {
+    const char *v = http_param(r, "bytes");
+    u32_t n = v ? (u32_t)strtoul(v, NULL, 10) : 0;
+    if (!n) n = BENCH_DEFAULT;
+    if (n > BENCH_MAX) n = BENCH_MAX;
+    bench_begin(c, BENCH_DOWN, n);
+    c->gen = HTTP_GEN_FILL;
+    http_queue_head(c, HTTP_HDR_BIN, n, 0);
+}
+
+// POST /bench/up: o corpo (Content-Length) é descartado em http_process/bench_sink
+static void route_bench_up(http_conn_t *c, const http_req_t *r) {
+    bench_begin(c, BENCH_UP, r->content_len);
+    if (!(r->flags & HQ_BIGBODY)) c->bench.bytes = r->body_len;    // já veio no parser
+    c->chunked = !(r->flags & HQ_HTTP10);
+    if (!c->chunked) c->close_after = true;
+}
+
+/* /bench/up: descarta o corpo; true = acabou e a resposta foi enfileirada */
+static bool bench_sink(http_conn_t *c) {
+    http_bench_t *b = &c->bench;
+    while (c->rx_q && b->bytes < b->target) {
+        struct pbuf *q = c->rx_q;
+        u32_t n = b->target - b->bytes;
+        u16_t used = n < q->len ? (u16_t)n : q->len;
+        c->rx_q = pbuf_free_header(q, used);
+        tcp_recved(c->pcb, used);
+        b->bytes += used;
+    }
+    if (b->bytes < b->target) return false;
+    bench_finish(c, true);
+    c->gen = HTTP_GEN_BENCH;
+    c->gen_step = 0;
+    http_queue_static(c, c->chunked ? &k_resp_json_chunked : &k_resp_json_eof);
+    return true;
+}
+
+static const http_route_t k_routes[] = {
+    { "/",                  HTTP_GET,             0,                 route_pro },
+    { "/bench",             HTTP_GET,             0,                 route_bench },
+    { "/bench.json",        HTTP_GET,             0,                 route_bench_json },
+    { "/bench/down",        HTTP_GET,             RT_RESP,           route_bench_down },
+    { "/bench/up",          HTTP_POST,            RT_SINK,           route_bench_up },
+    { "/display",           HTTP_GET,             0,                 route_display },
+    { "/download.csv",      HTTP_GET,             RT_RESP,           route_csv },
+    { "/events",            HTTP_GET,             0,                 sse_open },
+    { "/fb.bin",            HTTP_GET,             RT_RESP | RT_POLL, route_fb },
+    { "/metrics",           HTTP_GET,             0,                 route_metrics },
+    { "/metrics.json",      HTTP_GET,             0,                 route_metrics },
+    { "/oled.json",         HTTP_GET,             RT_RESP | RT_POLL, route_oled },
+    { "/stats.bin",         HTTP_GET,             RT_RESP | RT_POLL, route_stats_bin },
+    { "/stats.json",        HTTP_GET,             RT_POLL,           route_stats },
+    { "/survey",            HTTP_GET,             0,                 route_survey },
+    { "/survey_state.json", HTTP_GET,             RT_POLL,           route_survey_state },
+    { "/survey_submit",     HTTP_GET | HTTP_POST, RT_PRIO,           route_survey_submit },
+    { "/ws",                HTTP_GET,             0,                 ws_open },
+};
+#define HTTP_NUM_ROUTES (sizeof k_routes / sizeof k_routes[0])
+
+static const http_route_t k_route_fallback = { NULL, HTTP_GET | HTTP_POST, 0, route_fallback };
+#define HTTP_ROUTE_OTHER HTTP_NUM_ROUTES
+_Static_assert(HTTP_NUM_ROUTES + 1 <= HTTP_ROUTES_MAX, "s_rm comporta todas as rotas");
+
+static const http_route_t *http_route_find(const char *path) {
+    size_t lo = 0, hi = HTTP_NUM_ROUTES;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int d = strcmp(path, k_routes[mid].path);
+        if (!d) return &k_routes[mid];
+        if (d < 0) hi = mid; else lo = mid + 1;
+    }
+    return &k_route_fallback;
+}
+
+/* ---------- Admissão: balde de fichas por IP ----------
+   Cada cliente ganha ADMIT_RATE fichas/s até ADMIT_BURST; cada requisição
+   gasta uma. Sob pressão (quase todos os slots ocupados ou alguém esperando
+   g_resp) os polls custam ADMIT_POLL_PRESSURE e quem não tem fichas leva o
+   503 e a conexão fecha, liberando o pcb. /survey_submit (RT_PRIO) nunca é
+   recusado. A tabela tem ADMIT_CLIENTS entradas; cliente novo toma a menos
+   recente (volta com o balde cheio, o que só afrouxa o limite). */
+#define ADMIT_CLIENTS        16
+#define ADMIT_RATE           4        // fichas/s: /display em polling faz 2 x 2/s
+#define ADMIT_BURST          8        // carga da página + primeiros polls
+#define ADMIT_POLL_PRESSURE  4        // sob pressão: ~1 poll/s por cliente
+#define ADMIT_PRESSURE_CONN  (HTTP_MAX_CONN - 2)
+#define ADMIT_MILLI          1000u    // fichas em milésimos: ganha ADMIT_RATE por ms
+
+typedef struct {
+    u32_t ip;                    // 0 = entrada livre
+    u32_t last_ms;               // último reabastecimento
+    u32_t stamp;                 // LRU
+    u16_t tokens;                // em milésimos de ficha
+} admit_client_t;
+
+static admit_client_t     s_admit[ADMIT_CLIENTS];
+static u32_t              s_admit_stamp = 0;
+static web_admit_stats_t  s_admit_stats;
+
+static const char k_hdr_503_rate[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Retry-After: 1\r\n"
+    "Content-Length: 0\r\n";
+static const http_resp_t k_resp_503_rate = HTTP_RESP(k_hdr_503_rate, "");
+
+void web_admit_stats(web_admit_stats_t *out) {
+    if (out) *out = s_admit_stats;
+}
+
+static admit_client_t *admit_lookup(u32_t ip, u32_t now) {
+    admit_client_t *old = &s_admit[0];
+    for (int i = 0; i < ADMIT_CLIENTS; i++) {
+        admit_client_t *a = &s_admit[i];
+        if (a->ip == ip) return a;
+        if (!a->ip) { old = a; break; }
+        if ((s32_t)(a->stamp - old->stamp) < 0) old = a;
+    }
+    if (old->ip) s_admit_stats.evicted++;
+    old->ip      = ip;
+    old->last_ms = now;
+    old->tokens  = ADMIT_BURST * ADMIT_MILLI;
+    return old;
+}
+
+static bool http_under_pressure(const http_conn_t *self) {
+    // outra conexão esperando g_resp (self não conta)
+    if (s_resp_waiters > (self->wait_resp ? 1 : 0)) return true;
+    int live = 0;
+    for (int i = 0; i < HTTP_MAX_CONN; i++) live += s_conn[i].pcb != NULL;
+    return live >= ADMIT_PRESSURE_CONN;
+}
+
+/* true = atende; false = 503 já enfileirado */
+static bool http_admit(http_conn_t *c, const http_route_t *rt, const http_req_t *r) {
+    if (rt->flags & RT_PRIO) { s_admit_stats.priority++; return true; }
+
+    u32_t now = sys_now();
+    u32_t ip  = ip4_addr_get_u32(ip_2_ip4(&c->pcb->remote_ip));
+    admit_client_t *a = admit_lookup(ip, now);
+    a->stamp = ++s_admit_stamp;
+
+    u32_t dt = now - a->last_ms;
+    if (dt > ADMIT_BURST * ADMIT_MILLI / ADMIT_RATE) dt = ADMIT_BURST * ADMIT_MILLI / ADMIT_RATE;
+    u32_t t = a->tokens + dt * ADMIT_RATE;
+    if (t > ADMIT_BURST * ADMIT_MILLI) t = ADMIT_BURST * ADMIT_MILLI;
+    a->last_ms = now;
+
+    bool pressure = http_under_pressure(c);
+    u32_t cost = ((rt->flags & RT_POLL) && pressure ? ADMIT_POLL_PRESSURE : 1) * ADMIT_MILLI;
+    if (t >= cost) {
+        a->tokens = (u16_t)(t - cost);
+        s_admit_stats.admitted++;
+        return true;
+    }
+    a->tokens = (u16_t)t;
+    if (r->flags & HQ_BIGBODY) c->close_after = true;    // corpo não lido (/bench/up)
+    if (pressure) {
+        s_admit_stats.shed++;
+        c->close_after = true;
+        http_queue_static(c, &k_resp_503);
+    } else {
+        s_admit_stats.limited++;
+        http_queue_static(c, &k_resp_503_rate);
+    }
+    return false;
+}
+
+/* ---------- Exportação das métricas ----------
+   Mesmo contrato do stats_json_field: cada `step` é uma linha (texto) ou um
+   pedaço do objeto (JSON), montado em tmp e copiado só se couber. */
+#define METRICS_FIELD_MAX 176     // pior caso: "hist" do JSON com 14 x u32
+_Static_assert(HTTP_STREAM_CHUNK >= METRICS_FIELD_MAX + 6, "pedaço comporta o maior campo");
+
+#define HTTP_NUM_MROUTES (HTTP_NUM_ROUTES + 1)
+#define METRICS_HIST_LINES (HTTP_HIST_BUCKETS + 2)   // buckets, _sum, _count
+
+static const char *metrics_route_name(u8_t i) {
+    return i < HTTP_NUM_ROUTES ? k_routes[i].path : "other";
+}
+
+typedef struct { const char *name; const u32_t *v; } metrics_counter_t;
+static const metrics_counter_t k_metrics_counters[] = {
+    { "http_send_stalls_total",      &s_hm.stalls },
+    { "http_conn_aborts_total",      &s_hm.aborts },
+    { "http_conn_resets_total",      &s_hm.resets },
+    { "http_conn_refused_total",     &s_hm.refused },
+    { "http_request_errors_total",   &s_hm.errors },
+    { "http_admit_total",            &s_admit_stats.admitted },
+    { "http_admit_priority_total",   &s_admit_stats.priority },
+    { "http_admit_limited_total",    &s_admit_stats.limited },
+    { "http_admit_shed_total",       &s_admit_stats.shed },
+    { "http_admit_evicted_total",    &s_admit_stats.evicted },
+    { "http_probe_hits_total",       &s_probe_hits },
+    { "http_probe_saved_bytes_total", &s_probe_saved },
+    { "http_bench_runs_total",       &s_bench_runs },
+    { "http_fb_key_total",           &s_fb_key },
+    { "http_fb_delta_total",         &s_fb_delta },
+    { "http_fb_not_modified_total",  &s_fb_304 },
+};
+#define METRICS_NUM_COUNTERS (sizeof k_metrics_counters / sizeof k_metrics_counters[0])
+
+/* Pools do lwIP (lwipopts.h liga MEM_STATS/MEMP_STATS); "heap" = mem_malloc */
+#define METRICS_HAVE_POOLS (LWIP_STATS && MEM_STATS && MEMP_STATS)
+#if METRICS_HAVE_POOLS
+static const struct { const char *name; int pool; } k_metrics_pools[] = {
+    { "heap",           -1 },
+    { "tcp_pcb",        MEMP_TCP_PCB },
+    { "tcp_pcb_listen", MEMP_TCP_PCB_LISTEN },
+    { "tcp_seg",        MEMP_TCP_SEG },
+    { "pbuf",           MEMP_PBUF },
+    { "pbuf_pool",      MEMP_PBUF_POOL },
+    { "sys_timeout",    MEMP_SYS_TIMEOUT },
+};
+#define METRICS_NUM_POOLS (sizeof k_metrics_pools / sizeof k_metrics_pools[0])
+
+static const struct stats_mem *metrics_pool(u8_t i) {
+    int pool = k_metrics_pools[i].pool;
+    return pool < 0 ? &lwip_stats.mem : lwip_stats.memp[pool];
+}
+#endif
+
+static const char *const k_metrics_mem_fam[] = { "used", "max", "avail", "err" };
+
+/* Barramentos I2C (i2c_bus.c): uma família por contador, rótulo dev */
+static const struct { const char *name, *json, *type; } k_metrics_i2c_fam[] = {
+    { "i2c_transfers_total",  "transfers",  "counter" },
+    { "i2c_errors_total",     "errors",     "counter" },
+    { "i2c_timeouts_total",   "timeouts",   "counter" },
+    { "i2c_recoveries_total", "recoveries", "counter" },
+    { "i2c_latency_us_sum",   "us_sum",     "counter" },
+    { "i2c_latency_us_max",   "us_max",     "gauge" },
+};
+#define METRICS_NUM_I2C_FAM (sizeof k_metrics_i2c_fam / sizeof k_metrics_i2c_fam[0])
+
+static u32_t metrics_i2c_value(const i2c_dev_stats_t *s, u8_t fam) {
+    switch (fam) {
+    case 0:  return s->xfers;
+    case 1:  return s->errors;
+    case 2:  return s->timeouts;
+    case 3:  return s->recoveries;
+    case 4:  return s->us_sum;
+    default: return s->us_max;
+    }
+}
+
+static u32_t metrics_mem_value(u8_t pool, u8_t fam) {
+#if METRICS_HAVE_POOLS
+    const struct stats_mem *m = metrics_pool(pool);
+    switch (fam) {
+    case 0:  return m->used;
+    case 1:  return m->max;
+    case 2:  return m->avail;
+    default: return m->err;
+    }
+#else
+    (void)pool; (void)fam;
+    return 0;
+#endif
+}
+
+/* Texto (Prometheus 0.0.4): por seção, "# TYPE" e depois uma linha por rótulo */
+static char *metrics_text(char *p, u16_t step) {
+    u16_t i = step;
+    for (u8_t f = 0; f < 2; f++) {                       // requests, bytes
+        const char *name = f ? "http_sent_bytes_total" : "http_requests_total";
+        if (i == 0) {
+            p = fmt_str(p, "# TYPE "); p = fmt_str(p, name); return fmt_str(p, " counter\n");
+        }
+        if (--i < HTTP_NUM_MROUTES) {
+            p = fmt_str(p, name); p = fmt_str(p, "{route=\"");
+            p = fmt_str(p, metrics_route_name((u8_t)i)); p = fmt_str(p, "\"} ");
+            p = fmt_u32(p, f ? s_rm[i].bytes : s_rm[i].n);
+            return fmt_str(p, "\n");
+        }
+        i -= HTTP_NUM_MROUTES;
+    }
+    if (i == 0) return fmt_str(p, "# TYPE http_handler_us histogram\n");
+    if (--i < HTTP_NUM_MROUTES * METRICS_HIST_LINES) {
+        const http_route_metrics_t *m = &s_rm[i / METRICS_HIST_LINES];
+        const char *route = metrics_route_name((u8_t)(i / METRICS_HIST_LINES));
+        u8_t k = (u8_t)(i % METRICS_HIST_LINES);
+        if (k < HTTP_HIST_BUCKETS) {
+            u32_t cum = 0;
+            for (u8_t b = 0; b <= k; b++) cum += m->hist[b];
+            p = fmt_str(p, "http_handler_us_bucket{route=\""); p = fmt_str(p, route);
+            p = fmt_str(p, "\",le=\"");
+            if (k < HTTP_HIST_BUCKETS - 1) p = fmt_u32(p, 1u << k);
+            else                           p = fmt_str(p, "+Inf");
+            p = fmt_str(p, "\"} "); p = fmt_u32(p, cum);
+        } else {
+            p = fmt_str(p, k == HTTP_HIST_BUCKETS ? "http_handler_us_sum{route=\""
+                                                  : "http_handler_us_count{route=\"");
+            p = fmt_str(p, route); p = fmt_str(p, "\"} ");
+            p = fmt_u32(p, k == HTTP_HIST_BUCKETS ? m->us_sum : m->n);
+        }
+        return fmt_str(p, "\n");
+    }
+    i -= HTTP_NUM_MROUTES * METRICS_HIST_LINES;
+    if (i < METRICS_NUM_COUNTERS) {
+        const metrics_counter_t *k = &k_metrics_counters[i];
+        p = fmt_str(p, "# TYPE "); p = fmt_str(p, k->name); p = fmt_str(p, " counter\n");
+        p = fmt_str(p, k->name); p = fmt_str(p, " "); p = fmt_u32(p, *k->v);
+        return fmt_str(p, "\n");
+    }
+    i -= METRICS_NUM_COUNTERS;
+    u8_t ndev = i2c_bus_dev_count();
+    for (u8_t f = 0; f < METRICS_NUM_I2C_FAM; f++) {     // i2c_*{dev}
+        if (i == 0) {
+            p = fmt_str(p, "# TYPE "); p = fmt_str(p, k_metrics_i2c_fam[f].name);
+            p = fmt_str(p, " "); p = fmt_str(p, k_metrics_i2c_fam[f].type); return fmt_str(p, "\n");
+        }
+        if (--i < ndev) {
+            const i2c_dev_t *d = i2c_bus_dev((u8_t)i);
+            p = fmt_str(p, k_metrics_i2c_fam[f].name);
+            p = fmt_str(p, "{dev=\""); p = fmt_str(p, d->name); p = fmt_str(p, "\"} ");
+            p = fmt_u32(p, metrics_i2c_value(&d->stats, f));
+            return fmt_str(p, "\n");
+        }
+        i -= ndev;
+    }
+#if METRICS_HAVE_POOLS
+    for (u8_t f = 0; f < 4; f++) {                       // lwip_mem_{used,max,avail,err}
+        if (i == 0) {
+            p = fmt_str(p, "# TYPE lwip_mem_"); p = fmt_str(p, k_metrics_mem_fam[f]);
+            return fmt_str(p, f == 3 ? " counter\n" : " gauge\n");
+        }
+        if (--i < METRICS_NUM_POOLS) {
+            p = fmt_str(p, "lwip_mem_"); p = fmt_str(p, k_metrics_mem_fam[f]);
+            p = fmt_str(p, "{pool=\""); p = fmt_str(p, k_metrics_pools[i].name); p = fmt_str(p, "\"} ");
+            p = fmt_u32(p, metrics_mem_value((u8_t)i, f));
+            return fmt_str(p, "\n");
+        }
+        i -= METRICS_NUM_POOLS;
+    }
+#endif
+    return NULL;
+}
+
+/* JSON: {"routes":[{...},...],"http":{...},"i2c":[{...}|null,...],"lwip":{"heap":{...},...}}
+   i2c tem sempre I2C_BUS_MAX_DEVS vagas (null = livre): o oxímetro e a cor
+   se registram no primeiro uso, talvez no meio de uma resposta */
+static char *metrics_json(char *p, u16_t step) {
+    u16_t i = step;
+    if (i < 2 * HTTP_NUM_MROUTES) {
+        const http_route_metrics_t *m = &s_rm[i / 2];
+        if (!(i & 1)) {
+            p = fmt_str(p, i ? "{\"path\":\"" : "{\"routes\":[{\"path\":\"");
+            p = fmt_str(p, metrics_route_name((u8_t)(i / 2)));
+            p = fmt_str(p, "\",\"n\":");      p = fmt_u32(p, m->n);
+            p = fmt_str(p, ",\"bytes\":");    p = fmt_u32(p, m->bytes);
+            p = fmt_str(p, ",\"us_sum\":");   p = fmt_u32(p, m->us_sum);
+            return fmt_str(p, ",");
+        }
+        p = fmt_str(p, "\"hist\":[");
+        for (u8_t b = 0; b < HTTP_HIST_BUCKETS; b++) {
+            if (b) *p++ = ',';
+            p = fmt_u32(p, m->hist[b]);
+        }
+        return fmt_str(p, i + 1 < 2 * HTTP_NUM_MROUTES ? "]}," : "]}]");
+    }
+    i -= 2 * HTTP_NUM_MROUTES;
+    if (i < METRICS_NUM_COUNTERS) {
+        const metrics_counter_t *k = &k_metrics_counters[i];
+        p = fmt_str(p, i ? ",\"" : ",\"http\":{\"");
+        p = fmt_str(p, k->name); p = fmt_str(p, "\":"); p = fmt_u32(p, *k->v);
+        return fmt_str(p, i + 1 < METRICS_NUM_COUNTERS ? "" : "}");
+    }
+    i -= METRICS_NUM_COUNTERS;
+    if (i < I2C_BUS_MAX_DEVS) {
+        const i2c_dev_t *d = i2c_bus_dev((u8_t)i);
+        p = fmt_str(p, i ? "," : ",\"i2c\":[");
+        if (!d) {
+            p = fmt_str(p, "null");
+        } else {
+            p = fmt_str(p, "{\"dev\":\""); p = fmt_str(p, d->name); *p++ = '"';
+            for (u8_t f = 0; f < METRICS_NUM_I2C_FAM; f++) {
+                p = fmt_str(p, ",\""); p = fmt_str(p, k_metrics_i2c_fam[f].json);
+                p = fmt_str(p, "\":"); p = fmt_u32(p, metrics_i2c_value(&d->stats, (u8_t)f));
+            }
+            *p++ = '}';
+        }
+        return fmt_str(p, i + 1 < I2C_BUS_MAX_DEVS ? "" : "]");
+    }
+    i -= I2C_BUS_MAX_DEVS;
+#if METRICS_HAVE_POOLS
+    if (i < METRICS_NUM_POOLS) {
+        p = fmt_str(p, i ? ",\"" : ",\"lwip\":{\"");
+        p = fmt_str(p, k_metrics_pools[i].name); p = fmt_str(p, "\":{");
+        for (u8_t f = 0; f < 4; f++) {
+            p = fmt_str(p, f ? ",\"" : "\""); p = fmt_str(p, k_metrics_mem_fam[f]);
+            p = fmt_str(p, "\":"); p = fmt_u32(p, metrics_mem_value((u8_t)i, f));
+        }
+        return fmt_str(p, i + 1 < METRICS_NUM_POOLS ? "}" : "}}}");
+    }
+    i -= METRICS_NUM_POOLS;
+    return NULL;
+#else
+    return i ? NULL : fmt_str(p, "}");
+#endif
+}
+
+static size_t metrics_field(u8_t gen, u16_t step, char *out, size_t outsz) {
+    char tmp[METRICS_FIELD_MAX];
+    char *p = gen == HTTP_GEN_MJSON ? metrics_json(tmp, step) : metrics_text(tmp, step);
+    if (!p) return 0;
+    size_t k = (size_t)(p - tmp);
+    if (k < outsz) { memcpy(out, tmp, k); out[k] = 0; }
+    return k;
+}
+
+/* Atende a requisição completa em r. false = rota com g_resp ocupado por
+   outra conexão: fica no parser e é retomada depois. */
+static bool http_route(http_conn_t *c, const http_req_t *r) {
+    if (r->status || !r->method) {
+        s_hm.errors++;
+        c->route = HTTP_ROUTE_OTHER;
+        c->close_after = true;
+        http_queue_static(c, http_error_resp(r->status ? r->status : 501));
+        return true;
+    }
+    const http_route_t *rt = http_route_find(r->target);
+    bool allowed = rt->methods & r->method;
+    if (allowed && (rt->flags & RT_RESP) && s_resp_owner) {
+        http_set_wait(c, true);
+        return false;
+    }
+    http_set_wait(c, false);                      // retomada pelo poll ou pelo recv
+    c->route = rt == &k_route_fallback ? HTTP_ROUTE_OTHER : (u8_t)(rt - k_routes);
+    c->close_after = c->peer_closed || !http_wants_keep_alive(r);
+    if (!allowed) {
+        s_hm.errors++;
+        if (r->flags & HQ_BIGBODY) c->close_after = true;
+        http_queue_static(c, &k_resp_405[rt->methods]);
+    } else if ((r->flags & HQ_BIGBODY) && !(rt->flags & RT_SINK)) {
+        s_hm.errors++;                            // corpo não lido: não dá para continuar
+        c->close_after = true;
+        http_queue_static(c, &k_resp_413);
+    } else if (http_admit(c, rt, r)) {
+        u32_t t0 = time_us_32();
+        rt->fn(c, r);
+        u32_t us = time_us_32() - t0;
+        http_route_metrics_t *m = &s_rm[c->route];
+        m->n++;
+        m->us_sum += us;
+        m->hist[http_hist_bucket(us)]++;
+    }
+    return true;
+}
+
+/* Descarta a entrada pendente (a conexão virou stream) */
+static void http_rx_drop(http_conn_t *c) {
+    if (!c->rx_q) return;
+    tcp_recved(c->pcb, c->rx_q->tot_len);
+    pbuf_free(c->rx_q);
+    c->rx_q = NULL;
+}
+
+/* Alimenta o parser com a fila rx_q e atende uma requisição por vez (pipelining) */
+static err_t http_process(http_conn_t *c) {
+    while (c->pcb && c->nseg == 0 && !c->sse && !c->ws) {
+        http_req_t *r = &c->in.req;
+        if (c->bench.dir == BENCH_UP) {           // corpo do /bench/up antes da resposta
+            if (!bench_sink(c)) {
+                if (c->peer_closed) return http_conn_close(c, false);
+                break;
+            }
+        } else {
+            while (c->rx_q && r->st != HP_DONE) {
+                struct pbuf *q = c->rx_q;
+                u16_t used = http_parse(r, (const char *)q->payload, q->len);
+                c->rx_q = pbuf_free_header(q, used);
+                tcp_recved(c->pcb, used);
+            }
+            if (r->st != HP_DONE) {
+                if (c->peer_closed) return http_conn_close(c, false);
+                break;
+            }
+            if (!http_route(c, r)) break;
+            if (c->ws || c->sse) {
+                http_rx_drop(c);
+            } else {
+                http_req_reset(r);
+            }
+            if (c->bench.dir == BENCH_UP) continue;
+        }
+        err_t e = http_send(c);
+        if (e != ERR_OK) return e;
+    }
+    return ERR_OK;
+}
+
+static err_t http_recv_cb(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    http_conn_t *c = (http_conn_t *)arg;
+    if (!p && (c->sse || c->ws)) return http_conn_close(c, false);
+    if (!p) {
+        c->peer_closed = true;
+        return c->nseg ? ERR_OK : http_process(c);
+    }
+    if (err != ERR_OK || c->sse) {        // stream /events: o cliente não manda mais nada útil
+        tcp_recved(tpcb, p->tot_len);
+        pbuf_free(p);
+        return ERR_OK;
+    }
+
+    c->idle  = 0;
+    c->stamp = ++s_conn_stamp;
+    if (c->ws) {
+        u16_t room = WS_RX_MAX - c->in.ws.len;
+        if (p->tot_len > room) return ERR_MEM;
+        pbuf_copy_partial(p, c->in.ws.buf + c->in.ws.len, p->tot_len, 0);
+        c->in.ws.len += p->tot_len;
+        tcp_recved(tpcb, p->tot_len);
+        pbuf_free(p);
+        return ws_rx(c);
+    }
+
+    // Sem cópia: o pbuf entra na fila e a janela reabre conforme o parser consome
+    if (c->rx_q) pbuf_cat(c->rx_q, p);
+    else         c->rx_q = p;
+    return c->nseg ? ERR_OK : http_process(c);
+}
+
+static err_t http_sent_cb(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    http_conn_t *c = (http_conn_t *)arg;
+    (void)len;
+    c->idle = 0;
+    if (c->nseg) {
+        err_t e = http_send(c);
+        if (e != ERR_OK) return e;
+    }
+    if (c->bench.dir == BENCH_DOWN && !c->gen && tcp_sndbuf(tpcb) >= TCP_SND_BUF) {
+        bench_finish(c, true);                    // último byte do /bench/down confirmado
+    }
+    if (c->sse) return sse_flush(c);
+    if (c->ws)  return ERR_OK;       // próximo lote sai no tick
+    return http_process(c);
+}
+
+static err_t http_poll_cb(void *arg, struct tcp_pcb *tpcb) {
+    http_conn_t *c = (http_conn_t *)arg;
+    if (c->nseg) {
+        // resposta parada: janela do cliente ou memória do lwIP
+        if (++c->idle >= HTTP_STALL_POLLS) return http_conn_close(c, true);
+        err_t e = http_send(c);
+        return e != ERR_OK ? e : http_process(c);
+    }
+    if (c->ws) {
+        if (tcp_sndbuf(tpcb) < TCP_SND_BUF) {            // frames sem ACK
+            if (++c->idle >= HTTP_STALL_POLLS) return http_conn_close(c, true);
+        } else {
+            c->idle = 0;
+        }
+        return ERR_OK;
+    }
+    if (c->sse) {
+        if (tcp_sndbuf(tpcb) < TCP_SND_BUF) {            // ainda há eventos sem ACK
+            if (++c->idle >= HTTP_STALL_POLLS) return http_conn_close(c, true);
+        } else if (++c->idle >= SSE_PING_POLLS) {
+            c->idle = 0;
+            c->sse_dirty |= SSE_EV_PING;
+            return sse_flush(c);
+        }
+        return ERR_OK;
+    }
+    if (c->wait_resp) return s_resp_owner ? ERR_OK : http_process(c);
+    if (++c->idle >= HTTP_IDLE_POLLS) return http_conn_close(c, false);
     return ERR_OK;
 }
 
+static void http_err_cb(void *arg, err_t err) {
+    (void)err;
+    http_conn_t *c = (http_conn_t *)arg;
+    if (c) { s_hm.resets++; http_conn_release(c); }   // o lwIP já liberou o pcb
+}
+
+/* Slot livre ou, sem nenhum, despeja a conexão ociosa mais antiga */
+static http_conn_t *http_conn_alloc(void) {
+    http_conn_t *lru = NULL;
+    for (int i = 0; i < HTTP_MAX_CONN; i++) {
+        http_conn_t *c = &s_conn[i];
+        if (!c->pcb) return c;
+        bool idle = !c->nseg && !c->rx_q && http_req_idle(&c->in.req) && !c->wait_resp && !c->sse && !c->ws
+                 && c->bench.dir != BENCH_UP;
+        if (idle && (!lru || (s32_t)(c->stamp - lru->stamp) < 0)) lru = c;
+    }
+    if (lru) http_conn_close(lru, false);
+    return lru;
+}
+
 static err_t http_accept_cb(void *arg, struct tcp_pcb *newpcb, err_t err) {
-    (void)arg; (void)err;
+    (void)arg;
+    if (err != ERR_OK || !newpcb) return ERR_VAL;
+
+    http_conn_t *c = http_conn_alloc();
+    if (!c) { s_hm.refused++; tcp_abort(newpcb); return ERR_ABRT; }
+    http_conn_release(c);
+    c->pcb         = newpcb;
+    c->stamp       = ++s_conn_stamp;
+    c->idle        = 0;
+    c->close_after = false;
+    c->peer_closed = false;
+
+    tcp_arg(newpcb, c);
+    tcp_nagle_disable(newpcb);   // respostas pequenas em sequência: sem esperar ACK
     tcp_recv(newpcb, http_recv_cb);
+    tcp_sent(newpcb, http_sent_cb);
+    tcp_err(newpcb, http_err_cb);
+    tcp_poll(newpcb, http_poll_cb, HTTP_POLL_TICKS);
     return ERR_OK;
 }
 
@@ -663,15 +2165,12 @@ static void http_start(void) {
     if (tcp_bind(pcb, IP_ANY_TYPE, HTTP_PORT) != ERR_OK) return;
     pcb = tcp_listen(pcb);
     tcp_accept(pcb, http_accept_cb);
+    sys_timeout(SSE_TICK_MS, http_push_tick, NULL);
     printf("HTTP em %d\n", HTTP_PORT);
 }
 
-void web_ap_start(void) {
+void web_stack_start(void) {
     stats_init();
-    if (cyw43_arch_init()) { printf("WiFi init falhou\n"); return; }
-    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
-    cyw43_arch_enable_ap_mode(AP_SSID, NULL, CYW43_AUTH_OPEN);
-    printf("AP SSID=%s (aberto, sem senha)\n", AP_SSID);
 
     ip4_addr_t gw, mask;
     IP4_ADDR(ip_2_ip4(&gw),   192,168,4,1);
@@ -680,5 +2179,5 @@ void web_ap_start(void) {
     dns_server_init(&s_dns, &gw);
 
     http_start();
-    printf("AP/DHCP/DNS/HTTP prontos em 192.168.4.1\n");
+    printf("DHCP/DNS/HTTP prontos em 192.168.4.1\n");
 }
@@ -1,18 +1,42 @@
 #pragma once
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 #include "stats.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Sobe o AP + DHCP/DNS + HTTP
+// Sobe o AP + DHCP/DNS + HTTP (web_ap_cyw43.c)
 void web_ap_start(void);
 
+// Só a pilha web (DHCP/DNS/HTTP em 192.168.4.1) sobre a netif já configurada.
+// Não toca no cyw43: é o que o build host (host/) chama sobre uma tap.
+void web_stack_start(void);
+
 // Espelha as 4 linhas do OLED para /display e /oled.json
 void web_display_set_lines(const char *l1, const char *l2, const char *l3, const char *l4);
 
+// Espelha o framebuffer do OLED (128x64, 1 KB em páginas, como o ssd1306)
+// para /fb.bin: chamar com o mesmo buffer que foi para o painel. Quadro
+// igual ao anterior não sobe a versão.
+void web_display_set_fb(const uint8_t *fb, size_t len);
+
+// Portal cativo: requisições atendidas pelo caminho curto (sondas de
+// conectividade + 302 para /display) e bytes poupados vs. o painel inteiro
+void web_probe_stats(uint32_t *hits, uint32_t *bytes_saved);
+
+// Admissão por IP (balde de fichas) no servidor HTTP
+typedef struct {
+    uint32_t admitted;   // passaram pelo balde
+    uint32_t priority;   // /survey_submit: sempre atendido
+    uint32_t limited;    // 503 por taxa (conexão segue aberta)
+    uint32_t shed;       // 503 sob pressão (conexão fecha)
+    uint32_t evicted;    // clientes tirados da tabela (LRU)
+} web_admit_stats_t;
+void web_admit_stats(web_admit_stats_t *out);
+
 // ---- Survey control ----
 // Liga/desliga o modo "abrir /survey" no /display
 void web_set_survey_mode(bool on);
@@ -0,0 +1,21 @@
+// Plataforma do web_ap no Pico W: liga o rádio em modo AP e sobe a pilha web
+// (web_ap.c) sobre a netif do cyw43. No build host (host/) este arquivo não
+// entra; a netif lá é uma tap do Linux.
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+
+#include "web_ap.h"
+
+#define AP_SSID   "TheraLink"
+
+void web_ap_start(void) {
+    if (cyw43_arch_init()) { printf("WiFi init falhou\n"); return; }
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
+    cyw43_arch_enable_ap_mode(AP_SSID, NULL, CYW43_AUTH_OPEN);
+    printf("AP SSID=%s (aberto, sem senha)\n", AP_SSID);
+
+    web_stack_start();
+}
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+Gera host/cor_corpus.csv: leituras CRGB do TCS34725 para o host/cor_bench.
+
+SINTÉTICO: modelo por canal, não espectro medido. Cada luz é um ganho por
+canal (R, G, B) + IR; cada pulseira uma refletância por canal + IR; o
+sensor soma um pouco dos canais vizinhos (crosstalk) e o clear enxerga o
+IR. Por leitura: distância/ângulo (escala), brilho especular do silicone
+(mistura com a cor da luz), ruído de contagem, e a exposição que a
+auto-exposição do cor.c escolheria. Leituras reais entram no mesmo
+formato: o main.c (sem NDEBUG) imprime "CRGB,<rotulo>,c,r,g,b,ganho,ms"
+durante a calibração.
+
+Colunas: luz,fase,rotulo,c,r,g,b,gain,integ_ms
+  fase  cal   = pulseira parada na frente do sensor (modo de calibração)
+        teste = no punho, como na triagem (mais variação)
+  rotulo verde|amarelo|vermelho (pulseiras) ou outro_* (deve ser rejeitado)
+
+Uso: python3 tools/gen_cor_corpus.py > host/cor_corpus.csv
+"""
+import math
+import random
+
+SEED = 20251018
+
+# (R, G, B, IR) relativos; nível = escala de brilho no sensor
+LIGHTS = {
+    "luz_dia":        ((1.00, 1.00, 1.00, 0.30), 1.00),
+    "fluorescente":   ((1.05, 1.00, 0.80, 0.10), 0.80),
+    "led_quente":     ((1.45, 1.00, 0.50, 0.05), 0.70),
+    "incandescente":  ((1.75, 1.00, 0.35, 1.20), 0.60),
+    "led_quente_dim": ((1.45, 1.00, 0.50, 0.05), 0.08),
+}
+
+BANDS = {
+    "verde":           (0.10, 0.42, 0.20, 0.50),
+    "amarelo":         (0.75, 0.62, 0.10, 0.70),
+    "vermelho":        (0.62, 0.09, 0.10, 0.70),
+    "outro_azul":      (0.08, 0.18, 0.50, 0.40),
+    "outro_branco":    (0.85, 0.85, 0.85, 0.80),
+    "outro_pele":      (0.55, 0.38, 0.30, 0.80),
+    "outro_laranja":   (0.80, 0.35, 0.08, 0.70),
+}
+
+# linha = canal do sensor, coluna = luz refletida em R', G', B'
+XTALK = ((1.00, 0.15, 0.05),
+         (0.12, 1.00, 0.18),
+         (0.04, 0.15, 1.00))
+
+# Escada do cor.c: (ganho, ciclos de 2,4 ms)
+LADDER = [(1, 10), (4, 10), (16, 10), (16, 21), (16, 43), (60, 43), (60, 100)]
+COUNTS_PER_UNIT = 60.0        # contagens por (nível x ganho x ciclo) com refletância 1
+
+N_CAL, N_TEST, N_OTHER = 32, 40, 20
+
+
+def reading(rng, light, band, still):
+    (il, level) = LIGHTS[light]
+    refl = BANDS[band]
+    scale = rng.uniform(0.85, 1.15) if still else rng.uniform(0.6, 1.3)
+    gloss = rng.uniform(0.0, 0.04) if still else rng.uniform(0.0, 0.12)
+    tint = [rng.gauss(1.0, 0.01 if still else 0.03) for _ in range(3)]
+    lit = [scale * (refl[i] * il[i] * tint[i] + gloss * il[i]) for i in range(3)]
+    ir = scale * (refl[3] * il[3] + gloss * il[3])
+    ch = [sum(XTALK[k][i] * lit[i] for i in range(3)) for k in range(3)]
+    clear = 0.9 * sum(lit) + ir
+
+    # Exposição: a mais sensível que não passa de 80% do fundo de escala
+    step = 0
+    for i, (g, cyc) in enumerate(LADDER):
+        if clear * level * g * cyc * COUNTS_PER_UNIT < 0.8 * min(65535, 1024 * cyc):
+            step = i
+    g, cyc = LADDER[step]
+    k = level * g * cyc * COUNTS_PER_UNIT
+    top = min(65535, 1024 * cyc)
+
+    def count(v):
+        v = v * k
+        v += rng.gauss(0, math.sqrt(max(v, 1.0)) + 2.0)
+        return int(min(top, max(0, round(v))))
+
+    return (count(clear), count(ch[0]), count(ch[1]), count(ch[2]), g, (cyc * 12 + 4) // 5)
+
+
+def main():
+    rng = random.Random(SEED)
+    print("# Corpus SINTÉTICO do TCS34725 (tools/gen_cor_corpus.py, semente %d)" % SEED)
+    print("luz,fase,rotulo,c,r,g,b,gain,integ_ms")
+    for light in LIGHTS:
+        for band in BANDS:
+            plan = [("teste", N_OTHER)] if band.startswith("outro") else [("cal", N_CAL), ("teste", N_TEST)]
+            for fase, n in plan:
+                for _ in range(n):
+                    c, r, g, b, gain, ms = reading(rng, light, band, fase == "cal")
+                    print("%s,%s,%s,%d,%d,%d,%d,%d,%d" % (light, fase, band, c, r, g, b, gain, ms))
+
+
+if __name__ == "__main__":
+    main()
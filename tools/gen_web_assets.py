@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""Gera web_assets.c/.h a partir das páginas em web/.
+
+Para cada página .html:
+  - inline de <link rel=stylesheet href=X.css> e <script src=X.js></script>;
+  - minificação de HTML/CSS/JS (conservadora, sem dependências externas);
+  - gzip -9 determinístico (mtime=0);
+  - resposta HTTP completa (cabeçalho + corpo) em duas versões, crua e gzip,
+    emitidas como arrays const (ficam na flash/XIP);
+  - ETag fraco (CRC-32 do HTML minificado) e o 304 correspondente: o navegador
+    revalida a cada carga (no-cache) e só baixa de novo após regravar a flash.
+
+Uso: gen_web_assets.py --src web --out build/generated/web pro.html display.html ...
+"""
+import argparse
+import gzip
+import os
+import re
+import sys
+import zlib
+
+IDENT = re.compile(r"[A-Za-z0-9_$]")
+
+HTTP_HEADER = (
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: {ctype}\r\n"
+    "Cache-Control: no-cache\r\n"
+    "ETag: {etag}\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "{encoding}"
+    "Content-Length: {length}\r\n"
+)
+HTTP_304 = (
+    "HTTP/1.1 304 Not Modified\r\n"
+    "Cache-Control: no-cache\r\n"
+    "ETag: {etag}\r\n"
+    "Vary: Accept-Encoding\r\n"
+)
+# Sem "Connection" nem linha em branco final: o servidor acrescenta "\r\n"
+# (keep-alive) ou "Connection: close\r\n\r\n" conforme a requisição.
+
+
+def minify_css(src):
+    src = re.sub(r"/\*.*?\*/", "", src, flags=re.S)
+    src = re.sub(r"\s+", " ", src)
+    src = re.sub(r"\s*([{};,>])\s*", r"\1", src)
+    src = re.sub(r"\s*:\s*(?=[^{}]*;|[^{}]*})", ":", src)
+    src = src.replace(";}", "}")
+    return src.strip()
+
+
+def minify_js(src):
+    """Remove comentários e espaços respeitando strings, templates e regex."""
+    out = []
+    i, n = 0, len(src)
+    pending_ws = ""          # espaço em branco acumulado desde o último token
+    last = ""                # último caractere significativo emitido
+    regex_ok = True          # '/' nesta posição inicia regex?
+
+    def flush_ws(nxt):
+        nonlocal pending_ws
+        if not pending_ws or not out:
+            pending_ws = ""
+            return
+        a = last
+        if IDENT.match(a) and IDENT.match(nxt):
+            out.append("\n" if "\n" in pending_ws else " ")
+        elif a in "+-" and nxt in "+-":
+            out.append(" ")
+        elif "\n" in pending_ws and a not in "{;,(=:[+-*/&|?!<>" and nxt not in "})];,.:?=&|+-*/<>":
+            out.append("\n")       # preserva fronteiras que dependem de ASI
+        pending_ws = ""
+
+    while i < n:
+        c = src[i]
+        if c in " \t\r\n":
+            pending_ws += c
+            i += 1
+            continue
+        if src.startswith("//", i):
+            j = src.find("\n", i)
+            i = n if j < 0 else j
+            continue
+        if src.startswith("/*", i):
+            j = src.find("*/", i + 2)
+            i = n if j < 0 else j + 2
+            continue
+        flush_ws(c)
+        if c in "'\"`":
+            j = i + 1
+            while j < n and src[j] != c:
+                j += 2 if src[j] == "\\" else 1
+            out.append(src[i:j + 1])
+            i = j + 1
+            last, regex_ok = c, False
+            continue
+        if c == "/" and regex_ok:
+            j, in_class = i + 1, False
+            while j < n:
+                if src[j] == "\\":
+                    j += 2
+                    continue
+                if src[j] == "[":
+                    in_class = True
+                elif src[j] == "]":
+                    in_class = False
+                elif src[j] == "/" and not in_class:
+                    break
+                j += 1
+            j += 1
+            while j < n and IDENT.match(src[j]):
+                j += 1          # flags
+            out.append(src[i:j])
+            i = j
+            last, regex_ok = "/", False
+            continue
+        if IDENT.match(c):
+            j = i
+            while j < n and IDENT.match(src[j]):
+                j += 1
+            word = src[i:j]
+            out.append(word)
+            i = j
+            last = word[-1]
+            regex_ok = word in ("return", "typeof", "case", "do", "else", "in", "of")
+            continue
+        out.append(c)
+        i += 1
+        last = c
+        regex_ok = c not in ")]}"
+    return "".join(out)
+
+
+def minify_html(src):
+    src = re.sub(r"<!--.*?-->", "", src, flags=re.S)
+    src = re.sub(r">\s*\n\s*<", "><", src)
+    src = re.sub(r"\s*\n\s*", " ", src)
+    return src.strip()
+
+
+def inline_assets(html, src_dir, deps):
+    def css(m):
+        path = os.path.join(src_dir, m.group(1))
+        deps.append(path)
+        with open(path, encoding="utf-8") as f:
+            return "<style>" + minify_css(f.read()) + "</style>"
+
+    def js(m):
+        path = os.path.join(src_dir, m.group(1))
+        deps.append(path)
+        with open(path, encoding="utf-8") as f:
+            return "<script>" + minify_js(f.read()) + "</script>"
+
+    html = re.sub(r"<link rel=stylesheet href=([\w.-]+\.css)>", css, html)
+    html = re.sub(r"<script src=([\w.-]+\.js)></script>", js, html)
+    return html
+
+
+def c_string(name, text):
+    lines = text.replace("\\", "\\\\").replace('"', '\\"').split("\r\n")
+    if not lines[-1]:
+        lines.pop()
+    body = "\n".join('    "%s\\r\\n"' % ln for ln in lines)
+    return "static const char %s[] =\n%s;\n" % (name, body)
+
+
+def c_array(name, data):
+    lines = []
+    for k in range(0, len(data), 16):
+        lines.append("    " + ",".join("0x%02x" % b for b in data[k:k + 16]) + ",")
+    return "static const uint8_t %s[%d] = {\n%s\n};\n" % (name, len(data), "\n".join(lines))
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--src", required=True)
+    ap.add_argument("--out", required=True)
+    ap.add_argument("pages", nargs="+")
+    args = ap.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    c_parts = [
+        "// Gerado por tools/gen_web_assets.py a partir de web/ -- NAO EDITE.\n",
+        '#include "web_assets.h"\n\n',
+    ]
+    h_parts = [
+        "// Gerado por tools/gen_web_assets.py a partir de web/ -- NAO EDITE.\n",
+        "#pragma once\n#include <stdint.h>\n\n",
+        "// Resposta HTTP em flash: cabeçalho (sem Connection nem linha em branco\n",
+        "// final) e corpo separados, para o servidor escolher keep-alive/close.\n",
+        "typedef struct {\n",
+        "    const char    *hdr;  uint16_t hdr_len;\n",
+        "    const uint8_t *body; uint16_t body_len;\n",
+        "} web_resp_t;\n\n",
+        "// Cada página em duas versões (crua e gzip), o 304 para revalidação\n",
+        "// e o ETag (fraco, o mesmo para as duas codificações).\n",
+        "typedef struct { web_resp_t raw, gz, not_modified; const char *etag; } web_asset_t;\n\n",
+    ]
+
+    tot_src = tot_min = tot_gz = 0
+    for page in args.pages:
+        ident = re.sub(r"\W", "_", os.path.splitext(page)[0])
+        deps = [os.path.join(args.src, page)]
+        with open(deps[0], encoding="utf-8") as f:
+            html = minify_html(f.read())
+        html = inline_assets(html, args.src, deps)
+
+        body = html.encode("utf-8")
+        body_gz = gzip.compress(body, compresslevel=9, mtime=0)
+        src_len = sum(os.path.getsize(p) for p in deps)
+
+        ctype = "text/html; charset=UTF-8"
+        etag = 'W/"%08x"' % zlib.crc32(body)
+        hdr_raw = HTTP_HEADER.format(ctype=ctype, etag=etag, encoding="", length=len(body))
+        hdr_gz = HTTP_HEADER.format(ctype=ctype, etag=etag, encoding="Content-Encoding: gzip\r\n",
+                                    length=len(body_gz))
+        hdr_304 = HTTP_304.format(etag=etag)
+        if len(body) > 0xFFFF:
+            sys.exit("gen_web_assets: %s excede 64 KiB" % page)
+
+        c_parts.append(c_string("k_%s_raw_hdr" % ident, hdr_raw))
+        c_parts.append(c_array("k_%s_raw" % ident, body))
+        c_parts.append(c_string("k_%s_gz_hdr" % ident, hdr_gz))
+        c_parts.append(c_array("k_%s_gz" % ident, body_gz))
+        c_parts.append(c_string("k_%s_304_hdr" % ident, hdr_304))
+        c_parts.append("const web_asset_t web_asset_%s = {\n"
+                       "    { k_%s_raw_hdr, %d, k_%s_raw, %d },\n"
+                       "    { k_%s_gz_hdr, %d, k_%s_gz, %d },\n"
+                       "    { k_%s_304_hdr, %d, (const uint8_t *)\"\", 0 },\n"
+                       "    \"%s\",\n"
+                       "};\n\n"
+                       % (ident, ident, len(hdr_raw), ident, len(body),
+                          ident, len(hdr_gz), ident, len(body_gz),
+                          ident, len(hdr_304), etag.replace('"', '\\"')))
+        h_parts.append("extern const web_asset_t web_asset_%s;\n" % ident)
+
+        tot_src += src_len
+        tot_min += len(body)
+        tot_gz += len(body_gz)
+        print("web: %-20s fonte %6d B -> min %6d B -> gzip %5d B (%.1fx)"
+              % (page, src_len, len(body), len(body_gz), src_len / len(body_gz)))
+
+    print("web: total                fonte %6d B -> min %6d B -> gzip %5d B (%.1fx, -%d B por carga)"
+          % (tot_src, tot_min, tot_gz, tot_src / tot_gz, tot_min - tot_gz))
+
+    with open(os.path.join(args.out, "web_assets.c"), "w", encoding="utf-8") as f:
+        f.write("".join(c_parts))
+    with open(os.path.join(args.out, "web_assets.h"), "w", encoding="utf-8") as f:
+        f.write("".join(h_parts))
+
+
+if __name__ == "__main__":
+    main()
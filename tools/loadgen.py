@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+Gerador de carga para o servidor web (placa ou build host em host/).
+
+Simula N celulares, cada um numa thread com conexão keep-alive própria,
+fazendo o que as páginas fazem em modo polling:
+  pro      GET /            e depois /stats.bin a cada 1 s
+  display  GET /display     e depois /survey_state.json + /fb.bin?v=N a cada 0,5 s
+           (/oled.json se a placa não tem framebuffer)
+  survey   GET /survey      e depois POST /survey_submit a cada --survey-every s
+Um 503 pausa o celular pelo Retry-After, como o pro.js/display.js.
+
+No fim imprime, por endpoint: requisições/s, p50/p99 de latência, 503 e
+erros de conexão; e, lendo /metrics.json antes e depois, quantas alocações
+falharam em cada pool do lwIP (esgotamento) e o que a admissão recusou.
+
+Uso:
+  python3 tools/loadgen.py --host 192.168.4.1 --phones 20 --duration 60
+  python3 tools/loadgen.py --mix pro=1,display=8,survey=3
+"""
+import argparse
+import http.client
+import json
+import random
+import threading
+import time
+from collections import defaultdict
+
+PROFILES = ("pro", "display", "survey")
+
+
+class Phone(threading.Thread):
+    def __init__(self, idx, kind, args, stop):
+        super().__init__(daemon=True)
+        self.idx, self.kind, self.args, self.stop = idx, kind, args, stop
+        self.samples = []            # (endpoint, status, segundos)
+        self.conn = None
+        self.hold_until = 0.0
+        self.body = b""
+
+    def request(self, method, path, body=None):
+        endpoint = path.split("?", 1)[0]
+        if time.monotonic() < self.hold_until:
+            return None
+        headers = {"Accept-Encoding": "gzip"}
+        if body is not None:
+            headers["Content-Type"] = "application/x-www-form-urlencoded"
+        t0 = time.monotonic()
+        try:
+            if self.conn is None:
+                self.conn = http.client.HTTPConnection(self.args.host, self.args.port,
+                                                       timeout=self.args.timeout)
+            self.conn.request(method, path, body=body, headers=headers)
+            r = self.conn.getresponse()
+            self.body = r.read()
+            status = r.status
+            if status == 503:
+                self.hold_until = time.monotonic() + float(r.getheader("Retry-After") or 1)
+            if r.will_close:
+                self.conn.close()
+                self.conn = None
+        except (OSError, http.client.HTTPException):
+            status = 0               # conexão recusada/resetada/timeout
+            if self.conn is not None:
+                self.conn.close()
+            self.conn = None
+        self.samples.append((endpoint, status, time.monotonic() - t0))
+        return status
+
+    def sleep(self, s):
+        self.stop.wait(s * random.uniform(0.9, 1.1))
+
+    def run(self):
+        self.sleep(random.uniform(0, 1))     # celulares não chegam juntos
+        if self.kind == "pro":
+            self.request("GET", "/")
+            while not self.stop.is_set():
+                self.request("GET", "/stats.bin?t=%d" % int(time.time() * 1000))
+                self.sleep(1.0)
+        elif self.kind == "display":
+            self.request("GET", "/display")
+            fb_ver, fb_on = 0, True
+            while not self.stop.is_set():
+                t = int(time.time() * 1000)
+                self.request("GET", "/survey_state.json?t=%d" % t)
+                if fb_on:
+                    st = self.request("GET", "/fb.bin?v=%d" % fb_ver)
+                    if st == 200 and self.body[:2] == b"FB":
+                        fb_ver = int.from_bytes(self.body[6:10], "little")
+                    fb_on = st != 404
+                else:
+                    self.request("GET", "/oled.json?t=%d" % t)
+                self.sleep(0.5)
+        else:
+            while not self.stop.is_set():
+                self.request("GET", "/survey")
+                bits = "".join(random.choice("01") for _ in range(10))
+                self.request("POST", "/survey_submit", body="ans=" + bits)
+                self.sleep(self.args.survey_every)
+        if self.conn is not None:
+            self.conn.close()
+
+
+def fetch_metrics(args):
+    try:
+        c = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+        c.request("GET", "/metrics.json")
+        d = json.loads(c.getresponse().read())
+        c.close()
+        return d
+    except (OSError, http.client.HTTPException, ValueError):
+        return None
+
+
+def pct(sorted_vals, p):
+    if not sorted_vals:
+        return float("nan")
+    k = min(len(sorted_vals) - 1, int(round(p / 100.0 * (len(sorted_vals) - 1))))
+    return sorted_vals[k]
+
+
+def parse_mix(s):
+    mix = {}
+    for part in s.split(","):
+        name, _, w = part.partition("=")
+        if name not in PROFILES:
+            raise SystemExit("perfil desconhecido: %s (use %s)" % (name, ", ".join(PROFILES)))
+        mix[name] = float(w or 1)
+    return mix
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--phones", type=int, default=10)
+    ap.add_argument("--duration", type=float, default=30.0, help="segundos")
+    ap.add_argument("--mix", default="pro=2,display=6,survey=2", help="pesos por perfil")
+    ap.add_argument("--survey-every", type=float, default=10.0, help="segundos entre envios")
+    ap.add_argument("--timeout", type=float, default=5.0)
+    ap.add_argument("--seed", type=int, default=None)
+    args = ap.parse_args()
+    random.seed(args.seed)
+
+    mix = parse_mix(args.mix)
+    kinds = random.choices(list(mix), weights=list(mix.values()), k=args.phones)
+    before = fetch_metrics(args)
+
+    stop = threading.Event()
+    phones = [Phone(i, k, args, stop) for i, k in enumerate(kinds)]
+    t0 = time.monotonic()
+    for p in phones:
+        p.start()
+    try:
+        stop.wait(args.duration)
+    except KeyboardInterrupt:
+        pass
+    stop.set()
+    for p in phones:
+        p.join(args.timeout + 1)
+    elapsed = time.monotonic() - t0
+    after = fetch_metrics(args)
+
+    by_ep = defaultdict(list)
+    for p in phones:
+        for ep, st, dt in p.samples:
+            by_ep[ep].append((st, dt))
+
+    print("%d celulares (%s) por %.1f s em %s:%d" % (
+        args.phones, ", ".join("%s=%d" % (k, kinds.count(k)) for k in PROFILES if k in kinds),
+        elapsed, args.host, args.port))
+    print("%-20s %7s %8s %9s %9s %6s %6s" % ("endpoint", "n", "req/s", "p50 ms", "p99 ms", "503", "erro"))
+    total = 0
+    for ep in sorted(by_ep):
+        rows = by_ep[ep]
+        ok = sorted(dt * 1000 for st, dt in rows if st and st != 503)
+        n503 = sum(1 for st, _ in rows if st == 503)
+        nerr = sum(1 for st, _ in rows if st == 0 or st >= 500 and st != 503)
+        total += len(rows)
+        print("%-20s %7d %8.1f %9.1f %9.1f %6d %6d" % (
+            ep, len(rows), len(rows) / elapsed, pct(ok, 50), pct(ok, 99), n503, nerr))
+    print("%-20s %7d %8.1f" % ("total", total, total / elapsed))
+
+    if not (before and after):
+        print("(sem /metrics.json: esgotamento de pools não medido)")
+        return
+    print("\nlwIP: falhas de alocação durante o teste (pico de uso / total)")
+    for pool, a in sorted(after.get("lwip", {}).items()):
+        b = before.get("lwip", {}).get(pool, {})
+        print("  %-16s err +%-6d max %d/%d" % (pool, a["err"] - b.get("err", 0), a["max"], a["avail"]))
+    print("servidor:")
+    for k, v in sorted(after.get("http", {}).items()):
+        d = v - before.get("http", {}).get(k, 0)
+        if d:
+            print("  %-30s +%d" % (k, d))
+
+
+if __name__ == "__main__":
+    main()
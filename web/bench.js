@@ -0,0 +1,79 @@
+// Teste de vazão: /bench/down e /bench/up em rodadas, lado a lado com o que o
+// servidor mediu (/bench.json). O resumo usa a mediana das rodadas.
+const rows = document.getElementById('rows');
+const sum = document.getElementById('sum');
+
+function kbps(bytes, ms) { return ms > 0 ? Math.round(bytes * 8 / ms) : 0; }
+function median(a) { const s = a.slice().sort((x, y) => x - y); return s.length ? s[s.length >> 1] : 0; }
+
+async function down(n) {
+  const t0 = performance.now();
+  const r = await fetch('/bench/down?bytes=' + n + '&t=' + Date.now(), { cache: 'no-store' });
+  if (!r.ok) throw new Error('HTTP ' + r.status);
+  let got = 0;
+  if (r.body && r.body.getReader) {
+    const rd = r.body.getReader();
+    for (;;) {
+      const x = await rd.read();
+      if (x.done) break;
+      got += x.value.length;
+    }
+  } else {
+    got = (await r.arrayBuffer()).byteLength;
+  }
+  const ms = performance.now() - t0;
+  // O último ACK chega ao servidor logo depois do fim da leitura
+  await new Promise(ok => setTimeout(ok, 300));
+  const srv = await (await fetch('/bench.json?t=' + Date.now(), { cache: 'no-store' })).json();
+  return { bytes: got, ms: ms, srv: srv.down };
+}
+
+async function up(n) {
+  const body = new Uint8Array(n);
+  const t0 = performance.now();
+  const r = await fetch('/bench/up', {
+    method: 'POST', body: body, cache: 'no-store',
+    headers: { 'Content-Type': 'application/octet-stream' }
+  });
+  if (!r.ok) throw new Error('HTTP ' + r.status);
+  const srv = await r.json();
+  return { bytes: n, ms: performance.now() - t0, srv: srv.up };
+}
+
+function addRow(i, dir, res) {
+  const s = res.srv || {};
+  const tr = document.createElement('tr');
+  const cells = [i, dir, kbps(res.bytes, res.ms), s.kbps || 0, s.stalls || 0, s.rexmit || 0];
+  for (let k = 0; k < cells.length; k++) {
+    const td = document.createElement('td');
+    td.textContent = cells[k];
+    if (k === 5 && s.rexmit > 0) td.className = 'bad';
+    tr.appendChild(td);
+  }
+  if (!s.done) tr.title = 'servidor não confirmou o fim do teste';
+  rows.appendChild(tr);
+}
+
+async function run() {
+  const n = parseInt(document.getElementById('size').value, 10);
+  const rounds = parseInt(document.getElementById('rounds').value, 10);
+  const go = document.getElementById('go');
+  const d = [], u = [];
+  go.disabled = true;
+  rows.innerHTML = '';
+  sum.textContent = 'Medindo...';
+  try {
+    for (let i = 1; i <= rounds; i++) {
+      const a = await down(n);
+      addRow(i, 'baixar', a);
+      d.push(a.srv ? a.srv.kbps : kbps(a.bytes, a.ms));
+      const b = await up(n);
+      addRow(i, 'enviar', b);
+      u.push(b.srv ? b.srv.kbps : kbps(b.bytes, b.ms));
+    }
+    sum.textContent = 'Mediana: baixar ' + median(d) + ' kbit/s, enviar ' + median(u) + ' kbit/s';
+  } catch (e) {
+    sum.textContent = 'Falhou: ' + e.message;
+  }
+  go.disabled = false;
+}
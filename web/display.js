@@ -0,0 +1,133 @@
+// Espelho do OLED: o quadro de verdade vem de /fb.bin num canvas (só o que
+// mudou desde a versão que já temos; 304 se nada). Sem OLED na placa (404),
+// mostra as linhas de /oled.json. O aviso de mudança e o modo survey chegam
+// por /events (SSE); sem SSE, consulta a cada 500 ms. Pula para /survey
+// quando o modo abre.
+function fs() { const d = document.documentElement; if (d.requestFullscreen) d.requestFullscreen(); }
+let last = ['', '', '', ''];
+let jumped = false;
+
+function esc(t) { return (t || '').replace(/&/g, '&amp;').replace(/</g, '&lt;').replace(/>/g, '&gt;'); }
+
+function colorize(t) {
+  let x = esc(t || '');
+  x = x.replace(/\b(verde|amarelo|amarela|vermelho|vermelha)\b/gi, m => {
+    const k = m.toLowerCase();
+    if (k === 'verde') return '<span class="tag green">' + m + '</span>';
+    if (k === 'amarelo' || k === 'amarela') return '<span class="tag yellow">' + m + '</span>';
+    if (k === 'vermelho' || k === 'vermelha') return '<span class="tag red">' + m + '</span>';
+    return m;
+  });
+  return x;
+}
+
+function survey(st) {
+  if (!jumped && st.mode) { jumped = true; location.replace('/survey?t=' + Date.now()); return true; }
+  return false;
+}
+
+function show(s) {
+  const arr = [s.l1 || '', s.l2 || '', s.l3 || '', s.l4 || ''];
+  for (let i = 0; i < 4; i++) {
+    if (arr[i] !== last[i]) {
+      last[i] = arr[i];
+      const el = document.getElementById('l' + (i + 1));
+      el.classList.remove('fade');
+      el.innerHTML = colorize(arr[i]) || '&nbsp;';
+      void el.offsetWidth;
+      el.classList.add('fade');
+    }
+  }
+}
+
+// 503 do servidor (limite por cliente): pausa o polling pelo Retry-After
+let holdUntil = 0;
+function getJson(url) {
+  return fetch(url + '?t=' + Date.now(), { cache: 'no-store' }).then(r => {
+    if (r.status === 503) {
+      holdUntil = Date.now() + 1000 * (parseInt(r.headers.get('Retry-After'), 10) || 1);
+      throw new Error('503');
+    }
+    return r.json();
+  });
+}
+
+// Framebuffer (formato em web_ap.c): cabeçalho 'FB', tipo, páginas,
+// largura, versão; depois tokens 0x80|k = pula k+1 bytes, k = k+1 literais
+const fbCanvas = document.getElementById('fb');
+const fbCtx = fbCanvas.getContext('2d');
+let fbImg = null, fb = null, fbVer = 0;
+let fbOn = true, fbBusy = false, fbAgain = false;
+
+function fbShow(on) {
+  fbCanvas.hidden = !on;
+  document.getElementById('lines').hidden = on;
+}
+
+function fbApply(buf) {
+  const d = new Uint8Array(buf);
+  if (d.length < 10 || d[0] !== 70 || d[1] !== 66) throw new Error('fb.bin');
+  const pages = d[3], w = d[4] | d[5] << 8, h = pages * 8;
+  if (!fb || fb.length !== pages * w) { fb = new Uint8Array(pages * w); fbImg = null; }
+  if (d[2] === 0) fb.fill(0);
+  for (let i = 10, o = 0; i < d.length && o < fb.length;) {
+    const t = d[i++];
+    if (t & 0x80) { o += (t & 0x7f) + 1; continue; }
+    fb.set(d.subarray(i, i + t + 1), o);
+    i += t + 1; o += t + 1;
+  }
+  fbVer = (d[6] | d[7] << 8 | d[8] << 16 | d[9] << 24) >>> 0;
+  if (!fbImg) { fbCanvas.width = w; fbCanvas.height = h; fbImg = fbCtx.createImageData(w, h); }
+  const px = fbImg.data;
+  for (let y = 0, k = 0; y < h; y++) {
+    const row = (y >> 3) * w, bit = y & 7;
+    for (let x = 0; x < w; x++, k += 4) {
+      const on = fb[row + x] >> bit & 1;
+      px[k] = on ? 232 : 0; px[k + 1] = on ? 240 : 0; px[k + 2] = on ? 255 : 0; px[k + 3] = 255;
+    }
+  }
+  fbCtx.putImageData(fbImg, 0, 0);
+}
+
+// Resolve false se não há framebuffer (use o texto). Um pedido por vez:
+// aviso que chega no meio vira mais uma volta no fim.
+function fbFetch() {
+  if (!fbOn) return Promise.resolve(false);
+  if (fbBusy) { fbAgain = true; return Promise.resolve(true); }
+  fbBusy = true;
+  return fetch('/fb.bin?v=' + fbVer, { cache: 'no-store' }).then(r => {
+    if (r.status === 304) return true;
+    if (r.status === 404) { fbOn = false; fbShow(false); return false; }
+    if (r.status === 503) {
+      const s = parseInt(r.headers.get('Retry-After'), 10) || 1;
+      holdUntil = Date.now() + 1000 * s;
+      if (!poll) setTimeout(fbFetch, 1000 * s);
+      return true;
+    }
+    if (!r.ok) throw new Error(r.status);
+    return r.arrayBuffer().then(b => { fbApply(b); fbShow(true); return true; });
+  }).catch(() => { fbVer = 0; return true; })   // placa pode ter reiniciado: quadro inteiro
+    .finally(() => { fbBusy = false; if (fbAgain) { fbAgain = false; fbFetch(); } });
+}
+
+async function tick() {
+  if (Date.now() < holdUntil) return;
+  try {
+    const st = await getJson('/survey_state.json').catch(() => ({ mode: 0 }));
+    if (Date.now() < holdUntil || survey(st)) return;
+    if (!(await fbFetch())) show(await getJson('/oled.json'));
+  } catch (e) {}
+}
+
+let poll = null;
+function startPoll() { if (!poll) { poll = setInterval(tick, 500); tick(); } }
+
+if (window.EventSource) {
+  const es = new EventSource('/events?oled&survey');
+  es.onopen = () => { if (poll) { clearInterval(poll); poll = null; } fbFetch(); };
+  es.addEventListener('survey', e => { try { if (survey(JSON.parse(e.data))) es.close(); } catch (x) {} });
+  es.addEventListener('oled', e => { try { show(JSON.parse(e.data)); } catch (x) {} fbFetch(); });
+  es.onerror = () => { fbVer = 0; if (es.readyState === 2) startPoll(); };
+} else {
+  startPoll();
+}
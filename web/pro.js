@@ -0,0 +1,251 @@
+// Painel do profissional: recebe /stats.json por /events (SSE); sem SSE, consulta
+// /stats.bin (128 B fixos contra ~470 B de JSON) a cada 1 s
+let hist = [];
+const maxPts = 180;
+let flt = 'all';
+const Cb = document.getElementById('chartBpm').getContext('2d');
+const Cc = document.getElementById('chartCores').getContext('2d');
+const Cq = document.getElementById('chartQs').getContext('2d');
+
+function drawLine(ctx, arr) {
+  const w = ctx.canvas.clientWidth, h = ctx.canvas.clientHeight;
+  ctx.canvas.width = w; ctx.canvas.height = h;
+  ctx.clearRect(0, 0, w, h);
+  if (arr.length < 2) return;
+  let mn = 200, mx = 40;
+  for (const v of arr) { if (v > 0) { mn = Math.min(mn, v); mx = Math.max(mx, v); } }
+  if (!isFinite(mn) || !isFinite(mx)) return;
+  if (mx - mn < 5) { mn = Math.max(20, mn - 3); mx = mn + 5; }
+  ctx.beginPath();
+  for (let i = 0; i < arr.length; i++) {
+    const v = arr[i];
+    if (v <= 0) continue;
+    const x = i * (w - 8) / (arr.length - 1) + 4;
+    const y = h - 4 - (v - mn) / (mx - mn) * (h - 8);
+    i ? ctx.lineTo(x, y) : ctx.moveTo(x, y);
+  }
+  ctx.stroke();
+}
+
+function drawBars(ctx, data, labels) {
+  const w = ctx.canvas.clientWidth, h = ctx.canvas.clientHeight;
+  ctx.canvas.width = w; ctx.canvas.height = h;
+  ctx.clearRect(0, 0, w, h);
+  const n = data.length;
+  const bw = Math.min(60, (w - 40) / n);
+  const gap = (w - n * bw) / (n + 1);
+  let x = gap;
+  const M = Math.max(...data, 1);
+  ctx.font = '12px system-ui';
+  for (let i = 0; i < n; i++) {
+    const v = data[i];
+    const y = h - 22;
+    const bh = (v / M) * (h - 50);
+    ctx.fillRect(x, y - bh, bw, bh);
+    ctx.fillText(labels[i], x, y + 14);
+    ctx.fillText(String(v.toFixed ? Math.round(v) : v), x + bw / 2 - 8, y - bh - 6);
+    x += bw + gap;
+  }
+}
+
+function lastDots(bits) {
+  const el = document.getElementById('lastList');
+  el.innerHTML = '';
+  for (let i = 0; i < 10; i++) {
+    const on = ((bits >> i) & 1) !== 0;
+    const d = document.createElement('div');
+    d.className = 'dot';
+    d.textContent = on ? '●' : '○';
+    el.appendChild(d);
+  }
+}
+
+function sel(c) {
+  flt = c;
+  document.querySelectorAll('.chip').forEach(el => el.classList.toggle('active', el.dataset.c === c));
+  hist = [];
+  connect();
+}
+document.getElementById('chips').addEventListener('click', e => {
+  const el = e.target.closest('.chip');
+  if (!el) return;
+  sel(el.dataset.c);
+});
+
+function fltLabel() {
+  if (flt === 'verde') return 'Apenas Grupo Verde';
+  if (flt === 'amarelo') return 'Apenas Grupo Amarelo';
+  if (flt === 'vermelho') return 'Apenas Grupo Vermelho';
+  return 'Todos os grupos';
+}
+
+function isFiniteNum(v) { return typeof v === 'number' && Number.isFinite(v); }
+
+function $(id) { return document.getElementById(id); }
+
+// /stats.bin v1 (layout em src/web_ap.c) -> mesmo objeto que o /stats.json
+function decodeStats(buf) {
+  const d = new DataView(buf);
+  if (d.byteLength < 128 || d.getUint8(0) !== 1) throw new Error('stats.bin');
+  const u = o => d.getUint32(o, true), f = o => d.getFloat32(o, true);
+  const yes = [];
+  for (let i = 0; i < 10; i++) yes.push(u(84 + 4 * i));
+  const n = u(80);
+  const sum = yes.reduce((a, b) => a + b, 0);
+  return {
+    bpm_live: f(8), bpm_mean: f(12), bpm_n: u(16), bpm_last: f(20), bpm_stddev: f(24),
+    cores: { verde: u(28), amarelo: u(32), vermelho: u(36) },
+    checkins_total: u(40),
+    wellbeing_index: f(68), calm_index: f(72), engagement_rate: f(76),
+    survey: {
+      n, yes,
+      rate: yes.map(y => n ? y / n : 0),
+      avg_yes: n ? sum / n : 0,
+      last_bits: d.getUint16(124, true),
+      alerts: { crisis: yes[4], avoid: yes[5], talk: yes[6] },
+      basic: { no_meal: Math.max(0, n - yes[7]), poor_sleep: Math.max(0, n - yes[0]) }
+    }
+  };
+}
+
+// 503 do servidor (limite por cliente): pausa o polling pelo Retry-After
+let holdUntil = 0;
+function backoff(r) {
+  if (r.status !== 503) return false;
+  holdUntil = Date.now() + 1000 * (parseInt(r.headers.get('Retry-After'), 10) || 1);
+  return true;
+}
+
+async function tick() {
+  if (Date.now() < holdUntil) return;
+  try {
+    let url = '/stats.bin?t=' + Date.now();
+    if (flt !== 'all') { url += '&color=' + flt; }
+    const r = await fetch(url, { cache: 'no-store' });
+    if (backoff(r)) return;
+    render(decodeStats(await r.arrayBuffer()));
+  } catch (e) {}
+}
+
+function render(s) {
+  try {
+    $('fltDesc').textContent = fltLabel();
+
+    const live = (isFiniteNum(s.bpm_live) && s.bpm_live >= 20 && s.bpm_live <= 250) ? s.bpm_live : 0;
+    const last = isFiniteNum(s.bpm_last) ? s.bpm_last : 0;
+    const mean = isFiniteNum(s.bpm_mean) ? s.bpm_mean : 0;
+    let headline = 0;
+    if (live) headline = live;
+    else if (last) headline = last;
+    else if (mean) headline = mean;
+    $('kpiBpm').textContent = headline ? headline.toFixed(1) : '--';
+    $('kpiBpmLast').textContent = last ? ('Último: ' + Math.round(last) + ' bpm') : 'Último: --';
+
+    const bpmStd = isFiniteNum(s.bpm_stddev) ? s.bpm_stddev : NaN;
+    $('kpiBpmStd').textContent = isFiniteNum(bpmStd) ? (bpmStd.toFixed(1) + ' bpm') : '--';
+    const engagement = isFiniteNum(s.engagement_rate) ? s.engagement_rate : NaN;
+    const wellness = isFiniteNum(s.wellbeing_index) ? s.wellbeing_index : NaN;
+    $('kpiWellness').textContent = isFiniteNum(wellness) ? Math.round(wellness) + '%' : '--';
+    const calm = isFiniteNum(s.calm_index) ? s.calm_index : NaN;
+    $('kpiCalm').textContent = isFiniteNum(calm) ? Math.round(calm) + '%' : '--';
+    const checkins = isFiniteNum(s.checkins_total) ? s.checkins_total : 0;
+
+    const plotted = headline;
+    if (plotted) { hist.push(plotted); if (hist.length > maxPts) hist.shift(); }
+    drawLine(Cb, hist);
+    drawBars(Cc, [s.cores.verde || 0, s.cores.amarelo || 0, s.cores.vermelho || 0], ['Verde', 'Amarelo', 'Vermelho']);
+
+    const sv = s.survey || {};
+    const n = sv.n || 0;
+    const rate = sv.rate || [];
+    const avg = sv.avg_yes || 0;
+    $('kpiN').textContent = String(checkins);
+    $('kpiAvgYes').textContent = n ? ((Math.round(avg * 100) / 100).toFixed(2)) : '--';
+    $('kpiSurveyCount').textContent = 'Respostas: ' + n;
+
+    let engageText = 'Engajamento: --';
+    if (checkins > 0 && isFiniteNum(engagement)) {
+      const pct = Math.round(engagement * 100);
+      const answered = Math.min(n, checkins);
+      engageText = 'Engajamento: ' + answered + '/' + checkins + ' (' + pct + '%)';
+    } else if (checkins > 0) {
+      engageText = 'Engajamento: 0/' + checkins + ' (0%)';
+    }
+    $('kpiEngagement').textContent = engageText;
+
+    $('alCrisis').textContent = String(sv.alerts ? sv.alerts.crisis || 0 : 0);
+    $('alAvoid').textContent = String(sv.alerts ? sv.alerts.avoid || 0 : 0);
+    $('alTalk').textContent = String(sv.alerts ? sv.alerts.talk || 0 : 0);
+    $('basicMeal').textContent = String(sv.basic ? sv.basic.no_meal || 0 : 0);
+    $('basicSleep').textContent = String(sv.basic ? sv.basic.poor_sleep || 0 : 0);
+
+    const perc = (rate || []).map(v => v * 100);
+    drawBars(Cq, perc, ['Q1', 'Q2', 'Q3', 'Q4', 'Q5', 'Q6', 'Q7', 'Q8', 'Q9', 'Q10']);
+    lastDots(sv.last_bits || 0);
+  } catch (e) {}
+}
+
+// Push via SSE; polling só enquanto o stream não está aberto (ou foi recusado)
+let es = null, poll = null;
+function startPoll() { if (!poll) { poll = setInterval(tick, 1000); tick(); } }
+function stopPoll() { if (poll) { clearInterval(poll); poll = null; } }
+
+function connect() {
+  if (es) { es.close(); es = null; }
+  if (!window.EventSource) { tick(); startPoll(); return; }
+  es = new EventSource('/events?stats' + (flt !== 'all' ? '&color=' + flt : ''));
+  es.onopen = stopPoll;
+  es.addEventListener('stats', e => { try { render(JSON.parse(e.data)); } catch (x) {} });
+  es.onerror = () => { if (es && es.readyState === 2) startPoll(); };
+}
+
+connect();
+
+// Onda PPG ao vivo por WebSocket (/ws); frame binário little-endian:
+// u8 versão | u8 qualidade (%) | u16 bpm x10 | u32 seq da 1ª amostra | int16 amostras[]
+const Cw = $('chartWave').getContext('2d');
+const wave = [];
+const waveMax = 250;        // 10 s a 25 Hz
+let waveSeq = -1;
+
+function drawWave() {
+  const w = Cw.canvas.clientWidth, h = Cw.canvas.clientHeight;
+  Cw.canvas.width = w; Cw.canvas.height = h;
+  Cw.clearRect(0, 0, w, h);
+  let mn = Infinity, mx = -Infinity;
+  for (const v of wave) { if (v !== null) { mn = Math.min(mn, v); mx = Math.max(mx, v); } }
+  if (!isFinite(mn) || mx - mn < 1) return;
+  Cw.beginPath();
+  let pen = false;
+  for (let i = 0; i < wave.length; i++) {
+    const v = wave[i];
+    if (v === null) { pen = false; continue; }
+    const x = i * (w - 8) / (waveMax - 1) + 4;
+    const y = h - 4 - (v - mn) / (mx - mn) * (h - 8);
+    pen ? Cw.lineTo(x, y) : Cw.moveTo(x, y);
+    pen = true;
+  }
+  Cw.stroke();
+}
+
+function openWs() {
+  if (!window.WebSocket) return;
+  const ws = new WebSocket('ws://' + location.host + '/ws');
+  ws.binaryType = 'arraybuffer';
+  ws.onmessage = e => {
+    const dv = new DataView(e.data);
+    if (dv.byteLength < 8 || dv.getUint8(0) !== 1) return;
+    const q = dv.getUint8(1), bpm = dv.getUint16(2, true) / 10, seq = dv.getUint32(4, true);
+    const n = (dv.byteLength - 8) >> 1;
+    if (n && waveSeq >= 0 && seq !== waveSeq) wave.push(null);   // amostras perdidas: quebra a linha
+    for (let i = 0; i < n; i++) wave.push(dv.getInt16(8 + 2 * i, true));
+    if (n) waveSeq = seq + n;
+    while (wave.length > waveMax) wave.shift();
+    $('kpiLive').textContent = bpm ? bpm.toFixed(1) : '--';
+    $('kpiQual').textContent = 'Qualidade: ' + (bpm ? q + '%' : '--');
+    if (n) drawWave();
+  };
+  ws.onclose = () => setTimeout(openWs, 3000);
+}
+
+openWs();
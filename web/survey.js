@@ -0,0 +1,32 @@
+// Questionário: 10 perguntas sim/não -> POST /survey_submit (ans=##########)
+const sel = new Array(10).fill(-1);
+
+document.querySelectorAll('.chip[data-i]').forEach(b => {
+  b.addEventListener('click', () => {
+    const i = Number(b.dataset.i), v = Number(b.dataset.v);
+    sel[i] = v;
+    const sib = b.parentElement.querySelectorAll('.chip');
+    sib.forEach(x => x.classList.remove('sel'));
+    b.classList.add('sel');
+  });
+});
+
+document.getElementById('back').addEventListener('click', e => {
+  e.preventDefault();
+  location.replace('/display?t=' + Date.now());
+});
+
+document.getElementById('send').addEventListener('click', async () => {
+  if (sel.some(v => v < 0)) { alert('Responda todas as perguntas.'); return; }
+  const bits = sel.map(v => v ? 1 : 0).join('');
+  try {
+    await fetch('/survey_submit', {
+      method: 'POST', redirect: 'manual', body: 'ans=' + bits,
+      headers: { 'Content-Type': 'application/x-www-form-urlencoded' }
+    });
+    location.replace('/display?t=' + Date.now());
+  } catch (e) {
+    // sem fetch/rede instável: envia pela URL (GET continua aceito)
+    location.replace('/survey_submit?ans=' + bits + '&t=' + Date.now());
+  }
+});